@@ -22,18 +22,18 @@ limitations under the License.
     // #include <assert.h>
     // #include <complex.h> // Optional ISO C header
     // #include <ctype.h>
-    // #include <errno.h>
+    #include <errno.h>
     #include <fenv.h>
     #include <float.h>
     #include <inttypes.h>
     // #include <iso646.h>
-    // #include <limits.h>
+    #include <limits.h>
     // #include <locale.h>
     #include <math.h>
     // #include <setjmp.h>
     // #include <signal.h>
     // #include <stdalign.h>
-    // #include <stdarg.h>
+    #include <stdarg.h>
     // #include <stdatomic.h> // Optional ISO C header
     #include <stdbool.h>
     // #include <stddef.h>
@@ -59,6 +59,63 @@ limitations under the License.
         #include <alloca.h>
     #endif
 
+    // Contains SIMD intrinsics, every kernel that uses them also has a portable fallback
+    #if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+        #define NPK_SSE2_
+        #include <emmintrin.h>
+    #endif
+
+    #if defined __AVX2__
+        #define NPK_AVX2_
+        #include <immintrin.h>
+    #endif
+
+    // Optional ISO C headers, the thread safety of the containers that need them is compiled out when they are missing
+    #if !defined __STDC_NO_THREADS__
+        #define NPK_THREADS_
+        #include <threads.h>
+    #endif
+
+    #if !defined __STDC_NO_ATOMICS__
+        #define NPK_ATOMICS_
+        #include <stdatomic.h>
+    #endif
+
+    // The thread pool needs both optional headers, without them every parallel operation runs on the calling thread
+    #if defined NPK_THREADS_ && defined NPK_ATOMICS_
+        #define NPK_PARALLEL_
+    #endif
+
+    // Contains the system calls used for file descriptors and memory mapped files
+    #if defined __unix__ || defined __APPLE__
+        #define NPK_POSIX_
+        #include <fcntl.h>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <sys/uio.h>
+        #include <unistd.h>
+    #elif defined _WIN32
+        #include <io.h>
+    #endif
+
+    // Contains the io_uring system calls, without them or when the kernel refuses them NPK_aio uses worker threads
+    #if defined __linux__ && defined __has_include
+        #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h>
+            #include <sys/syscall.h>
+        #endif
+    #endif
+
+    // IORING_OP_READ and IORING_OP_WRITE came with Linux 5.6, whose headers are the last ones without this feature bit
+    #if defined IORING_FEAT_FAST_POLL && defined __NR_io_uring_setup && defined _DEFAULT_SOURCE
+        #define NPK_IO_URING_
+    #endif
+
+    // Some SWAR kernels rely on the first byte in memory being the least significant one
+    #if (defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined _WIN32
+        #define NPK_LITTLE_ENDIAN_
+    #endif
+
     // =============
     // NPK INTERFACE
     // =============
@@ -121,8 +178,8 @@ limitations under the License.
     NPK_array NPK_file_read_new(const NPK_cstring *path);
 
     // Character handling macros
-    #define NPK_char_to_lower(c) (c + ' ')
-    #define NPK_char_to_upper(c) (c - ' ')
+    #define NPK_char_to_lower(c) (NPK_char_is_upper(c) ? (c) + ' ' : (c))
+    #define NPK_char_to_upper(c) (NPK_char_is_lower(c) ? (c) - ' ' : (c))
     #define NPK_char_is_lower(c) (c >= 'a' && c <= 'z')
     #define NPK_char_is_upper(c) (c >= 'A' && c <= 'Z')
     #define NPK_char_is_blank(c) (c == ' ' || c == '\f' || c == '\n' || c == '\r' || c == '\t' || c == '\v')
@@ -136,10 +193,22 @@ limitations under the License.
     // Allocates an array with "maxlen" initial elements
     #define NPK_array_sized_new(type, maxlen) NPK_array_sized_new_(NPK_sizeof_type(type), maxlen)
 
-    // Allocates a new array that is a deep copy of "arr"
+    // Allocates a new array that is a deep copy of "arr", with the same capacity but only the "len" elements copied
     #define NPK_array_copy_new(type, arr) NPK_array_copy_new_(NPK_sizeof_type(type), arr, 1)
     #define NPK_array_dim_copy_new(type, arr, dim) NPK_array_copy_new_(NPK_sizeof_type(type), arr, dim)
 
+    // Same as above, but every array of the copy has a capacity of exactly its length
+    #define NPK_array_fit_copy_new(type, arr) NPK_array_fit_copy_new_(NPK_sizeof_type(type), arr, 1)
+    #define NPK_array_dim_fit_copy_new(type, arr, dim) NPK_array_fit_copy_new_(NPK_sizeof_type(type), arr, dim)
+
+    // Allocates a deep copy of a nested array where all the arrays and elements share a single allocation
+    // Its arrays can be modified but must never grow or be deallocated one by one, the whole copy is freed by NPK_array_slab_del
+    #define NPK_array_dim_slab_copy_new(type, arr, dim) NPK_array_slab_copy_new_(NPK_sizeof_type(type), arr, dim)
+    #define NPK_array_slab_del(arr) free((arr)->data)
+
+    // Gives back the capacity beyond the length of the array, keeping room for at least one element
+    #define NPK_array_shrink_to_fit(type, arr) NPK_array_shrink_to_fit_(NPK_sizeof_type(type), arr)
+
     // Splits an array in parts, based on a "delim" delimiter
     #define NPK_array_split_new(type, arr, delim, eq) NPK_array_split_new_(NPK_sizeof_type(type), arr, NPK_rvalue_addr(type, delim), eq)
     #define NPK_array_dim_split_new(type, arr, delim, eq, dim) NPK_array_dim_split_new_(NPK_sizeof_type(type), arr, delim, eq, dim)
@@ -186,6 +255,59 @@ limitations under the License.
     #define NPK_array_del(arr) NPK_array_dim_del(arr, 1)
     void NPK_array_dim_del(NPK_array *arr, int dim);
 
+    // The maximum number of dimensions of an NPK_ndarray
+    #define NPK_ndarray_max_dim 8
+
+    // A multidimensional array that keeps all of its elements in a single contiguous buffer
+    // The element at indices (i, j, k) lives at index i * stride[0] + j * stride[1] + k * stride[2] of the buffer
+    typedef struct {
+        int dim;
+        int len;
+        int shape[NPK_ndarray_max_dim];
+        int stride[NPK_ndarray_max_dim];
+        void *data;
+    } NPK_ndarray;
+
+    // Allocates a zeroed multidimensional array, the shape is given by one length per dimension
+    // Example: NPK_ndarray_new(double, 100, 200) is a 100x200 grid
+    // More than NPK_ndarray_max_dim dimensions give an empty multidimensional array with a "dim" of 0 and no buffer
+    #define NPK_ndarray_new(type, ...) NPK_ndarray_new_(NPK_sizeof_type(type), NPK_cast(int, sizeof((int []) {__VA_ARGS__}) / sizeof(int)), (int []) {__VA_ARGS__})
+
+    // Allocates a multidimensional array with the elements of a "dim" dimensional NPK_array
+    // The shape is the length of the longest part of every dimension, shorter parts are padded with zeroes
+    #define NPK_ndarray_from_array_new(type, arr, dim) NPK_ndarray_from_array_new_(NPK_sizeof_type(type), arr, dim)
+
+    // Allocates a new multidimensional array that is a copy of "nd"
+    #define NPK_ndarray_copy_new(type, nd) NPK_ndarray_copy_new_(NPK_sizeof_type(type), nd)
+
+    // Provides typed access to the flat buffer of the multidimensional array
+    #define NPK_ndarray_data(type, nd) NPK_cast(type *, (nd)->data)
+
+    // Provides the total number of elements of the multidimensional array
+    #define NPK_ndarray_length(nd) ((nd)->len + 0)
+
+    // Returns a pointer to the element at the given indices, one per dimension
+    #define NPK_ndarray_at(type, nd, ...) NPK_cast(type *, NPK_ndarray_at_(NPK_sizeof_type(type), nd, (int []) {__VA_ARGS__}))
+
+    // Provides the number of rows, where a row holds the elements of the last dimension
+    #define NPK_ndarray_rows(nd) ((nd)->dim == 0 || (nd)->shape[(nd)->dim - 1] == 0 ? 0 : (nd)->len / (nd)->shape[(nd)->dim - 1])
+
+    // Returns an NPK_array that views the row at "idx", without copying it
+    // The view must not grow or be deallocated, but its elements can be modified
+    #define NPK_ndarray_row(type, nd, idx) NPK_ndarray_row_(NPK_sizeof_type(type), nd, idx)
+
+    // Checks if two multidimensional arrays have the same shape and elements
+    #define NPK_ndarray_equals(type, nd1, nd2, eq) NPK_ndarray_equals_(NPK_sizeof_type(type), nd1, nd2, eq)
+
+    // Sorts every row in "cmp" order, just like NPK_array_dim_sort
+    #define NPK_ndarray_sort(type, nd, cmp) NPK_ndarray_sort_(NPK_sizeof_type(type), nd, cmp)
+
+    // Sets every element to a shallow copy of "val"
+    #define NPK_ndarray_fill(type, nd, val) NPK_ndarray_fill_(NPK_sizeof_type(type), nd, NPK_rvalue_addr(type, val))
+
+    // Deallocates the multidimensional array, which is always a single deallocation
+    #define NPK_ndarray_del(nd) free((nd)->data)
+
     // Allocates a string with a cstring "s"
     NPK_string NPK_string_new(const NPK_cstring *s);
 
@@ -228,18 +350,56 @@ limitations under the License.
     // Replaces every occurence of a "from" in the string with a "to"
     void NPK_string_replace(NPK_string *str, const NPK_cstring *from, const NPK_cstring *to);
 
-    // Sorts the string in "cmp" order
+    // Sorts the bytes of the string in "cmp" order, which breaks up the multi-byte sequences of UTF-8 text
     #define NPK_string_sort(str, cmp) qsort((str)->data, NPK_string_length(str), 1, cmp)
 
-    // Reverses the order of the elements in the string
+    // Reverses the order of the bytes in the string, NPK_string_utf8_reverse keeps UTF-8 sequences whole
     #define NPK_string_reverse(str) NPK_array_reverse_(1, str, NPK_string_length(str))
 
-    // Converts a string to lowercase
+    // Converts the ASCII letters of a string to lowercase, every other byte is left alone so UTF-8 text stays valid
     void NPK_string_to_lower(NPK_string *str);
 
-    // Converts a string to uppercase
+    // Converts the ASCII letters of a string to uppercase, every other byte is left alone so UTF-8 text stays valid
     void NPK_string_to_upper(NPK_string *str);
 
+    // Compares two strings ignoring the case of ASCII letters, the result follows the convention of strcmp
+    int NPK_string_compare_nocase(const NPK_string *str, const NPK_cstring *s);
+
+    // Checks if two strings are equal ignoring the case of ASCII letters
+    bool NPK_string_equals_nocase(const NPK_string *str, const NPK_cstring *s);
+
+    // Hashes the content of the string
+    #define NPK_string_hash(str) NPK_hash_bytes_((str)->data, NPK_string_length(str), false)
+
+    // Hashes the content of the string ignoring the case of ASCII letters
+    #define NPK_string_hash_nocase(str) NPK_hash_bytes_((str)->data, NPK_string_length(str), true)
+
+    // Finds the index of the first blank character in the string, or -1 if there is none
+    int NPK_string_find_blank(const NPK_string *str);
+
+    // Removes the leading and trailing blank characters of the string
+    void NPK_string_trim(NPK_string *str);
+
+    // Counts the digits in the string
+    int NPK_string_count_digits(const NPK_string *str);
+
+    // Checks if every character in the string is ASCII
+    bool NPK_string_is_ascii(const NPK_string *str);
+
+    // Checks if the string is well formed UTF-8, which rules out overlong forms, surrogates and code points past U+10FFFF
+    bool NPK_string_is_utf8(const NPK_string *str);
+
+    // Counts the code points of a UTF-8 string
+    int NPK_string_utf8_length(const NPK_string *str);
+
+    // Decodes the code point that starts at byte "idx" of a UTF-8 string and returns the index of the one after it
+    // A byte that doesn't start a well formed sequence decodes to U+FFFD and is skipped on its own
+    // Example: for (int i = 0, next; i < NPK_string_length(str); i = next) next = NPK_string_utf8_next(str, i, &cp)
+    int NPK_string_utf8_next(const NPK_string *str, int idx, uint32_t *cp);
+
+    // Reverses the order of the code points in a UTF-8 string
+    void NPK_string_utf8_reverse(NPK_string *str);
+
     // Removes the element at "idx" from the string
     #define NPK_string_remove_at(str, idx) NPK_array_remove_at(char, str, idx)
 
@@ -249,6 +409,78 @@ limitations under the License.
     // Deallocates a string
     #define NPK_string_del(str) NPK_array_del(str)
 
+    // Builds a string out of chained chunks, growing never copies the characters that were already appended
+    // Every chunk is an NPK_array of char that doesn't end in a nul byte
+    typedef struct {
+        NPK_array chunks;
+        int len;
+    } NPK_string_builder;
+
+    // Allocates an empty string builder
+    NPK_string_builder NPK_string_builder_new(void);
+
+    // Provides the number of characters in the string builder
+    #define NPK_string_builder_length(sb) ((sb)->len + 0)
+
+    // Appends to the string builder a cstring "s"
+    void NPK_string_builder_append(NPK_string_builder *sb, const NPK_cstring *s);
+
+    // Adds "c" to the string builder
+    #define NPK_string_builder_add(sb, c) NPK_string_builder_append_n_(sb, NPK_rvalue_addr(char, c), 1)
+
+    // Appends to the string builder a formatted cstring, just like printf
+    void NPK_string_builder_printf(NPK_string_builder *sb, const NPK_cstring *format, ...);
+
+    // Appends the decimal representation of a number to the string builder
+    void NPK_string_builder_append_int64(NPK_string_builder *sb, int64_t val);
+    void NPK_string_builder_append_uint64(NPK_string_builder *sb, uint64_t val);
+    void NPK_string_builder_append_dbl(NPK_string_builder *sb, double val);
+
+    // Allocates a string with the contents of the string builder, copying them exactly once
+    NPK_string NPK_string_builder_to_string_new(const NPK_string_builder *sb);
+
+    // Writes the contents of the string builder to a file, returns false if not everything was written
+    bool NPK_string_builder_write(const NPK_string_builder *sb, FILE *f);
+
+    // Same as above for a file descriptor, where the chunks are written with scatter/gather I/O when available
+    bool NPK_string_builder_write_fd(const NPK_string_builder *sb, int fd);
+
+    // Deallocates the string builder
+    #define NPK_string_builder_del(sb) NPK_array_dim_del(&(sb)->chunks, 2)
+
+    // Keeps exactly one canonical string for every distinct content, so equal strings share the same address
+    // Canonical strings can be compared by pointer and used as keys of an NPK_map, but must never be modified
+    // The canonical strings live in "blocks" that never move, "slots" is an open addressing table pointing at them
+    // Every operation holds one lock, which lives on the heap so the pool can be passed around by value
+    // Lookups take the same lock as additions, so threads that only look strings up still wait for each other
+    typedef struct {
+        NPK_array blocks;
+        NPK_array slots;
+        NPK_array hashes;
+
+        #if defined NPK_THREADS_
+            mtx_t *lock;
+        #endif
+    } NPK_string_pool;
+
+    // Allocates an empty string pool
+    NPK_string_pool NPK_string_pool_new(void);
+
+    // Provides the number of distinct strings in the pool
+    #define NPK_string_pool_length(pool) (NPK_array_length(&(pool)->slots))
+
+    // Returns the canonical string with the content of a cstring "s", adding it to the pool if it is missing
+    NPK_string *NPK_string_pool_intern(NPK_string_pool *pool, const NPK_cstring *s);
+
+    // Returns the canonical string with the content of a cstring "s", or NULL if it isn't in the pool
+    NPK_string *NPK_string_pool_find(NPK_string_pool *pool, const NPK_cstring *s);
+
+    // Allocates an array with the canonical string (NPK_string *) of every string in "strs", in the same order
+    NPK_array NPK_string_pool_intern_all_new(NPK_string_pool *pool, const NPK_array *strs);
+
+    // Deallocates the pool along with all of its canonical strings
+    void NPK_string_pool_del(NPK_string_pool *pool);
+
     // Allocates a map of nine initial key-value pairs
     #define NPK_map_new(type) NPK_map_new_(NPK_sizeof_type(type))
 
@@ -269,15 +501,15 @@ limitations under the License.
     // Returns the value that corresponds to the key in the map
     #define NPK_map_get(type, m, key) NPK_cast(type *, NPK_map_get_(NPK_sizeof_type(type), m, key))
 
-    // Checks if two maps are equal
+    // Checks if two maps have the same keys with equal values, no matter their capacity or the order the keys were added in
     #define NPK_map_equals(type, m1, m2, eq) NPK_map_equals_(NPK_sizeof_type(type), m1, m2, eq)
 
     // Checks if the map contains the "key"
     bool NPK_map_contains_key(const NPK_map *m, const void *key);
 
-    // Checks if the map contains the "val"
+    // Checks if the map contains the "val", the slots are scanned in place until the first match
     #define NPK_map_contains_value(type, m, val, eq) NPK_map_contains_value_(NPK_sizeof_type(type), m, NPK_rvalue_addr(type, val), eq, 1)
-    #define NPK_map_dim_contains_value(type, m, val, eq) NPK_map_contains_value_(NPK_sizeof_type(type), m, val, eq, dim)
+    #define NPK_map_dim_contains_value(type, m, val, eq, dim) NPK_map_contains_value_(NPK_sizeof_type(type), m, val, eq, dim)
 
     // Checks if the map is empty
     #define NPK_map_is_empty(m) (NPK_map_length(m) == 0)
@@ -288,6 +520,29 @@ limitations under the License.
     // Adds to the map a key-value pair
     #define NPK_map_add(type, m, key, val) NPK_map_add_(NPK_sizeof_type(type), m, key, NPK_rvalue_addr(type, val))
 
+    // Makes room for "count" pairs in total, so adding up to that many never grows the map again
+    #define NPK_map_reserve(type, m, count) NPK_map_reserve_(NPK_sizeof_type(type), m, count)
+
+    // Allocates a map with the keys of "keys" paired with the values of "values" in order, it is sized once up front
+    #define NPK_map_from_arrays_new(type, keys, values) NPK_map_from_arrays_new_(NPK_sizeof_type(type), keys, values)
+
+    // Batched operations on an array of keys, they hash a run of keys and prefetch their slots before probing any of them
+    // so the cache misses of the run overlap, the results go to "out" in the order of the keys and replace what it held
+    // get_many fills an array of "type *" with the value of every key or NULL and contains_many an array of bool
+    // Both return how many of the keys were found
+    #define NPK_map_get_many(type, m, keys, out) NPK_map_get_many_(NPK_sizeof_type(type), m, keys, out)
+    int NPK_map_contains_many(const NPK_map *m, const NPK_array *keys, NPK_array *out);
+
+    // Adds every key of "keys" with the value at the same index of "values", the map is grown at most once
+    #define NPK_map_add_many(type, m, keys, values) NPK_map_add_many_(NPK_sizeof_type(type), m, keys, values)
+
+    // Adds a shallow copy of every pair of "other" to "m", replacing the values of the keys that "m" already has
+    #define NPK_map_update_from(type, m, other) NPK_map_merge_(NPK_sizeof_type(type), m, other, NULL, NULL)
+
+    // Same as NPK_map_update_from, but the value of a key that both maps have becomes merge(val, other_val, ctx)
+    // where "val" is the value in "m" and is updated in place, for example to add up two maps of counts
+    #define NPK_map_merge(type, m, other, merge, ctx) NPK_map_merge_(NPK_sizeof_type(type), m, other, merge, ctx)
+
     // Removes a key-value pair from the map using "key"
     #define NPK_map_remove(m, key) NPK_map_remove_(m, key, 1)
     #define NPK_map_dim_remove(m, key, dim) NPK_map_remove_(m, key, dim)
@@ -296,6 +551,949 @@ limitations under the License.
     #define NPK_map_del(m) NPK_map_dim_del(m, 1)
     void NPK_map_dim_del(NPK_map *m, int dim);
 
+    // Generates inline functions specialized to "type" that work on a plain NPK_array, prefixed with "name"
+    // name_add, name_get, name_set, name_index_of, name_contains and name_sort compare the elements with == and <
+    // Example: NPK_DEFINE_ARRAY(int, int_array) at file scope and then int_array_add(&ints, 5)
+    #define NPK_DEFINE_ARRAY(type, name) NPK_DEFINE_ARRAY_EX(type, name, NPK_op_equals_, NPK_op_less_)
+
+    // Same as NPK_DEFINE_ARRAY, but elements are compared with "eq" and "lt", which take two elements by value
+    // They can be macros or functions and, unlike the function pointers of the generic API, they are inlined
+    #define NPK_DEFINE_ARRAY_EX(type, name, eq, lt)                                       \
+    static inline void name##_swap_(type *p1, type *p2) {                                 \
+        type tmp = *p1;                                                                   \
+                                                                                          \
+        *p1 = *p2;                                                                        \
+        *p2 = tmp;                                                                        \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_add(NPK_array *arr, type val) {                             \
+        if (arr->len == arr->maxlen) {                                                    \
+            NPK_array_reserve_(NPK_sizeof_type(type), arr, arr->len + 1);                 \
+        }                                                                                 \
+                                                                                          \
+        NPK_array_data(type, arr)[arr->len++] = val;                                      \
+    }                                                                                     \
+                                                                                          \
+    static inline type name##_get(const NPK_array *arr, int idx) {                        \
+        return NPK_array_data(type, arr)[idx];                                            \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_set(NPK_array *arr, int idx, type val) {                    \
+        NPK_array_data(type, arr)[idx] = val;                                             \
+    }                                                                                     \
+                                                                                          \
+    static inline int name##_index_of(const NPK_array *arr, type val) {                   \
+        const type *data = NPK_array_data(type, arr);                                     \
+                                                                                          \
+        NPK_count_up (i, 0, arr->len) {                                                   \
+            if (eq(data[i], val)) {                                                       \
+                return i;                                                                 \
+            }                                                                             \
+        }                                                                                 \
+                                                                                          \
+        return -1;                                                                        \
+    }                                                                                     \
+                                                                                          \
+    static inline bool name##_contains(const NPK_array *arr, type val) {                  \
+        return name##_index_of(arr, val) != -1;                                           \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_sift_down_(type *data, int len, int root) {                 \
+        for (int child = 2 * root + 1; child < len; root = child, child = 2 * root + 1) { \
+            if (child + 1 < len && lt(data[child], data[child + 1])) {                    \
+                child++;                                                                  \
+            }                                                                             \
+                                                                                          \
+            if (lt(data[root], data[child]) == false) {                                   \
+                return;                                                                   \
+            }                                                                             \
+                                                                                          \
+            name##_swap_(data + root, data + child);                                      \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_sort_range_(type *data, int len, int depth) {               \
+        while (len > 16) {                                                                \
+            if (depth-- == 0) {                                                           \
+                NPK_count_down (i, len / 2, 0) {                                          \
+                    name##_sift_down_(data, len, i);                                      \
+                }                                                                         \
+                                                                                          \
+                NPK_count_down (i, len, 1) {                                              \
+                    name##_swap_(data, data + i);                                         \
+                    name##_sift_down_(data, i, 0);                                        \
+                }                                                                         \
+                                                                                          \
+                return;                                                                   \
+            }                                                                             \
+                                                                                          \
+            int mid = len / 2;                                                            \
+                                                                                          \
+            if (lt(data[mid], data[0])) {                                                 \
+                name##_swap_(data + mid, data);                                           \
+            }                                                                             \
+                                                                                          \
+            if (lt(data[len - 1], data[mid])) {                                           \
+                name##_swap_(data + len - 1, data + mid);                                 \
+                                                                                          \
+                if (lt(data[mid], data[0])) {                                             \
+                    name##_swap_(data + mid, data);                                       \
+                }                                                                         \
+            }                                                                             \
+                                                                                          \
+            type pivot = data[mid];                                                       \
+            int i = -1;                                                                   \
+            int j = len;                                                                  \
+                                                                                          \
+            while (true) {                                                                \
+                do { i++; } while (lt(data[i], pivot));                                   \
+                do { j--; } while (lt(pivot, data[j]));                                   \
+                                                                                          \
+                if (i >= j) {                                                             \
+                    break;                                                                \
+                }                                                                         \
+                                                                                          \
+                name##_swap_(data + i, data + j);                                         \
+            }                                                                             \
+                                                                                          \
+            if (j + 1 < len - j - 1) {                                                    \
+                name##_sort_range_(data, j + 1, depth);                                   \
+                data += j + 1;                                                            \
+                len -= j + 1;                                                             \
+            } else {                                                                      \
+                name##_sort_range_(data + j + 1, len - j - 1, depth);                     \
+                len = j + 1;                                                              \
+            }                                                                             \
+        }                                                                                 \
+                                                                                          \
+        NPK_count_up (i, 1, len) {                                                        \
+            type cur = data[i];                                                           \
+            int j = i;                                                                    \
+                                                                                          \
+            for (; j > 0 && lt(cur, data[j - 1]); j--) {                                  \
+                data[j] = data[j - 1];                                                    \
+            }                                                                             \
+                                                                                          \
+            data[j] = cur;                                                                \
+        }                                                                                 \
+    }                                                                                     \
+                                                                                          \
+    static inline void name##_sort(NPK_array *arr) {                                      \
+        int depth = 0;                                                                    \
+                                                                                          \
+        for (int len = arr->len; len > 1; len /= 2) {                                     \
+            depth += 2;                                                                   \
+        }                                                                                 \
+                                                                                          \
+        name##_sort_range_(NPK_array_data(type, arr), arr->len, depth);                   \
+    }
+
+    // Generates inline functions specialized to a map with "K" keys and "V" values, prefixed with "name"
+    // The keys must be pointers, name_add, name_get, name_contains and name_remove share the layout and hashing of NPK_map
+    // Example: NPK_DEFINE_MAP(NPK_string *, int, counts) at file scope and then *counts_get(&m, key) += 1
+    #define NPK_DEFINE_MAP(K, V, name) NPK_DEFINE_MAP_EX(K, V, name, NPK_op_identity_hash_, NPK_op_equals_)
+
+    // Same as NPK_DEFINE_MAP, but keys are hashed with "hash" and compared with "eq" instead of by their address
+    // Such a map must only be accessed through the generated functions, NPK_map_length, NPK_map_keys_new and NPK_map_del
+    #define NPK_DEFINE_MAP_EX(K, V, name, hash, eq)                                                                \
+    static inline int name##_slot_(const NPK_map *m, K key) {                                                      \
+        int maxlen = m->keys.maxlen;                                                                               \
+        void **keys = NPK_array_data(void *, &m->keys);                                                            \
+        int i = NPK_cast(int, NPK_cast(uint64_t, hash(key)) % NPK_cast(uint64_t, maxlen));                         \
+                                                                                                                   \
+        while (keys[i] != NULL) {                                                                                  \
+            if (eq(NPK_cast(K, keys[i]), key)) {                                                                   \
+                return i;                                                                                          \
+            }                                                                                                      \
+                                                                                                                   \
+            if (++i == maxlen) {                                                                                   \
+                i = 0;                                                                                             \
+            }                                                                                                      \
+        }                                                                                                          \
+                                                                                                                   \
+        return -1 - i;                                                                                             \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline V *name##_get(const NPK_map *m, K key) {                                                         \
+        int i = name##_slot_(m, key);                                                                              \
+                                                                                                                   \
+        return i >= 0 ? NPK_array_data(V, &m->values) + i : NULL;                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline bool name##_contains(const NPK_map *m, K key) {                                                  \
+        return name##_slot_(m, key) >= 0;                                                                          \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline void name##_add(NPK_map *m, K key, V val) {                                                      \
+        int i = name##_slot_(m, key);                                                                              \
+                                                                                                                   \
+        if (i >= 0) {                                                                                              \
+            NPK_array_data(V, &m->values)[i] = val;                                                                \
+                                                                                                                   \
+            return;                                                                                                \
+        }                                                                                                          \
+                                                                                                                   \
+        NPK_array_data(void *, &m->keys)[-1 - i] = NPK_cast(void *, key);                                          \
+        NPK_array_data(V, &m->values)[-1 - i] = val;                                                               \
+        m->keys.len++;                                                                                             \
+        m->values.len++;                                                                                           \
+                                                                                                                   \
+        if (2 * m->keys.len >= m->keys.maxlen) {                                                                   \
+            NPK_map nm = NPK_map_sized_new_(NPK_sizeof_type(V), m->keys.maxlen * 1.5);                             \
+                                                                                                                   \
+            NPK_stats_rehash_(m->keys.len);                                                                        \
+            NPK_count_up (j, 0, m->keys.maxlen) {                                                                  \
+                void *old_key = NPK_array_data(void *, &m->keys)[j];                                               \
+                                                                                                                   \
+                if (old_key != NULL) {                                                                             \
+                    int slot = -1 - name##_slot_(&nm, NPK_cast(K, old_key));                                       \
+                                                                                                                   \
+                    NPK_array_data(void *, &nm.keys)[slot] = old_key;                                              \
+                    NPK_array_data(V, &nm.values)[slot] = NPK_array_data(V, &m->values)[j];                        \
+                }                                                                                                  \
+            }                                                                                                      \
+                                                                                                                   \
+            nm.keys.len = m->keys.len;                                                                             \
+            nm.values.len = m->values.len;                                                                         \
+            NPK_map_dim_del(m, 1);                                                                                 \
+            *m = nm;                                                                                               \
+        }                                                                                                          \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline void name##_remove(NPK_map *m, K key) {                                                          \
+        int maxlen = m->keys.maxlen;                                                                               \
+        void **keys = NPK_array_data(void *, &m->keys);                                                            \
+        V *vals = NPK_array_data(V, &m->values);                                                                   \
+        int i = name##_slot_(m, key);                                                                              \
+                                                                                                                   \
+        if (i < 0) {                                                                                               \
+            return;                                                                                                \
+        }                                                                                                          \
+                                                                                                                   \
+        for (int j = (i + 1) % maxlen; keys[j] != NULL; j = (j + 1) % maxlen) {                                    \
+            int home = NPK_cast(int, NPK_cast(uint64_t, hash(NPK_cast(K, keys[j]))) % NPK_cast(uint64_t, maxlen)); \
+                                                                                                                   \
+            if ((i < j && (home <= i || home > j)) || (i > j && home <= i && home > j)) {                          \
+                keys[i] = keys[j];                                                                                 \
+                vals[i] = vals[j];                                                                                 \
+                i = j;                                                                                             \
+            }                                                                                                      \
+        }                                                                                                          \
+                                                                                                                   \
+        keys[i] = NULL;                                                                                            \
+        m->keys.len--;                                                                                             \
+        m->values.len--;                                                                                           \
+    }
+
+    // A map that can be used by many threads at once, its keys are spread over independently locked NPK_map shards
+    // Every operation locks a single shard, so threads only wait for each other when their keys land on the same one
+    typedef union {
+        struct {
+            NPK_map map;
+
+            #if defined NPK_THREADS_
+                mtx_t lock;
+            #endif
+        };
+
+        // Keeps every shard on its own cache lines, so that locking one never slows down its neighbours
+        char padding[128];
+    } NPK_cmap_shard_;
+
+    typedef struct {
+        int size;
+        NPK_array shards;
+    } NPK_cmap;
+
+    // Allocates a concurrent map with 64 shards
+    #define NPK_cmap_new(type) NPK_cmap_new_(NPK_sizeof_type(type), 64)
+
+    // Allocates a concurrent map with at least "shards" shards, more shards means less contention
+    #define NPK_cmap_sharded_new(type, shards) NPK_cmap_new_(NPK_sizeof_type(type), shards)
+
+    // Copies into "val" the value that corresponds to the key and returns true, or returns false if the key is missing
+    // The value is copied because another thread could move or remove it as soon as the shard is unlocked
+    bool NPK_cmap_get(NPK_cmap *cm, const void *key, void *val);
+
+    // Checks if the map contains the "key" at the moment of the call
+    bool NPK_cmap_contains_key(NPK_cmap *cm, const void *key);
+
+    // Adds to the map a key-value pair, replacing the value of an existing key
+    #define NPK_cmap_add(type, cm, key, val) NPK_cmap_add_(cm, key, NPK_rvalue_addr(type, val))
+
+    // Removes a key-value pair from the map using "key" and returns whether it was there
+    bool NPK_cmap_remove(NPK_cmap *cm, const void *key);
+
+    // Provides the number of pairs in the map, which is only exact if no other thread modifies it at the same time
+    int NPK_cmap_length(NPK_cmap *cm);
+
+    // Deallocates the map, no other thread may be using it
+    void NPK_cmap_del(NPK_cmap *cm);
+
+    // A double ended queue that keeps its elements in a circular NPK_array, whose length is always a power of two
+    // Both ends are pushed and popped in O(1), the array doubles when it is full
+    typedef struct {
+        NPK_array items;
+        int head;
+    } NPK_ring;
+
+    // Allocates a ring of eight initial elements
+    #define NPK_ring_new(type) NPK_ring_sized_new_(NPK_sizeof_type(type), 8)
+
+    // Allocates a ring with room for at least "maxlen" elements
+    #define NPK_ring_sized_new(type, maxlen) NPK_ring_sized_new_(NPK_sizeof_type(type), maxlen)
+
+    // Provides the number of elements of the ring
+    #define NPK_ring_length(r) (NPK_array_length(&(r)->items))
+
+    // Checks if the ring is empty
+    #define NPK_ring_is_empty(r) (NPK_ring_length(r) == 0)
+
+    // Returns a pointer to the element at "idx", counting from the front of the ring
+    #define NPK_ring_at(type, r, idx) NPK_cast(type *, NPK_ring_at_(NPK_sizeof_type(type), r, idx))
+
+    // Adds a shallow copy of "val" to the back or the front of the ring
+    #define NPK_ring_push_back(type, r, val) NPK_ring_push_(NPK_sizeof_type(type), r, NPK_rvalue_addr(type, val), false)
+    #define NPK_ring_push_front(type, r, val) NPK_ring_push_(NPK_sizeof_type(type), r, NPK_rvalue_addr(type, val), true)
+
+    // Removes the element at the front or the back of the ring and copies it into "val", which can be NULL
+    // Returns false if the ring was empty
+    #define NPK_ring_pop_front(type, r, val) NPK_ring_pop_(NPK_sizeof_type(type), r, val, true)
+    #define NPK_ring_pop_back(type, r, val) NPK_ring_pop_(NPK_sizeof_type(type), r, val, false)
+
+    // Deallocates the ring
+    #define NPK_ring_del(r) NPK_array_del(&(r)->items)
+
+    #if defined NPK_ATOMICS_
+        // The queues below keep the indices that different threads write on different cache lines
+        #define NPK_cache_line_ 64
+
+        // A bounded lock free queue for exactly one producer thread and exactly one consumer thread
+        // Each side caches the index of the other side and only reloads it when the queue looks full or empty
+        typedef struct {
+            int size;
+            NPK_array slots;
+            char padding1[NPK_cache_line_];
+            atomic_size_t tail;
+            size_t cached_head;
+            char padding2[NPK_cache_line_];
+            atomic_size_t head;
+            size_t cached_tail;
+            char padding3[NPK_cache_line_];
+        } NPK_spsc_queue;
+
+        // Allocates a queue with room for at least "maxlen" elements
+        #define NPK_spsc_queue_new(type, maxlen) NPK_spsc_queue_new_(NPK_sizeof_type(type), maxlen)
+
+        // Adds a shallow copy of "val" to the queue and returns false if the queue was full, only the producer may call it
+        #define NPK_spsc_queue_push(type, q, val) (NPK_spsc_queue_push_n(q, NPK_rvalue_addr(type, val), 1) == 1)
+
+        // Adds up to "n" consecutive elements of "vals" and returns how many fitted, only the producer may call it
+        int NPK_spsc_queue_push_n(NPK_spsc_queue *q, const void *vals, int n);
+
+        // Removes the oldest element, copies it into "val" and returns false if the queue was empty, only the consumer may call it
+        #define NPK_spsc_queue_pop(q, val) (NPK_spsc_queue_pop_n(q, val, 1) == 1)
+
+        // Removes up to "n" of the oldest elements into "vals" and returns how many there were, only the consumer may call it
+        int NPK_spsc_queue_pop_n(NPK_spsc_queue *q, void *vals, int n);
+
+        // Deallocates the queue, no other thread may be using it
+        #define NPK_spsc_queue_del(q) NPK_array_del(&(q)->slots)
+
+        // A bounded lock free queue for any number of producer and consumer threads
+        // Every slot has a sequence number that tells whether it is waiting for a producer or a consumer of the current lap
+        typedef struct {
+            int size;
+            NPK_array slots;
+            NPK_array seqs;
+            char padding1[NPK_cache_line_];
+            atomic_size_t tail;
+            char padding2[NPK_cache_line_];
+            atomic_size_t head;
+            char padding3[NPK_cache_line_];
+        } NPK_mpmc_queue;
+
+        // Allocates a queue with room for at least "maxlen" elements
+        #define NPK_mpmc_queue_new(type, maxlen) NPK_mpmc_queue_new_(NPK_sizeof_type(type), maxlen)
+
+        // Adds a shallow copy of "val" to the queue and returns false if the queue was full
+        #define NPK_mpmc_queue_push(type, q, val) (NPK_mpmc_queue_push_n(q, NPK_rvalue_addr(type, val), 1) == 1)
+
+        // Adds up to "n" consecutive elements of "vals" with a single claim on the queue and returns how many fitted
+        int NPK_mpmc_queue_push_n(NPK_mpmc_queue *q, const void *vals, int n);
+
+        // Removes the oldest element, copies it into "val" and returns false if the queue was empty
+        #define NPK_mpmc_queue_pop(q, val) (NPK_mpmc_queue_pop_n(q, val, 1) == 1)
+
+        // Removes up to "n" of the oldest elements into "vals" with a single claim on the queue and returns how many there were
+        int NPK_mpmc_queue_pop_n(NPK_mpmc_queue *q, void *vals, int n);
+
+        // Deallocates the queue, no other thread may be using it
+        void NPK_mpmc_queue_del(NPK_mpmc_queue *q);
+    #endif
+
+    // A work stealing thread pool, every worker owns a deque of tasks and steals from the others when it runs out
+    // The threads that wait for their tasks help run them, so parallel operations can be nested
+    // A NULL pool is valid everywhere and runs the work on the calling thread
+    typedef struct {
+        int threads;
+        struct NPK_pool_state_ *state;
+    } NPK_pool;
+
+    // Starts a pool of "threads" workers, or one per processor if "threads" is 0
+    NPK_pool NPK_pool_new(int threads);
+
+    // Runs fn(ctx, begin, end) over consecutive ranges of at most "grain" indices that cover [0, len) and waits for all of them
+    void NPK_pool_run(NPK_pool *pool, int len, int grain, void (*fn)(void *ctx, int begin, int end), void *ctx);
+
+    // Stops the workers after they finish their queued tasks and deallocates the pool
+    void NPK_pool_del(NPK_pool *pool);
+
+    // The parallel operations split the array into ranges of about 64 KiB and run the callback once per range
+    // Ranges depend only on the length of the array, so every result is the same regardless of the number of threads
+
+    // Calls fn(chunk, len, ctx) on consecutive ranges of the array, "chunk" points to the first of their "len" elements
+    #define NPK_array_parallel_for(type, pool, arr, fn, ctx) NPK_array_parallel_for_(NPK_sizeof_type(type), pool, arr, fn, ctx)
+
+    // Allocates an array of "out_type" elements where fn(in, out, len, ctx) converts every range of "arr"
+    #define NPK_array_parallel_map_new(type, out_type, pool, arr, fn, ctx) NPK_array_parallel_map_new_(NPK_sizeof_type(type), NPK_sizeof_type(out_type), pool, arr, fn, ctx)
+
+    // Reduces every range into its own copy of "*acc" with reduce(chunk, len, partial, ctx) and then merges those in order
+    // with merge(acc, partial, ctx), so "*acc" must start as the identity of merge, for example 0 for a sum
+    #define NPK_array_parallel_reduce(type, acc_type, pool, arr, acc, reduce, merge, ctx) NPK_array_parallel_reduce_(NPK_sizeof_type(type), NPK_sizeof_type(acc_type), pool, arr, acc, reduce, merge, ctx)
+
+    // Allocates an array with the elements for which keep(elem, ctx) is true, in their original order
+    #define NPK_array_parallel_filter_new(type, pool, arr, keep, ctx) NPK_array_parallel_filter_new_(NPK_sizeof_type(type), pool, arr, keep, ctx)
+
+    // Sorts the array in "cmp" order, it is cut into 32 runs that are sorted in parallel and then merged pairwise
+    #define NPK_array_parallel_sort(type, pool, arr, cmp) NPK_array_parallel_sort_(NPK_sizeof_type(type), pool, arr, cmp)
+
+    // Allocates a new array that is a deep copy of "arr", the inner arrays of a nested one are copied in parallel
+    #define NPK_array_parallel_copy_new(type, pool, arr) NPK_array_parallel_copy_new_(NPK_sizeof_type(type), pool, arr, 1)
+    #define NPK_array_dim_parallel_copy_new(type, pool, arr, dim) NPK_array_parallel_copy_new_(NPK_sizeof_type(type), pool, arr, dim)
+
+    // A d-ary heap stored in an NPK_array, its top is the element that comes first in "cmp" order
+    // An indexed heap also gives every element a handle, which stays valid until the element leaves the heap
+    // A bounded heap keeps at most "limit" elements, the ones that come last in "cmp" order
+    typedef struct {
+        int size;
+        int arity;
+        int limit;
+        NPK_array items;
+        NPK_array ids;
+        NPK_array positions;
+        NPK_array free_ids;
+        int (*type_compare)(const void *p1, const void *p2);
+    } NPK_heap;
+
+    // Allocates an empty binary heap
+    #define NPK_heap_new(type, cmp) NPK_heap_new_(NPK_sizeof_type(type), cmp, 2, 0, false)
+
+    // Allocates an empty heap where every element has "arity" children, 4 or 8 keep the children of a large heap on one cache line
+    #define NPK_heap_dary_new(type, cmp, arity) NPK_heap_new_(NPK_sizeof_type(type), cmp, arity, 0, false)
+
+    // Allocates an empty heap whose elements can be updated or removed through the handle that NPK_heap_push returns
+    #define NPK_heap_indexed_new(type, cmp, arity) NPK_heap_new_(NPK_sizeof_type(type), cmp, arity, 0, true)
+
+    // Allocates an empty heap that keeps only the "k" elements that come last in "cmp" order
+    // Example: with NPK_int_asc it keeps the k largest integers and its top is the smallest of them
+    #define NPK_heap_top_k_new(type, cmp, k) NPK_heap_new_(NPK_sizeof_type(type), cmp, 2, k, false)
+
+    // Allocates a binary heap with the elements of "arr", it is built in O(n)
+    #define NPK_heap_from_array_new(type, arr, cmp) NPK_heap_from_array_new_(NPK_sizeof_type(type), arr, cmp)
+
+    // Provides the number of elements in the heap
+    #define NPK_heap_length(h) (NPK_array_length(&(h)->items))
+
+    // Checks if the heap is empty
+    #define NPK_heap_is_empty(h) (NPK_heap_length(h) == 0)
+
+    // Returns a pointer to the top of the heap, or NULL if it is empty
+    #define NPK_heap_peek(type, h) NPK_cast(type *, NPK_heap_is_empty(h) ? NULL : (h)->items.data)
+
+    // Adds a shallow copy of "val" and returns its handle, or -1 if the heap isn't indexed or a bounded heap dropped it
+    #define NPK_heap_push(type, h, val) NPK_heap_push_(h, NPK_rvalue_addr(type, val))
+
+    // Removes the top of the heap and copies it into "val", which can be NULL
+    // Returns false if the heap was empty
+    bool NPK_heap_pop(NPK_heap *h, void *val);
+
+    // Replaces the element of an indexed heap that has "handle" with "val", for example to decrease its key
+    #define NPK_heap_update(type, h, handle, val) NPK_heap_update_(h, handle, NPK_rvalue_addr(type, val))
+
+    // Checks if the element with "handle" is still in an indexed heap
+    bool NPK_heap_contains(const NPK_heap *h, int handle);
+
+    // Removes the element with "handle" from an indexed heap and returns whether it was there
+    bool NPK_heap_remove(NPK_heap *h, int handle);
+
+    // Deallocates the heap
+    void NPK_heap_del(NPK_heap *h);
+
+    // A fixed number of bits packed into 64 bit words, the unused bits of the last word are always zero
+    typedef struct {
+        int len;
+        NPK_array words;
+    } NPK_bitset;
+
+    // Allocates a bitset of "len" bits that are all zero
+    NPK_bitset NPK_bitset_new(int len);
+
+    // Allocates a new bitset that is a copy of "bs"
+    NPK_bitset NPK_bitset_copy_new(const NPK_bitset *bs);
+
+    // Allocates a bitset with one bit for every bool of an array
+    NPK_bitset NPK_bitset_from_bools_new(const NPK_array *bools);
+
+    // Allocates an array of bool with one element for every bit of the bitset
+    NPK_array NPK_bitset_to_bools_new(const NPK_bitset *bs);
+
+    // Provides the number of bits of the bitset
+    #define NPK_bitset_length(bs) ((bs)->len + 0)
+
+    // Provides typed access to the words of the bitset, bit "idx" lives in word idx / 64 at position idx % 64
+    #define NPK_bitset_words(bs) NPK_array_data(uint64_t, &(bs)->words)
+
+    // Reads, sets, clears or flips the bit at "idx"
+    #define NPK_bitset_get(bs, idx) ((NPK_bitset_words(bs)[(idx) / 64] >> ((idx) % 64)) & 1)
+    #define NPK_bitset_set(bs, idx) (NPK_bitset_words(bs)[(idx) / 64] |= UINT64_C(1) << ((idx) % 64))
+    #define NPK_bitset_clear(bs, idx) (NPK_bitset_words(bs)[(idx) / 64] &= ~(UINT64_C(1) << ((idx) % 64)))
+    #define NPK_bitset_flip(bs, idx) (NPK_bitset_words(bs)[(idx) / 64] ^= UINT64_C(1) << ((idx) % 64))
+
+    // Sets every bit to "val"
+    void NPK_bitset_fill(NPK_bitset *bs, bool val);
+
+    // Provides the number of set bits
+    int NPK_bitset_count(const NPK_bitset *bs);
+
+    // Checks if two bitsets have the same length and bits
+    bool NPK_bitset_equals(const NPK_bitset *bs1, const NPK_bitset *bs2);
+
+    // Combines "src" into "dst" a whole vector of words at a time, only the bits that both bitsets have are combined
+    void NPK_bitset_and(NPK_bitset *dst, const NPK_bitset *src);
+    void NPK_bitset_or(NPK_bitset *dst, const NPK_bitset *src);
+    void NPK_bitset_xor(NPK_bitset *dst, const NPK_bitset *src);
+
+    // Clears in "dst" every bit that is set in "src"
+    void NPK_bitset_andnot(NPK_bitset *dst, const NPK_bitset *src);
+
+    // Returns the index of the first set bit at "idx" or after it, or -1 if there is none
+    // Example: for (int i = NPK_bitset_next_set(&bs, 0); i != -1; i = NPK_bitset_next_set(&bs, i + 1))
+    int NPK_bitset_next_set(const NPK_bitset *bs, int idx);
+
+    // Returns the number of set bits before "idx"
+    int NPK_bitset_rank(const NPK_bitset *bs, int idx);
+
+    // Returns the index of the set bit that has "rank" set bits before it, or -1 if there are not that many
+    int NPK_bitset_select(const NPK_bitset *bs, int rank);
+
+    // Deallocates the bitset
+    #define NPK_bitset_del(bs) NPK_array_del(&(bs)->words)
+
+    // A blocked Bloom filter that tells if an element is certainly absent or may be present
+    // Every element sets one bit in each of the eight 32 bit words of a single 256 bit block, so a lookup reads one cache line
+    typedef struct {
+        int blocks;
+        NPK_array words;
+    } NPK_bloom;
+
+    // Allocates a filter for about "count" elements that wrongly answers "may be present" with probability "fpr"
+    // It takes about 10.5 bits for every element at 1% and 17 bits at 0.1%, so 100M elements at 1% take about 130 MB
+    NPK_bloom NPK_bloom_new(int count, double fpr);
+
+    // Allocates a filter with every element of an array, elements are compared by their bytes
+    #define NPK_bloom_from_array_new(type, arr, fpr) NPK_bloom_from_array_new_(NPK_sizeof_type(type), arr, fpr)
+
+    // Allocates a filter with every key of a map, keys are compared by their addresses like the map does
+    NPK_bloom NPK_bloom_from_map_new(const NPK_map *m, double fpr);
+
+    // Adds an element to the filter, elements are compared by their bytes
+    #define NPK_bloom_add(type, bf, val) NPK_bloom_add_(bf, NPK_rvalue_addr(type, val), NPK_sizeof_type(type))
+
+    // Checks if an element may have been added, false is always right while true is wrong with the rate of the filter
+    #define NPK_bloom_contains(type, bf, val) NPK_bloom_contains_(bf, NPK_rvalue_addr(type, val), NPK_sizeof_type(type))
+
+    // Same as above for the address of a map key
+    #define NPK_bloom_add_key(bf, key) NPK_bloom_add(const void *, bf, key)
+    #define NPK_bloom_contains_key(bf, key) NPK_bloom_contains(const void *, bf, key)
+
+    // Empties the filter
+    #define NPK_bloom_clear(bf) memset((bf)->words.data, 0, NPK_array_length(&(bf)->words) * NPK_sizeof_type(uint32_t))
+
+    // Deallocates the filter
+    #define NPK_bloom_del(bf) NPK_array_del(&(bf)->words)
+
+    // Map operations with a filter of its keys attached, so looking up a missing key usually returns before probing
+    // The filter must contain every key of the map, removed keys can stay in it since they only cause false positives
+    #define NPK_map_filtered_get(type, m, bf, key) NPK_cast(type *, NPK_map_filtered_get_(NPK_sizeof_type(type), m, bf, key))
+    bool NPK_map_filtered_contains_key(const NPK_map *m, const NPK_bloom *bf, const void *key);
+    #define NPK_map_filtered_add(type, m, bf, key, val) NPK_map_filtered_add_(NPK_sizeof_type(type), m, bf, key, NPK_rvalue_addr(type, val))
+
+    // Provides the fraction of the slots of a map that hold a key, a map grows once it reaches 0.5
+    #define NPK_map_load_factor(m) (NPK_cast(double, NPK_map_length(m)) / (m)->keys.maxlen)
+
+    // Statistics about allocations and map lookups, collected only when NPK_DS_STATS is defined before every include of this header
+    // Without it every hook in the containers expands to nothing and a snapshot is all zeros
+    // Allocations are counted by the kind of container that made them, strings are arrays of char so they count as arrays
+    typedef enum {
+        NPK_stats_array,
+        NPK_stats_map,
+        NPK_stats_ndarray,
+        NPK_stats_other,
+        NPK_stats_kind_count
+    } NPK_stats_kind;
+
+    // Probe lengths are grouped by powers of two, bucket "b" counts the lookups that probed 2^b up to 2^(b + 1) - 1 slots
+    #define NPK_stats_probe_buckets 16
+
+    // A copy of every counter, a realloc copy is a realloc that had to move the data and "copied_bytes" is what it moved
+    // Lookups are the gets, contains and adds of NPK_map, typed maps only report their rehashes
+    typedef struct {
+        int64_t allocs[NPK_stats_kind_count];
+        int64_t bytes[NPK_stats_kind_count];
+        int64_t reallocs[NPK_stats_kind_count];
+        int64_t realloc_copies[NPK_stats_kind_count];
+        int64_t copied_bytes[NPK_stats_kind_count];
+        int64_t map_lookups;
+        int64_t map_probes;
+        int64_t map_probe_histogram[NPK_stats_probe_buckets];
+        int64_t map_rehashes;
+        int64_t map_rehashed_keys;
+    } NPK_stats;
+
+    // Reads every counter
+    NPK_stats NPK_stats_snapshot(void);
+
+    // Sets every counter to zero
+    void NPK_stats_reset(void);
+
+    // Prints a snapshot in a readable form to "f"
+    void NPK_stats_dump(const NPK_stats *stats, FILE *f);
+
+    // Kinds of container that a snapshot file holds
+    typedef enum {
+        NPK_snapshot_of_array,
+        NPK_snapshot_of_strings,
+        NPK_snapshot_of_map
+    } NPK_snapshot_kind;
+
+    // A binary snapshot file opened for reading, which is memory mapped on POSIX systems and read into memory elsewhere
+    // The file is a versioned header and aligned sections, nested arrays are stored as one level of offsets per dimension
+    // The arrays, strings and maps it provides point straight into its memory, so they are read only and live until it is closed
+    typedef struct {
+        NPK_snapshot_kind kind;
+        int dim;
+        int size;
+        int len;
+        int keys_len;
+        int64_t rows;
+        const uint64_t *offsets;
+        const uint64_t *leaf_offsets;
+        const uint64_t *keys;
+        const uint8_t *elements;
+        void *base;
+        int64_t bytes;
+    } NPK_snapshot;
+
+    // Writes an array, which can have more than one dimension, to a snapshot file at "path"
+    // Only the "len" elements of every array are written, returns false on an I/O error
+    #define NPK_snapshot_write_array(type, path, arr) NPK_snapshot_write_(path, NPK_snapshot_of_array, NPK_sizeof_type(type), arr, 1)
+    #define NPK_snapshot_write_dim_array(type, path, arr, dim) NPK_snapshot_write_(path, NPK_snapshot_of_array, NPK_sizeof_type(type), arr, dim)
+
+    // Writes an array of strings to a snapshot file at "path", every string keeps its nul byte
+    #define NPK_snapshot_write_strings(path, strs) NPK_snapshot_write_(path, NPK_snapshot_of_strings, 1, strs, 2)
+
+    // Writes a map to a snapshot file at "path" with the slots laid out as they are, so loading it doesn't rehash
+    // The keys are written as the bits of the pointers, so this is meant for maps whose keys are values cast to void *
+    #define NPK_snapshot_write_map(type, path, m) NPK_snapshot_write_map_(path, NPK_sizeof_type(type), m)
+
+    // Opens a snapshot file, no element is parsed or allocated but the offsets of nested arrays are checked one by one
+    // Returns false if it can't be read or isn't a valid snapshot, with "verify" the checksum of the header and all the data is checked too
+    bool NPK_snapshot_open(const NPK_cstring *path, NPK_snapshot *snap, bool verify);
+
+    // Provides the number of innermost arrays, which is one for an array of one dimension and the number of strings for strings
+    #define NPK_snapshot_rows(snap) ((snap)->rows + 0)
+
+    // Returns a read only NPK_array that views the innermost array at "idx", innermost arrays are numbered in order
+    // For an array of one dimension the only row is the array itself, for strings every row is an NPK_string
+    NPK_array NPK_snapshot_row(const NPK_snapshot *snap, int64_t idx);
+
+    // Returns the offsets of the arrays at depth "level" + 1, array "i" has the items offsets[i] up to offsets[i + 1] of the next level
+    // Level "dim" - 2 gives the rows, and its offsets count elements
+    const uint64_t *NPK_snapshot_offsets(const NPK_snapshot *snap, int level);
+
+    // Returns a read only NPK_map that views the map of the snapshot
+    NPK_map NPK_snapshot_map(const NPK_snapshot *snap);
+
+    // Allocates ordinary arrays with a copy of the array or strings of the snapshot
+    NPK_array NPK_snapshot_copy_new(const NPK_snapshot *snap);
+
+    // Unmaps or deallocates the memory of the snapshot
+    void NPK_snapshot_close(NPK_snapshot *snap);
+
+    // An ordered map stored as a B+ tree, which keeps shallow copies of its keys and values in "cmp" order
+    // The keys of a node span a few cache lines, and the leaves are linked in key order so ranges are read leaf by leaf
+    // Nodes live in two arrays and refer to each other by index, so adding or removing keys invalidates every pointer into the tree
+    typedef struct {
+        int key_size;
+        int size;
+        int len;
+        int height;
+        int root;
+        int first;
+        int leaf_cap;
+        int inner_cap;
+        int leaf_bytes;
+        int inner_bytes;
+        int values_offset;
+        int children_offset;
+        NPK_array leaves;
+        NPK_array inners;
+        NPK_array free_leaves;
+        NPK_array free_inners;
+        int (*type_compare)(const void *p1, const void *p2);
+    } NPK_btree;
+
+    // A position in the leaves of a tree, it stays valid until the tree is modified
+    typedef struct {
+        const NPK_btree *bt;
+        int leaf;
+        int pos;
+    } NPK_btree_cursor;
+
+    // Allocates an empty tree with keys of "key_type" and values of "type"
+    #define NPK_btree_new(key_type, type, cmp) NPK_btree_new_(NPK_sizeof_type(key_type), NPK_sizeof_type(type), cmp)
+
+    // Allocates a tree with the keys of "keys" and the values of "values" in O(n), the keys must already be in "cmp" order
+    // "values" can be NULL to make every value zero, and of several equal keys only the last one is kept
+    #define NPK_btree_from_arrays_new(key_type, type, keys, values, cmp) NPK_btree_from_arrays_new_(NPK_sizeof_type(key_type), NPK_sizeof_type(type), keys, values, cmp)
+
+    // Provides the number of keys in the tree
+    #define NPK_btree_length(bt) ((bt)->len + 0)
+
+    // Checks if the tree is empty
+    #define NPK_btree_is_empty(bt) (NPK_btree_length(bt) == 0)
+
+    // Returns a pointer to the value of "key", or NULL if the key is missing
+    #define NPK_btree_get(key_type, type, bt, key) NPK_cast(type *, NPK_btree_get_(bt, NPK_rvalue_addr(key_type, key)))
+
+    // Checks if the tree contains "key"
+    #define NPK_btree_contains_key(key_type, bt, key) (NPK_btree_get_(bt, NPK_rvalue_addr(key_type, key)) != NULL)
+
+    // Adds "key" with "val", or replaces the value if the key is already there
+    #define NPK_btree_add(key_type, type, bt, key, val) NPK_btree_add_(bt, NPK_rvalue_addr(key_type, key), NPK_rvalue_addr(type, val))
+
+    // Removes "key" and returns whether it was there
+    #define NPK_btree_remove(key_type, bt, key) NPK_btree_remove_(bt, NPK_rvalue_addr(key_type, key))
+
+    // Returns a cursor at the first key of the tree
+    NPK_btree_cursor NPK_btree_first(const NPK_btree *bt);
+
+    // Returns a cursor at the first key that doesn't come before "key", or after it for upper_bound
+    #define NPK_btree_lower_bound(key_type, bt, key) NPK_btree_seek_(bt, NPK_rvalue_addr(key_type, key), false)
+    #define NPK_btree_upper_bound(key_type, bt, key) NPK_btree_seek_(bt, NPK_rvalue_addr(key_type, key), true)
+
+    // Checks if the cursor is at a key, it is at none once it moves past the last one
+    #define NPK_btree_cursor_valid(cur) ((cur)->leaf != -1)
+
+    // Provide typed access to the key and the value at the cursor
+    #define NPK_btree_cursor_key(key_type, cur) NPK_cast(key_type *, NPK_btree_keys_(NPK_btree_leaf_((cur)->bt, (cur)->leaf)) + (cur)->pos * (cur)->bt->key_size)
+    #define NPK_btree_cursor_value(type, cur) NPK_cast(type *, NPK_btree_leaf_((cur)->bt, (cur)->leaf) + (cur)->bt->values_offset + (cur)->pos * (cur)->bt->size)
+
+    // Moves the cursor to the next key
+    void NPK_btree_cursor_next(NPK_btree_cursor *cur);
+
+    // Traverses the keys from "lo" up to but not including "hi" in order, "var" is the cursor
+    // Example: NPK_btree_for_range(int64_t, cur, &bt, from, to) { sum += *NPK_btree_cursor_value(double, &cur); }
+    #define NPK_btree_for_range(key_type, var, bt, lo, hi) for (NPK_btree_cursor var = NPK_btree_lower_bound(key_type, bt, lo); NPK_btree_cursor_before_(&var, NPK_rvalue_addr(key_type, hi)); NPK_btree_cursor_next(&var))
+
+    // Traverses every key in order, "var" is the cursor
+    #define NPK_btree_for_each(var, bt) for (NPK_btree_cursor var = NPK_btree_first(bt); NPK_btree_cursor_valid(&var); NPK_btree_cursor_next(&var))
+
+    // Deallocates the tree
+    void NPK_btree_del(NPK_btree *bt);
+
+    // A lazy pipeline stage, pulling an element from it pulls just the elements it needs from the stages before it
+    // Stages are plain structs that point to the stage before them, so a whole pipeline can live on the stack
+    // Example: NPK_iter lines = NPK_iter_lines_new(path), kept = NPK_iter_filter(&lines, is_valid, NULL), first = NPK_iter_take(&kept, 10)
+    typedef struct NPK_iter {
+        int size;
+        bool (*next)(struct NPK_iter *it, void *out);
+        struct NPK_iter *src;
+        void (*fn)(void);
+        void *ctx;
+        int64_t count;
+        const NPK_array *arr;
+        const NPK_cstring *cursor;
+        const NPK_cstring *delim;
+        FILE *f;
+        NPK_array buf;
+    } NPK_iter;
+
+    // Sources, an array gives a shallow copy of each of its elements in order
+    // split and lines give the same NPK_string parts as NPK_string_split_new and NPK_file_read_new, but every part lives
+    // in a buffer of the stage that the next part overwrites, and a file that can't be opened gives no lines
+    #define NPK_iter_array(type, arr) NPK_iter_array_(NPK_sizeof_type(type), arr)
+    NPK_iter NPK_iter_split_new(const NPK_string *str, const NPK_cstring *delim);
+    NPK_iter NPK_iter_lines_new(const NPK_cstring *path);
+
+    // A source that gives the uint32_t code points of a UTF-8 string, decoded like NPK_string_utf8_next does
+    NPK_iter NPK_iter_code_points(const NPK_string *str);
+
+    // Gives the elements of "src" for which keep(elem, ctx) is true
+    NPK_iter NPK_iter_filter(NPK_iter *src, bool (*keep)(const void *elem, void *ctx), void *ctx);
+
+    // Gives an "out_type" element for every element of "src", which fn(in, out, ctx) converts
+    #define NPK_iter_map(out_type, src, fn, ctx) NPK_iter_map_(NPK_sizeof_type(out_type), src, fn, ctx)
+
+    // Gives at most the first "n" elements of "src", or all of them but the first "n"
+    NPK_iter NPK_iter_take(NPK_iter *src, int64_t n);
+    NPK_iter NPK_iter_skip(NPK_iter *src, int64_t n);
+
+    // Gives the elements of "src" in batches of "n", as an NPK_array that the next batch overwrites, the last one can be shorter
+    NPK_iter NPK_iter_chunk_new(NPK_iter *src, int n);
+
+    // Copies the next element into "out" and returns true, or returns false once the pipeline is exhausted
+    bool NPK_iter_next(NPK_iter *it, void *out);
+
+    // Pulls every element into "var", which is an element of "type"
+    #define NPK_iter_for_each(type, var, it) for (type var; NPK_iter_next(it, &var);)
+
+    // Sinks, which pull every element that is left
+    // collect allocates an array with shallow copies of the elements, while collect_strings deep copies NPK_string elements
+    NPK_array NPK_iter_collect_new(NPK_iter *it);
+    NPK_array NPK_iter_collect_strings_new(NPK_iter *it);
+
+    // Returns the number of elements that are left
+    int64_t NPK_iter_count(NPK_iter *it);
+
+    // Calls reduce(acc, elem, ctx) for every element, so "*acc" must start as the identity of reduce
+    void NPK_iter_reduce(NPK_iter *it, void *acc, void (*reduce)(void *acc, const void *elem, void *ctx), void *ctx);
+
+    // Writes NPK_string elements to a file at "path" one per line like NPK_file_write, returns false if it can't be opened
+    bool NPK_iter_write(NPK_iter *it, const NPK_cstring *path);
+
+    // Deallocates the buffers and closes the files of every stage up to "it", it is needed if any of them came from a _new function
+    void NPK_iter_del(NPK_iter *it);
+
+    // Reads and writes whole files in the background, many at once, through io_uring on Linux and worker threads elsewhere
+    // Requests beyond "depth" wait in a queue and only get a file descriptor once one of the running requests finishes
+    // The callbacks run on the thread that calls NPK_aio_poll or NPK_aio_wait, which is also the one that submits to io_uring
+    // A NULL callback is allowed, and a failed read leaves its array empty
+    typedef struct {
+        int depth;
+        struct NPK_aio_state_ *state;
+    } NPK_aio;
+
+    // Starts an engine that keeps at most "depth" requests in flight, or 64 if "depth" is 0
+    NPK_aio NPK_aio_new(int depth);
+
+    // Queues a read of the whole file at "path" into "out", which is a new array of uint8_t like NPK_file_read_bytes_new
+    // "out" must not move until the request finishes, then done(out, ok, ctx) is called
+    void NPK_aio_read_bytes_new(NPK_aio *aio, const NPK_cstring *path, NPK_array *out, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx);
+
+    // Queues a write of all the bytes of "arr" to the file at "path" like NPK_file_write_bytes
+    // "arr" must not change until the request finishes, then done(arr, ok, ctx) is called
+    void NPK_aio_write_bytes(NPK_aio *aio, const NPK_cstring *path, const NPK_array *arr, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx);
+
+    // Reads every file of an array of NPK_string paths at once and waits for them
+    // Returns an array with an array of uint8_t for each path in order, which is empty if the file couldn't be read
+    NPK_array NPK_aio_read_all_new(NPK_aio *aio, const NPK_array *paths);
+
+    // Submits the queued requests and runs the callbacks of those that have finished without blocking, returns how many finished
+    int NPK_aio_poll(NPK_aio *aio);
+
+    // Submits the queued requests and blocks until every request has finished and run its callback, returns how many finished
+    int NPK_aio_wait(NPK_aio *aio);
+
+    // Provides the number of requests that haven't run their callback yet
+    int NPK_aio_pending(const NPK_aio *aio);
+
+    // Waits for every request and deallocates the engine
+    void NPK_aio_del(NPK_aio *aio);
+
+    // An index of NPK_string keys stored as an adaptive radix tree, which keeps a shallow copy of a value of "type" for every key
+    // Inner nodes hold the bytes their keys share as a compressed path and grow through 4, 16, 48 and 256 children
+    // A lookup visits one node per distinguishing byte no matter how many keys there are, and keys can't contain nul bytes
+    // The bytes of the keys are copied into blocks of the tree, those of removed keys are only reclaimed by NPK_radix_del
+    typedef struct {
+        int size;
+        int len;
+        int leaf_bytes;
+        uint32_t root;
+        NPK_array pools[5];
+        NPK_array free[5];
+        NPK_array blocks;
+    } NPK_radix;
+
+    // A key and its value, the key is a read only view into the tree that stays valid until the tree is deleted
+    typedef struct {
+        NPK_string key;
+        void *value;
+    } NPK_radix_entry;
+
+    // Allocates an empty tree with values of "type"
+    #define NPK_radix_new(type) NPK_radix_new_(NPK_sizeof_type(type))
+
+    // Provides the number of keys in the tree
+    #define NPK_radix_length(t) ((t)->len + 0)
+
+    // Checks if the tree is empty
+    #define NPK_radix_is_empty(t) (NPK_radix_length(t) == 0)
+
+    // Returns a pointer to the value of the string "key", or NULL if it isn't in the tree
+    #define NPK_radix_get(type, t, key) NPK_cast(type *, NPK_radix_get_(t, NPK_string_data(key), NPK_string_length(key)))
+
+    // Checks if the string "key" is in the tree
+    #define NPK_radix_contains_key(t, key) (NPK_radix_get_(t, NPK_string_data(key), NPK_string_length(key)) != NULL)
+
+    // Adds a copy of the string "key" with a shallow copy of "val", or replaces the value if the key is already in the tree
+    #define NPK_radix_add(type, t, key, val) NPK_radix_add_(t, NPK_string_data(key), NPK_string_length(key), NPK_rvalue_addr(type, val))
+
+    // Removes the string "key", returns false if it wasn't in the tree
+    #define NPK_radix_remove(t, key) NPK_radix_remove_(t, NPK_string_data(key), NPK_string_length(key))
+
+    // Finds the longest key that "str" starts with and copies it into "out", returns false if no key is a prefix of "str"
+    bool NPK_radix_longest_prefix(const NPK_radix *t, const NPK_string *str, NPK_radix_entry *out);
+
+    // An NPK_iter source that gives an NPK_radix_entry for every key that starts with "prefix", in the order of their bytes
+    // The tree must not be modified while it is in use, and an empty prefix gives every key
+    NPK_iter NPK_radix_iter_prefix_new(const NPK_radix *t, const NPK_string *prefix);
+
+    // Deallocates the tree and the bytes of its keys
+    void NPK_radix_del(NPK_radix *t);
+
+    // A table parsed from delimited text such as CSV, with an NPK_array for every column
+    // Every character of "types" gives the type of a column, 'i' columns hold int64_t, 'd' columns hold double,
+    // 's' columns hold NPK_string views into "arena" and the arrays of '_' columns, or any other character, stay empty
+    typedef struct {
+        int rows;
+        int cols;
+        int errors;
+        NPK_string types;
+        NPK_array columns;
+        NPK_array names;
+        NPK_array arena;
+    } NPK_csv;
+
+    // Parses "len" bytes of delimited text, records end in \n or \r\n and empty lines are skipped
+    // A field can be quoted with '"', then the delimiter and newlines inside it are literal and "" stands for a quote
+    // With "header" the first record gives the names of the columns, as NPK_string elements of "names"
+    // Fields past the last column are ignored and missing ones are empty, a number field that isn't entirely a number
+    // becomes 0 and is counted in "errors"
+    // With a pool a large input is split into chunks that are parsed at once, and the table is the same as without one
+    // as long as quotes only ever begin a field
+    NPK_csv NPK_csv_parse_new(const char *data, int64_t len, const NPK_cstring *types, char delim, bool header, NPK_pool *pool);
+
+    // Parses the file at "path" like NPK_csv_parse_new, returns a table without rows if the file can't be read
+    NPK_csv NPK_csv_read_new(const NPK_cstring *path, const NPK_cstring *types, char delim, bool header, NPK_pool *pool);
+
+    // Provides typed access to the elements of the column at "col"
+    #define NPK_csv_column(type, csv, col) NPK_array_data(type, NPK_array_data(NPK_array, &(csv)->columns) + (col))
+
+    // Deallocates the columns, the names and the arena of the table
+    void NPK_csv_del(NPK_csv *csv);
+
     // Equality functions are important when dealing with objects
     // Here, the equality functions for primitive types are provided
     bool NPK_uchar_equals(const void *p1, const void *p2);
@@ -389,6 +1587,12 @@ limitations under the License.
     NPK_string NPK_int32_to_string_new(int32_t val);
     NPK_string NPK_int64_to_string_new(int64_t val);
 
+    // Appends the decimal representation of a number to the string, without allocating anything else
+    // Doubles are written with the fewest digits that still read back as exactly the same value
+    void NPK_string_append_int64(NPK_string *str, int64_t val);
+    void NPK_string_append_uint64(NPK_string *str, uint64_t val);
+    void NPK_string_append_dbl(NPK_string *str, double val);
+
     // Converts a cstring to a bool
     #define NPK_cstring_to_bool(s) (strcmp(s, "True") == 0)
 
@@ -419,6 +1623,31 @@ limitations under the License.
     int32_t NPK_string_to_int32(const NPK_string *str);
     int64_t NPK_string_to_int64(const NPK_string *str);
 
+    // Describes the outcome of parsing a number
+    typedef enum {
+        NPK_parse_ok,
+        NPK_parse_invalid,
+        NPK_parse_overflow
+    } NPK_parse_error;
+
+    // The "end" member is the index right after the last character that was consumed
+    typedef struct {
+        NPK_parse_error error;
+        int end;
+    } NPK_parse_result;
+
+    // Parses a decimal number found at "idx" of the string, leading blanks are skipped
+    // On overflow "val" is saturated and on an invalid number it is left untouched
+    NPK_parse_result NPK_string_parse_int64(const NPK_string *str, int idx, int64_t *val);
+    NPK_parse_result NPK_string_parse_uint64(const NPK_string *str, int idx, uint64_t *val);
+    NPK_parse_result NPK_string_parse_dbl(const NPK_string *str, int idx, double *val);
+
+    // Parses every string of an array of strings into an array of numbers
+    // Strings that aren't entirely a number become 0 and are counted in "errors", which can be NULL
+    NPK_array NPK_strings_to_int64_new(const NPK_array *strs, int *errors);
+    NPK_array NPK_strings_to_uint64_new(const NPK_array *strs, int *errors);
+    NPK_array NPK_strings_to_dbl_new(const NPK_array *strs, int *errors);
+
     // =============
     // NPK INTERNALS
     // =============
@@ -426,15 +1655,88 @@ limitations under the License.
     #define NPK_ends_in_nul_(arr) (NPK_array_data(char, arr)[NPK_string_length(arr)] == '\0')
     void NPK_swap_(int size, void *p1, void *p2);
 
+    // The default equality, ordering and hashing of the typed containers
+    #define NPK_op_equals_(a, b) ((a) == (b))
+    #define NPK_op_less_(a, b) ((a) < (b))
+    #define NPK_op_identity_hash_(key) NPK_cast(uint64_t, NPK_cast(uintptr_t, key))
+
+    #if defined __GNUC__
+        #define NPK_ctz64_(x) __builtin_ctzll(x)
+        #define NPK_popcount64_(x) __builtin_popcountll(x)
+        #define NPK_clz64_(x) __builtin_clzll(x)
+    #else
+        int NPK_ctz64_(uint64_t x);
+        int NPK_popcount64_(uint64_t x);
+        int NPK_clz64_(uint64_t x);
+    #endif
+
+    uint64_t NPK_mul128_(uint64_t a, uint64_t b, uint64_t *hi);
+
+    void NPK_string_append_n_(NPK_string *str, const char *s, int n);
+    void NPK_string_builder_append_n_(NPK_string_builder *sb, const char *s, int n);
+    NPK_string *NPK_string_pool_intern_n_(NPK_string_pool *pool, const char *s, int len, bool add);
+    void NPK_ascii_case_(char *s, int len, bool upper);
+    int NPK_ascii_mismatch_nocase_(const char *s1, const char *s2, int len);
+    int NPK_utf8_decode_(const char *s, int len, uint32_t *cp);
+    bool NPK_utf8_valid_(const char *s, int len);
+    uint64_t NPK_hash_bytes_(const void *p, int len, bool nocase);
+
+    uint32_t NPK_parse_eight_digits_(uint64_t w);
+    NPK_parse_result NPK_parse_integer_(const char *s, int len, uint64_t *mag, bool *negative);
+    NPK_parse_result NPK_parse_int64_(const char *s, int len, int64_t *val);
+    NPK_parse_result NPK_parse_uint64_(const char *s, int len, uint64_t *val);
+    NPK_parse_result NPK_parse_real_(const char *s, int len, double *val, bool single);
+    double NPK_eisel_lemire_(uint64_t w, int q, bool single);
+
+    // The decimal digits of a number whose decimal point comes after the first "point" of them, exact up to 800 digits,
+    // "truncated" records that nonzero digits past those were dropped
+    typedef struct {
+        int len;
+        int point;
+        bool truncated;
+        uint8_t digits[800];
+    } NPK_decimal_;
+
+    void NPK_decimal_shift_(NPK_decimal_ *d, int bits);
+    bool NPK_decimal_round_up_(const NPK_decimal_ *d, int nd);
+    long double NPK_parse_decimal_(const char *s, int len, int mant_dig, int min_exp, int max_exp);
+
+    // Arbitrary precision unsigned integers, just big enough to hold any double scaled by a power of ten
+    typedef struct {
+        int len;
+        uint32_t words[40];
+    } NPK_bignum_;
+
+    void NPK_bignum_set_(NPK_bignum_ *b, uint64_t val);
+    void NPK_bignum_mul_(NPK_bignum_ *b, uint32_t val);
+    void NPK_bignum_mul_pow10_(NPK_bignum_ *b, int exp);
+    void NPK_bignum_shl_(NPK_bignum_ *b, int bits);
+    void NPK_bignum_add_(NPK_bignum_ *b1, const NPK_bignum_ *b2);
+    void NPK_bignum_sub_(NPK_bignum_ *b1, const NPK_bignum_ *b2);
+    int NPK_bignum_compare_(const NPK_bignum_ *b1, const NPK_bignum_ *b2);
+
+    #define NPK_format_dbl_maxlen_ 32
+    int NPK_format_uint64_(char *buf, uint64_t val);
+    int NPK_format_int64_(char *buf, int64_t val);
+    int NPK_format_dbl_digits_(char *digits, double val, int *point);
+    int NPK_format_dbl_(char *buf, double val);
+
     #define NPK_array_new_(size) NPK_array_sized_new_(size, 2)
     NPK_array NPK_array_sized_new_(int size, int maxlen);
     NPK_array NPK_array_copy_new_(int size, const NPK_array *arr, int dim);
+    NPK_array NPK_array_fit_copy_new_(int size, const NPK_array *arr, int dim);
+    NPK_array NPK_array_capacity_copy_new_(int size, const NPK_array *arr, int dim, bool fit);
+    void NPK_array_slab_measure_(const NPK_array *arr, int dim, int64_t *headers, int64_t *elements);
+    void NPK_array_slab_fill_(int size, const NPK_array *arr, int dim, NPK_array *copy, uint8_t **headers, uint8_t **elements);
+    NPK_array NPK_array_slab_copy_new_(int size, const NPK_array *arr, int dim);
+    void NPK_array_shrink_to_fit_(int size, NPK_array *arr);
     NPK_array NPK_array_split_new_(int size, const NPK_array *arr, const void *delim, bool (*type_equals)(const void *p1, const void *p2));
     NPK_array NPK_array_dim_split_new_(int size, const NPK_array *arr, const void *delim, bool (*type_equals)(const void *p1, const void *p2), int dim);
     bool NPK_array_equals_(int size, const NPK_array *arr1, const NPK_array *arr2, bool (*type_equals)(const void *p1, const void *p2), int dim);
     bool NPK_array_contains_(int size, const NPK_array *arr, const void *val, bool (*type_equals)(const void *p1, const void *p2));
     bool NPK_array_dim_contains_(int size, const NPK_array *arr, const void *val, bool (*type_equals)(const void *p1, const void *p2), int dim);
     void NPK_array_add_(int size, NPK_array *arr, const void *val);
+    void NPK_array_reserve_(int size, NPK_array *arr, int maxlen);
     void NPK_array_replace_(int size, NPK_array *arr, const void *from, const void *to, bool (*type_equals)(const void *p1, const void *p2));
     void NPK_array_dim_replace_(int size, NPK_array *arr, const void *from, const void *to, bool (*type_equals)(const void *p1, const void *p2), int dim);
     void NPK_array_sort_(int size, NPK_array *arr, int (*type_compare)(const void *p1, const void *p2), int dim);
@@ -444,6 +1746,17 @@ limitations under the License.
     void NPK_array_remove_(int size, NPK_array *arr, const void *val, bool (*type_equals)(const void *p1, const void *p2));
     void NPK_array_dim_remove_(int size, NPK_array *arr, const void *val, bool (*type_equals)(const void *p1, const void *p2), int dim);
 
+    NPK_ndarray NPK_ndarray_new_(int size, int dim, const int *shape);
+    NPK_ndarray NPK_ndarray_from_array_new_(int size, const NPK_array *arr, int dim);
+    void NPK_ndarray_shape_from_(const NPK_array *arr, int depth, int dim, int *shape);
+    void NPK_ndarray_copy_from_(int size, NPK_ndarray *nd, const NPK_array *arr, int depth, int offset);
+    NPK_ndarray NPK_ndarray_copy_new_(int size, const NPK_ndarray *nd);
+    void *NPK_ndarray_at_(int size, const NPK_ndarray *nd, const int *idx);
+    NPK_array NPK_ndarray_row_(int size, const NPK_ndarray *nd, int idx);
+    bool NPK_ndarray_equals_(int size, const NPK_ndarray *nd1, const NPK_ndarray *nd2, bool (*type_equals)(const void *p1, const void *p2));
+    void NPK_ndarray_sort_(int size, NPK_ndarray *nd, int (*type_compare)(const void *p1, const void *p2));
+    void NPK_ndarray_fill_(int size, NPK_ndarray *nd, const void *val);
+
     #define NPK_map_new_(size) NPK_map_sized_new_(size, 9)
     NPK_map NPK_map_sized_new_(int size, int maxlen);
     NPK_map NPK_map_copy_new_(int size, const NPK_map *m, int dim);
@@ -453,22 +1766,565 @@ limitations under the License.
     void *NPK_map_get_(int size, const NPK_map *m, const void *key);
     bool NPK_map_equals_(int size, const NPK_map *m1, const NPK_map *m2, bool (*type_equals)(const void *p1, const void *p2));
     bool NPK_map_contains_value_(int size, const NPK_map *m, const void *val, bool (*type_equals)(const void *p1, const void *p2), int dim);
-#endif
+    bool NPK_map_erase_(int size, NPK_map *m, const void *key);
+
+    // Asks for the cache line at "p" ahead of its use, it is only a hint and does nothing where it isn't available
+    #if defined NPK_SSE2_
+        #define NPK_prefetch_(p) _mm_prefetch(NPK_cast(const char *, p), _MM_HINT_T0)
+    #elif defined __GNUC__
+        #define NPK_prefetch_(p) __builtin_prefetch(p)
+    #else
+        #define NPK_prefetch_(p) ((void) 0)
+    #endif
 
-#if defined NPK_DS_IMPL
-    #undef NPK_DS_IMPL
+    // Keys are hashed and prefetched this many at a time by the batched map operations
+    #define NPK_map_batch_ 16
+
+    #define NPK_map_home_(m, key) NPK_cast(int, NPK_cast(int64_t, key) % (m)->keys.maxlen)
+    int NPK_map_grown_maxlen_(int maxlen, int count);
+    void NPK_map_rehash_(int size, NPK_map *m, int maxlen);
+    void NPK_map_reserve_(int size, NPK_map *m, int count);
+    NPK_map NPK_map_from_arrays_new_(int size, const NPK_array *keys, const NPK_array *values);
+    int NPK_map_find_(const NPK_map *m, const void *key, int idx);
+    int NPK_map_slot_(const NPK_map *m, const void *key, int idx);
+    void NPK_map_merge_(int size, NPK_map *m, const NPK_map *other, void (*merge)(void *val, const void *other_val, void *ctx), void *ctx);
+    int NPK_map_get_many_(int size, const NPK_map *m, const NPK_array *keys, NPK_array *out);
+    void NPK_map_add_many_(int size, NPK_map *m, const NPK_array *keys, const NPK_array *values);
+
+    NPK_cmap NPK_cmap_new_(int size, int shards);
+    NPK_cmap_shard_ *NPK_cmap_shard_of_(const NPK_cmap *cm, const void *key);
+    void NPK_cmap_add_(NPK_cmap *cm, void *key, const void *val);
+
+    int NPK_ceil_pow2_(int n);
+    NPK_ring NPK_ring_sized_new_(int size, int maxlen);
+    void *NPK_ring_at_(int size, const NPK_ring *r, int idx);
+    void NPK_ring_push_(int size, NPK_ring *r, const void *val, bool front);
+    bool NPK_ring_pop_(int size, NPK_ring *r, void *val, bool front);
+
+    #if defined NPK_ATOMICS_
+        NPK_spsc_queue NPK_spsc_queue_new_(int size, int maxlen);
+        NPK_mpmc_queue NPK_mpmc_queue_new_(int size, int maxlen);
+        void NPK_ring_copy_in_(int size, NPK_array *slots, size_t pos, const void *vals, int n);
+        void NPK_ring_copy_out_(int size, const NPK_array *slots, size_t pos, void *vals, int n);
+    #endif
 
-    // ==================
-    // NPK IMPLEMENTATION
-    // ==================
+    #define NPK_pool_grain_(size) (65536 / (size) > 0 ? 65536 / (size) : 1)
+    int NPK_cpu_count_(void);
+    bool NPK_pool_take_(struct NPK_pool_state_ *state, int self, void *task);
+    int NPK_pool_work_(void *worker);
+    void NPK_array_parallel_for_(int size, NPK_pool *pool, const NPK_array *arr, void (*fn)(void *chunk, int len, void *ctx), void *ctx);
+    NPK_array NPK_array_parallel_map_new_(int size, int out_size, NPK_pool *pool, const NPK_array *arr, void (*fn)(const void *in, void *out, int len, void *ctx), void *ctx);
+    void NPK_array_parallel_reduce_(int size, int acc_size, NPK_pool *pool, const NPK_array *arr, void *acc, void (*reduce)(const void *chunk, int len, void *partial, void *ctx), void (*merge)(void *acc, const void *partial, void *ctx), void *ctx);
+    NPK_array NPK_array_parallel_filter_new_(int size, NPK_pool *pool, const NPK_array *arr, bool (*keep)(const void *elem, void *ctx), void *ctx);
+    void NPK_array_parallel_sort_(int size, NPK_pool *pool, NPK_array *arr, int (*type_compare)(const void *p1, const void *p2));
+    NPK_array NPK_array_parallel_copy_new_(int size, NPK_pool *pool, const NPK_array *arr, int dim);
+    void NPK_parallel_for_range_(void *ctx, int begin, int end);
+    void NPK_parallel_map_range_(void *ctx, int begin, int end);
+    void NPK_parallel_reduce_range_(void *ctx, int begin, int end);
+    void NPK_parallel_filter_range_(void *ctx, int begin, int end);
+    void NPK_parallel_sort_range_(void *ctx, int begin, int end);
+    void NPK_parallel_merge_range_(void *ctx, int begin, int end);
+    void NPK_parallel_copy_range_(void *ctx, int begin, int end);
+
+    NPK_heap NPK_heap_new_(int size, int (*type_compare)(const void *p1, const void *p2), int arity, int limit, bool indexed);
+    NPK_heap NPK_heap_from_array_new_(int size, const NPK_array *arr, int (*type_compare)(const void *p1, const void *p2));
+    int NPK_heap_push_(NPK_heap *h, const void *val);
+    void NPK_heap_update_(NPK_heap *h, int handle, const void *val);
+    void NPK_heap_move_(NPK_heap *h, int from, int to);
+    void NPK_heap_sift_up_(NPK_heap *h, int pos);
+    void NPK_heap_sift_down_(NPK_heap *h, int pos);
+    void NPK_heap_remove_at_(NPK_heap *h, int pos, void *val);
+
+    #define NPK_bitset_word_count_(len) (((len) + 63) / 64)
+    #define NPK_bitset_tail_mask_(len) ((len) % 64 == 0 ? UINT64_MAX : (UINT64_C(1) << ((len) % 64)) - 1)
+
+    // The odd multipliers that pick the bit of every word of a Bloom filter block
+    #define NPK_bloom_salts_ 0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du, 0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u
+
+    double NPK_bloom_rate_(double load);
+    uint32_t *NPK_bloom_block_(const NPK_bloom *bf, uint64_t hash);
+    NPK_bloom NPK_bloom_from_array_new_(int size, const NPK_array *arr, double fpr);
+    void NPK_bloom_add_(NPK_bloom *bf, const void *p, int len);
+    bool NPK_bloom_contains_(const NPK_bloom *bf, const void *p, int len);
+    void *NPK_map_filtered_get_(int size, const NPK_map *m, const NPK_bloom *bf, const void *key);
+    void NPK_map_filtered_add_(int size, NPK_map *m, NPK_bloom *bf, void *key, const void *val);
+
+    // The hooks that the containers call, which only exist with NPK_DS_STATS
+    #if defined NPK_DS_STATS
+        #if defined NPK_ATOMICS_
+            typedef _Atomic int64_t NPK_stats_counter_;
+            #define NPK_stats_add_(counter, n) atomic_fetch_add_explicit(&NPK_stats_state_.counter, n, memory_order_relaxed)
+        #else
+            typedef int64_t NPK_stats_counter_;
+            #define NPK_stats_add_(counter, n) (NPK_stats_state_.counter += (n))
+        #endif
+
+        // Same members as NPK_stats, with counters that many threads can update at once
+        typedef struct {
+            NPK_stats_counter_ allocs[NPK_stats_kind_count];
+            NPK_stats_counter_ bytes[NPK_stats_kind_count];
+            NPK_stats_counter_ reallocs[NPK_stats_kind_count];
+            NPK_stats_counter_ realloc_copies[NPK_stats_kind_count];
+            NPK_stats_counter_ copied_bytes[NPK_stats_kind_count];
+            NPK_stats_counter_ map_lookups;
+            NPK_stats_counter_ map_probes;
+            NPK_stats_counter_ map_probe_histogram[NPK_stats_probe_buckets];
+            NPK_stats_counter_ map_rehashes;
+            NPK_stats_counter_ map_rehashed_keys;
+        } NPK_stats_counters_;
+
+        extern NPK_stats_counters_ NPK_stats_state_;
+
+        #define NPK_stats_alloc_(kind, n) (NPK_stats_add_(allocs[kind], 1), NPK_stats_add_(bytes[kind], n))
+        #define NPK_stats_rehash_(keys) (NPK_stats_add_(map_rehashes, 1), NPK_stats_add_(map_rehashed_keys, keys))
+        void NPK_stats_realloc_(NPK_stats_kind kind, bool moved, int64_t old_bytes, int64_t new_bytes);
+        void NPK_stats_probe_(int64_t probes);
+    #else
+        #define NPK_stats_alloc_(kind, n) ((void) 0)
+        #define NPK_stats_rehash_(keys) ((void) 0)
+        #define NPK_stats_realloc_(kind, moved, old_bytes, new_bytes) ((void) 0)
+        #define NPK_stats_probe_(probes) ((void) 0)
+    #endif
 
-    void NPK_swap_(int size, void *p1, void *p2) {
-        void *tmp = alloca(size);
+    // Every snapshot file starts with this header, the sections of the body follow it aligned to NPK_snapshot_align_
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t kind;
+        uint32_t dim;
+        uint32_t size;
+        uint32_t reserved;
+        int64_t len;
+        int64_t keys_len;
+        uint64_t body_bytes;
+        uint64_t checksum;
+    } NPK_snapshot_header_;
+
+    #define NPK_snapshot_magic_ "NPKSNAP"
+    #define NPK_snapshot_version_ 2
+    #define NPK_snapshot_align_ 64
+    #define NPK_snapshot_chunk_ 65536
+    #define NPK_snapshot_padded_(bytes) (((bytes) + NPK_snapshot_align_ - 1) / NPK_snapshot_align_ * NPK_snapshot_align_)
+
+    // Buffers the body while it is written, the checksum is computed one full chunk at a time
+    typedef struct {
+        FILE *f;
+        uint8_t *buf;
+        int used;
+        uint64_t bytes;
+        uint64_t checksum;
+        bool ok;
+    } NPK_snapshot_writer_;
+
+    uint64_t NPK_snapshot_checksum_(uint64_t checksum, const void *p, int len);
+    bool NPK_snapshot_begin_(NPK_snapshot_writer_ *w, const NPK_cstring *path);
+    void NPK_snapshot_put_(NPK_snapshot_writer_ *w, const void *p, uint64_t len);
+    void NPK_snapshot_pad_(NPK_snapshot_writer_ *w);
+    bool NPK_snapshot_end_(NPK_snapshot_writer_ *w, NPK_snapshot_header_ *header);
+    void NPK_snapshot_put_level_(NPK_snapshot_writer_ *w, const NPK_array *arr, int depth, int level, uint64_t *total);
+    void NPK_snapshot_put_leaves_(NPK_snapshot_writer_ *w, int size, const NPK_array *arr, int depth, int dim);
+    bool NPK_snapshot_write_(const NPK_cstring *path, NPK_snapshot_kind kind, int size, const NPK_array *arr, int dim);
+    bool NPK_snapshot_write_map_(const NPK_cstring *path, int size, const NPK_map *m);
+    bool NPK_snapshot_parse_(NPK_snapshot *snap, bool verify);
+    NPK_array NPK_snapshot_copy_level_(const NPK_snapshot *snap, const uint64_t **levels, int level, uint64_t begin, uint64_t end);
+
+    // A node is a record of "leaf_bytes" or "inner_bytes", rounded up to whole cache lines, that starts with its count of keys
+    // A leaf follows it with the index of the next leaf, its keys and its values, an inner node with its keys and its children
+    // The keys of a node take about NPK_btree_key_bytes_, and nothing but the root is ever less than half full
+    #define NPK_btree_key_bytes_ 256
+    #define NPK_btree_header_ 16
+    #define NPK_btree_max_height_ 32
+
+    #define NPK_btree_leaf_(bt, idx) (NPK_array_data(uint8_t, &(bt)->leaves) + NPK_cast(size_t, idx) * (bt)->leaf_bytes)
+    #define NPK_btree_inner_(bt, idx) (NPK_array_data(uint8_t, &(bt)->inners) + NPK_cast(size_t, idx) * (bt)->inner_bytes)
+    #define NPK_btree_count_(node) (NPK_cast(int *, node)[0])
+    #define NPK_btree_next_(node) (NPK_cast(int *, node)[1])
+    #define NPK_btree_keys_(node) ((node) + NPK_btree_header_)
+    #define NPK_btree_values_(bt, node) ((node) + (bt)->values_offset)
+    #define NPK_btree_children_(bt, node) NPK_cast(int *, (node) + (bt)->children_offset)
+
+    NPK_btree NPK_btree_new_(int key_size, int size, int (*type_compare)(const void *p1, const void *p2));
+    NPK_btree NPK_btree_from_arrays_new_(int key_size, int size, const NPK_array *keys, const NPK_array *values, int (*type_compare)(const void *p1, const void *p2));
+    int NPK_btree_node_new_(NPK_btree *bt, bool leaf);
+    int NPK_btree_search_(const NPK_btree *bt, const uint8_t *node, const void *key, bool upper);
+    void *NPK_btree_get_(const NPK_btree *bt, const void *key);
+    void NPK_btree_add_(NPK_btree *bt, const void *key, const void *val);
+    void NPK_btree_split_(NPK_btree *bt, const int *path, const int *slots, int leaf, int pos, const void *key, const void *val, bool append);
+    bool NPK_btree_remove_(NPK_btree *bt, const void *key);
+    void NPK_btree_rebalance_(NPK_btree *bt, int parent, int slot, bool leaf);
+    NPK_btree_cursor NPK_btree_seek_(const NPK_btree *bt, const void *key, bool upper);
+    bool NPK_btree_cursor_before_(const NPK_btree_cursor *cur, const void *key);
+
+    NPK_iter NPK_iter_stage_(int size, bool (*next)(NPK_iter *it, void *out), NPK_iter *src);
+    NPK_iter NPK_iter_array_(int size, const NPK_array *arr);
+    NPK_iter NPK_iter_map_(int size, NPK_iter *src, void (*fn)(const void *in, void *out, void *ctx), void *ctx);
+    bool NPK_iter_array_next_(NPK_iter *it, void *out);
+    bool NPK_iter_split_next_(NPK_iter *it, void *out);
+    bool NPK_iter_lines_next_(NPK_iter *it, void *out);
+    bool NPK_iter_code_points_next_(NPK_iter *it, void *out);
+    bool NPK_iter_filter_next_(NPK_iter *it, void *out);
+    bool NPK_iter_map_next_(NPK_iter *it, void *out);
+    bool NPK_iter_take_next_(NPK_iter *it, void *out);
+    bool NPK_iter_skip_next_(NPK_iter *it, void *out);
+    bool NPK_iter_chunk_next_(NPK_iter *it, void *out);
+
+    // Everything about a request from the moment it is queued until its callback runs
+    typedef struct {
+        NPK_array *arr;
+        void (*done)(NPK_array *arr, bool ok, void *ctx);
+        void *ctx;
+        NPK_string path;
+        int64_t offset;
+        int64_t bytes;
+
+        #if defined NPK_POSIX_
+            int fd;
+        #else
+            FILE *f;
+        #endif
+
+        bool write;
+        bool ok;
+    } NPK_aio_request_;
+
+    // The blocking backends only keep as many requests in flight as they have workers
+    #define NPK_aio_max_workers_ 16
+
+    void NPK_aio_submit_(NPK_aio *aio, const NPK_cstring *path, NPK_array *arr, bool write, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx);
+    void NPK_aio_start_(struct NPK_aio_state_ *state);
+    bool NPK_aio_open_(NPK_aio_request_ *req);
+    void NPK_aio_transfer_(NPK_aio_request_ *req);
+    void NPK_aio_finish_(struct NPK_aio_state_ *state, int slot);
+    int NPK_aio_complete_(struct NPK_aio_state_ *state, bool wait);
+
+    #if defined NPK_IO_URING_
+        bool NPK_aio_uring_new_(struct NPK_aio_state_ *state, int depth);
+        void NPK_aio_uring_del_(struct NPK_aio_state_ *state);
+        void NPK_aio_prep_(struct NPK_aio_state_ *state, int slot);
+        void NPK_aio_enter_(struct NPK_aio_state_ *state, bool wait);
+    #endif
 
-        memcpy(tmp, p1, size);
-        memcpy(p1, p2, size);
-        memcpy(p2, tmp, size);
-    }
+    #if defined NPK_THREADS_
+        int NPK_aio_work_(void *p);
+    #endif
+
+    // References to nodes keep the index of a node in the pool of its kind above the kind, so that 0 is no node
+    enum {
+        NPK_radix_leaf_kind_ = 1,
+        NPK_radix_node4_kind_,
+        NPK_radix_node16_kind_,
+        NPK_radix_node48_kind_,
+        NPK_radix_node256_kind_
+    };
+
+    // Compressed paths of up to NPK_radix_inline_ bytes live in the node, longer ones are an offset into the bytes of a key
+    #define NPK_radix_inline_ 8
+
+    typedef struct {
+        uint32_t prefix_len;
+        uint16_t count;
+        union {
+            uint8_t bytes[NPK_radix_inline_];
+            int64_t offset;
+        } prefix;
+    } NPK_radix_header_;
+
+    typedef struct {
+        NPK_radix_header_ h;
+        uint8_t keys[4];
+        uint32_t children[4];
+    } NPK_radix_node4_;
+
+    typedef struct {
+        NPK_radix_header_ h;
+        uint8_t keys[16];
+        uint32_t children[16];
+    } NPK_radix_node16_;
+
+    // "index" maps a byte to one more than the position of its child, so 0 is no child
+    typedef struct {
+        NPK_radix_header_ h;
+        uint8_t index[256];
+        uint32_t children[48];
+    } NPK_radix_node48_;
+
+    typedef struct {
+        NPK_radix_header_ h;
+        uint32_t children[256];
+    } NPK_radix_node256_;
+
+    // The value of a leaf follows it, and its key is an offset into the blocks with the block in the high 32 bits
+    typedef struct {
+        int64_t key;
+        int len;
+    } NPK_radix_leaf_;
+
+    #define NPK_radix_ref_(kind, idx) (NPK_cast(uint32_t, idx) << 3 | (kind))
+    #define NPK_radix_kind_(ref) NPK_cast(int, (ref) & 7)
+    #define NPK_radix_idx_(ref) ((ref) >> 3)
+    #define NPK_radix_kind_bytes_(t, kind) ((kind) == NPK_radix_leaf_kind_ ? (t)->leaf_bytes : (kind) == NPK_radix_node4_kind_ ? NPK_cast(int, sizeof(NPK_radix_node4_)) : (kind) == NPK_radix_node16_kind_ ? NPK_cast(int, sizeof(NPK_radix_node16_)) : (kind) == NPK_radix_node48_kind_ ? NPK_cast(int, sizeof(NPK_radix_node48_)) : NPK_cast(int, sizeof(NPK_radix_node256_)))
+    #define NPK_radix_node_(t, ref) (NPK_array_data(uint8_t, &(t)->pools[NPK_radix_kind_(ref) - 1]) + NPK_cast(size_t, NPK_radix_idx_(ref)) * NPK_radix_kind_bytes_(t, NPK_radix_kind_(ref)))
+    #define NPK_radix_header_at_(t, ref) NPK_cast(NPK_radix_header_ *, NPK_radix_node_(t, ref))
+    #define NPK_radix_leaf_at_(t, ref) NPK_cast(NPK_radix_leaf_ *, NPK_radix_node_(t, ref))
+    #define NPK_radix_value_(t, ref) (NPK_radix_node_(t, ref) + sizeof(NPK_radix_leaf_))
+    #define NPK_radix_key_(t, offset) (NPK_array_data(uint8_t, NPK_array_data(NPK_array, &(t)->blocks) + ((offset) >> 32)) + ((offset) & 0xFFFFFFFF))
+    #define NPK_radix_prefix_(t, h) ((h)->prefix_len <= NPK_radix_inline_ ? (h)->prefix.bytes : NPK_radix_key_(t, (h)->prefix.offset))
+
+    NPK_radix NPK_radix_new_(int size);
+    void NPK_radix_reserve_(NPK_radix *t);
+    uint32_t NPK_radix_alloc_(NPK_radix *t, int kind);
+    void NPK_radix_free_(NPK_radix *t, uint32_t ref);
+    uint32_t NPK_radix_leaf_new_(NPK_radix *t, const char *key, int len, const void *val);
+    bool NPK_radix_leaf_matches_(const NPK_radix *t, uint32_t ref, const char *key, int len);
+    uint32_t NPK_radix_any_leaf_(const NPK_radix *t, uint32_t ref);
+    void NPK_radix_set_prefix_(NPK_radix_header_ *h, const uint8_t *bytes, int64_t offset, uint32_t len);
+    uint32_t *NPK_radix_child_(const NPK_radix *t, uint32_t ref, uint8_t byte);
+    void NPK_radix_add_child_(NPK_radix *t, uint32_t *slot, uint8_t byte, uint32_t child);
+    void NPK_radix_remove_child_(NPK_radix *t, uint32_t *slot, uint8_t byte, int depth);
+    void *NPK_radix_get_(const NPK_radix *t, const char *key, int len);
+    void NPK_radix_add_(NPK_radix *t, const char *key, int len, const void *val);
+    bool NPK_radix_remove_(NPK_radix *t, const char *key, int len);
+    void NPK_radix_entry_(const NPK_radix *t, uint32_t ref, NPK_radix_entry *out);
+    bool NPK_radix_iter_next_(NPK_iter *it, void *out);
+
+    // Inputs are split into chunks of about NPK_csv_chunk_ bytes to be parsed in parallel
+    #define NPK_csv_chunk_ (1 << 20)
+
+    // Everything the chunks of a parallel parse share
+    typedef struct {
+        const char *data;
+        int64_t len;
+        const char *types;
+        char delim;
+        int64_t *bounds;
+        int *quotes;
+        NPK_csv *parts;
+    } NPK_csv_task_;
+
+    NPK_csv NPK_csv_empty_(const NPK_cstring *types);
+    int64_t NPK_csv_next_(const char *data, int64_t pos, int64_t end, char delim);
+    int64_t NPK_csv_record_end_(const char *data, int64_t pos, int64_t end, bool quoted);
+    void NPK_csv_field_(NPK_csv *csv, int col, const char *s, int len);
+    void NPK_csv_parse_chunk_(NPK_csv *csv, const char *data, int64_t begin, int64_t end, char delim, NPK_string *scratch);
+    void NPK_csv_count_quotes_(void *ctx, int begin, int end);
+    void NPK_csv_parse_part_(void *ctx, int begin, int end);
+    void NPK_csv_append_(NPK_csv *csv, const NPK_csv *part);
+#endif
+
+#if defined NPK_DS_IMPL
+    #undef NPK_DS_IMPL
+
+    // ==================
+    // NPK IMPLEMENTATION
+    // ==================
+
+    void NPK_swap_(int size, void *p1, void *p2) {
+        void *tmp = alloca(size);
+
+        memcpy(tmp, p1, size);
+        memcpy(p1, p2, size);
+        memcpy(p2, tmp, size);
+    }
+
+    #if !defined __GNUC__
+        int NPK_popcount64_(uint64_t x) {
+            x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+            x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+            x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+
+            return NPK_cast(int, (x * UINT64_C(0x0101010101010101)) >> 56);
+        }
+
+        int NPK_ctz64_(uint64_t x) {
+            return NPK_popcount64_((x & (~x + 1)) - 1);
+        }
+
+        int NPK_clz64_(uint64_t x) {
+            x |= x >> 1;
+            x |= x >> 2;
+            x |= x >> 4;
+            x |= x >> 8;
+            x |= x >> 16;
+            x |= x >> 32;
+
+            return NPK_popcount64_(~x);
+        }
+    #endif
+
+    // Multiplies two 64 bit numbers into the low half of the 128 bit product, which is returned, and the high half
+    uint64_t NPK_mul128_(uint64_t a, uint64_t b, uint64_t *hi) {
+        #if defined __SIZEOF_INT128__
+            __extension__ unsigned __int128 p = NPK_cast(unsigned __int128, a) * b;
+
+            *hi = NPK_cast(uint64_t, p >> 64);
+
+            return NPK_cast(uint64_t, p);
+        #else
+            uint64_t ll = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+            uint64_t lh = (a & 0xFFFFFFFF) * (b >> 32);
+            uint64_t hl = (a >> 32) * (b & 0xFFFFFFFF);
+            uint64_t hh = (a >> 32) * (b >> 32);
+            uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+
+            *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+            return (mid << 32) | (ll & 0xFFFFFFFF);
+        #endif
+    }
+
+    // SWAR (SIMD within a register) helpers, that treat an uint64_t as 8 independent bytes
+    #define swar_ones UINT64_C(0x0101010101010101)
+    #define swar_high UINT64_C(0x8080808080808080)
+
+    // Sets the high bit of every byte of "w" that is an ASCII character within [lo, hi]
+    #define swar_in_range(w, lo, hi) ((((w) & ~swar_high) + swar_ones * (128 - (lo))) & ~(((w) & ~swar_high) + swar_ones * (127 - (hi))) & ~(w) & swar_high)
+
+    // Same as swar_in_range but for 16 or 32 signed bytes at once, every byte in range becomes 0xFF
+    #define sse2_in_range(v, lo, hi) _mm_cmpgt_epi8(_mm_add_epi8(v, _mm_set1_epi8(127 - (hi))), _mm_set1_epi8(126 - ((hi) - (lo))))
+    #define avx2_in_range(v, lo, hi) _mm256_cmpgt_epi8(_mm256_add_epi8(v, _mm256_set1_epi8(127 - (hi))), _mm256_set1_epi8(126 - ((hi) - (lo))))
+
+    #define char_fold(c) NPK_char_to_lower(c)
+
+    void NPK_ascii_case_(char *s, int len, bool upper) {
+        char lo = upper ? 'a' : 'A';
+        char hi = upper ? 'z' : 'Z';
+        int i = 0;
+
+        // Flipping bit 0x20 converts between lowercase and uppercase letters
+        #if defined NPK_AVX2_
+            for (; i + 32 <= len; i += 32) {
+                __m256i v = _mm256_loadu_si256(NPK_cast(const __m256i *, s + i));
+                __m256i flip = _mm256_and_si256(avx2_in_range(v, lo, hi), _mm256_set1_epi8(0x20));
+
+                _mm256_storeu_si256(NPK_cast(__m256i *, s + i), _mm256_xor_si256(v, flip));
+            }
+        #endif
+
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, s + i));
+                __m128i flip = _mm_and_si128(sse2_in_range(v, lo, hi), _mm_set1_epi8(0x20));
+
+                _mm_storeu_si128(NPK_cast(__m128i *, s + i), _mm_xor_si128(v, flip));
+            }
+        #endif
+
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+
+            memcpy(&w, s + i, 8);
+            w ^= (upper ? swar_in_range(w, 'a', 'z') : swar_in_range(w, 'A', 'Z')) >> 2;
+            memcpy(s + i, &w, 8);
+        }
+
+        for (; i < len; i++) {
+            if (s[i] >= lo && s[i] <= hi) {
+                s[i] ^= 0x20;
+            }
+        }
+    }
+
+    int NPK_ascii_mismatch_nocase_(const char *s1, const char *s2, int len) {
+        int i = 0;
+
+        #if defined NPK_AVX2_
+            for (; i + 32 <= len; i += 32) {
+                __m256i v1 = _mm256_loadu_si256(NPK_cast(const __m256i *, s1 + i));
+                __m256i v2 = _mm256_loadu_si256(NPK_cast(const __m256i *, s2 + i));
+
+                v1 = _mm256_or_si256(v1, _mm256_and_si256(avx2_in_range(v1, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+                v2 = _mm256_or_si256(v2, _mm256_and_si256(avx2_in_range(v2, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+
+                uint32_t eq = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2));
+
+                if (eq != UINT32_MAX) {
+                    return i + NPK_ctz64_(~eq);
+                }
+            }
+        #endif
+
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v1 = _mm_loadu_si128(NPK_cast(const __m128i *, s1 + i));
+                __m128i v2 = _mm_loadu_si128(NPK_cast(const __m128i *, s2 + i));
+
+                v1 = _mm_or_si128(v1, _mm_and_si128(sse2_in_range(v1, 'A', 'Z'), _mm_set1_epi8(0x20)));
+                v2 = _mm_or_si128(v2, _mm_and_si128(sse2_in_range(v2, 'A', 'Z'), _mm_set1_epi8(0x20)));
+
+                int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+
+                if (eq != 0xFFFF) {
+                    return i + NPK_ctz64_(~eq);
+                }
+            }
+        #endif
+
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w1;
+            uint64_t w2;
+
+            memcpy(&w1, s1 + i, 8);
+            memcpy(&w2, s2 + i, 8);
+
+            // The exact byte is found by the scalar loop, which keeps this endianness agnostic
+            if ((w1 | swar_in_range(w1, 'A', 'Z') >> 2) != (w2 | swar_in_range(w2, 'A', 'Z') >> 2)) {
+                break;
+            }
+        }
+
+        for (; i < len; i++) {
+            if (char_fold(s1[i]) != char_fold(s2[i])) {
+                return i;
+            }
+        }
+
+        return len;
+    }
+
+    uint64_t NPK_hash_bytes_(const void *p, int len, bool nocase) {
+        const uint8_t *bytes = p;
+        uint64_t h = UINT64_C(0x9E3779B97F4A7C15) ^ (NPK_cast(uint64_t, len) * UINT64_C(0xC2B2AE3D27D4EB4F));
+        uint64_t w;
+        int i = 0;
+
+        #define mix(h, w)                                              \
+        w *= UINT64_C(0x87C37B91114253D5);                             \
+        w = (w << 31) | (w >> 33);                                     \
+        h ^= w * UINT64_C(0x4CF5AD432745937F);                         \
+        h = ((h << 27) | (h >> 37)) * 5 + UINT64_C(0x52DCE729);
+
+        for (; i + 8 <= len; i += 8) {
+            memcpy(&w, bytes + i, 8);
+
+            if (nocase) {
+                w |= swar_in_range(w, 'A', 'Z') >> 2;
+            }
+
+            mix(h, w)
+        }
+
+        if (i < len) {
+            w = 0;
+            memcpy(&w, bytes + i, len - i);
+
+            if (nocase) {
+                w |= swar_in_range(w, 'A', 'Z') >> 2;
+            }
+
+            mix(h, w)
+        }
+
+        #undef mix
+
+        h ^= h >> 33;
+        h *= UINT64_C(0xFF51AFD7ED558CCD);
+        h ^= h >> 33;
+        h *= UINT64_C(0xC4CEB9FE1A85EC53);
+        h ^= h >> 33;
+
+        return h;
+    }
 
     void NPK_file_write_bytes(const NPK_cstring *path, const NPK_array *arr) {
         FILE *f = fopen(path, "wb");
@@ -527,30 +2383,103 @@ limitations under the License.
         arr.len = 0;
         arr.maxlen = maxlen;
         arr.data = malloc(maxlen * size);
+        NPK_stats_alloc_(NPK_stats_array, NPK_cast(int64_t, maxlen) * size);
 
         return arr;
     }
 
     NPK_array NPK_array_copy_new_(int size, const NPK_array *arr, int dim) {
-        NPK_array copy;
+        return NPK_array_capacity_copy_new_(size, arr, dim, false);
+    }
+
+    NPK_array NPK_array_fit_copy_new_(int size, const NPK_array *arr, int dim) {
+        return NPK_array_capacity_copy_new_(size, arr, dim, true);
+    }
+
+    NPK_array NPK_array_capacity_copy_new_(int size, const NPK_array *arr, int dim, bool fit) {
+        int maxlen = fit ? (NPK_array_length(arr) > 0 ? NPK_array_length(arr) : 1) : arr->maxlen;
+        NPK_array copy = NPK_array_sized_new_(dim > 1 ? NPK_cast(int, NPK_sizeof_type(NPK_array)) : size, maxlen);
+
+        // The capacity beyond "len" holds nothing, so it is never copied
+        if (dim > 1) {
+            NPK_count_up (i, 0, NPK_array_length(arr)) {
+                NPK_array_data(NPK_array, &copy)[i] = NPK_array_capacity_copy_new_(size, NPK_array_data(NPK_array, arr) + i, dim - 1, fit);
+            }
+        } else {
+            memcpy(copy.data, arr->data, NPK_array_length(arr) * size);
+        }
+
+        copy.len = NPK_array_length(arr);
 
+        return copy;
+    }
+
+    void NPK_array_slab_measure_(const NPK_array *arr, int dim, int64_t *headers, int64_t *elements) {
         if (dim > 1) {
-            copy = NPK_array_sized_new(NPK_array, arr->maxlen);
+            *headers += NPK_array_length(arr);
 
-            NPK_for_each (NPK_array, elem, arr) {
-                NPK_array lcopy = NPK_array_copy_new_(size, elem, dim - 1);
+            NPK_count_up (i, 0, NPK_array_length(arr)) {
+                NPK_array_slab_measure_(NPK_array_data(NPK_array, arr) + i, dim - 1, headers, elements);
+            }
+        } else {
+            *elements += NPK_array_length(arr);
+        }
+    }
 
-                NPK_array_add(NPK_array, &copy, lcopy);
+    void NPK_array_slab_fill_(int size, const NPK_array *arr, int dim, NPK_array *copy, uint8_t **headers, uint8_t **elements) {
+        copy->len = NPK_array_length(arr);
+        copy->maxlen = NPK_array_length(arr);
+
+        // The inner arrays of every array are taken together, so they stay contiguous like in an ordinary array
+        if (dim > 1) {
+            copy->data = *headers;
+            *headers += NPK_array_length(arr) * NPK_sizeof_type(NPK_array);
+
+            NPK_count_up (i, 0, NPK_array_length(arr)) {
+                NPK_array_slab_fill_(size, NPK_array_data(NPK_array, arr) + i, dim - 1, NPK_array_data(NPK_array, copy) + i, headers, elements);
             }
         } else {
-            copy = NPK_array_sized_new_(size, arr->maxlen);
-            copy.len = NPK_array_length(arr);
-            memcpy(copy.data, arr->data, arr->maxlen * size);
+            copy->data = *elements;
+            memcpy(*elements, arr->data, NPK_array_length(arr) * size);
+            *elements += NPK_array_length(arr) * size;
         }
+    }
+
+    NPK_array NPK_array_slab_copy_new_(int size, const NPK_array *arr, int dim) {
+        int64_t headers = 0;
+        int64_t elements = 0;
+        NPK_array copy;
+
+        NPK_array_slab_measure_(arr, dim, &headers, &elements);
+
+        // The arrays come first and the elements after them, aligned for any type
+        size_t headers_bytes = (headers * NPK_sizeof_type(NPK_array) + 15) / 16 * 16;
+        size_t bytes = headers_bytes + elements * size;
+        uint8_t *slab = malloc(bytes > 0 ? bytes : 1);
+        uint8_t *header_cursor = slab;
+        uint8_t *element_cursor = slab + headers_bytes;
+
+        NPK_stats_alloc_(NPK_stats_array, bytes);
+        NPK_array_slab_fill_(size, arr, dim, &copy, &header_cursor, &element_cursor);
 
         return copy;
     }
 
+    void NPK_array_shrink_to_fit_(int size, NPK_array *arr) {
+        int maxlen = NPK_array_length(arr) > 0 ? NPK_array_length(arr) : 1;
+
+        if (arr->maxlen > maxlen) {
+            #if defined NPK_DS_STATS
+                uintptr_t old_data = NPK_cast(uintptr_t, arr->data);
+                int old_maxlen = arr->maxlen;
+            #endif
+
+            arr->data = realloc(arr->data, maxlen * size);
+            arr->maxlen = maxlen;
+            NPK_stats_realloc_(NPK_stats_array, old_data != NPK_cast(uintptr_t, arr->data), NPK_cast(int64_t, old_maxlen) * size, NPK_cast(int64_t, arr->maxlen) * size);
+        }
+    }
+
     NPK_array NPK_array_split_new_(int size, const NPK_array *arr, const void *delim, bool (*type_equals) (const void *p1, const void *p2)) {
         NPK_array parts = NPK_array_new(NPK_array);
         NPK_array part = NPK_array_new_(size);
@@ -643,11 +2572,21 @@ limitations under the License.
         return false;
     }
 
-    void NPK_array_add_(int size, NPK_array *arr, const void *val) {
-        if (NPK_array_length(arr) == arr->maxlen) {
-            arr->maxlen *= 1.5;
+    void NPK_array_reserve_(int size, NPK_array *arr, int maxlen) {
+        if (arr->maxlen < maxlen) {
+            #if defined NPK_DS_STATS
+                uintptr_t old_data = NPK_cast(uintptr_t, arr->data);
+                int old_maxlen = arr->maxlen;
+            #endif
+
+            arr->maxlen = arr->maxlen * 1.5 > maxlen ? arr->maxlen * 1.5 : maxlen;
             arr->data = realloc(arr->data, arr->maxlen * size);
+            NPK_stats_realloc_(NPK_stats_array, old_data != NPK_cast(uintptr_t, arr->data), NPK_cast(int64_t, old_maxlen) * size, NPK_cast(int64_t, arr->maxlen) * size);
         }
+    }
+
+    void NPK_array_add_(int size, NPK_array *arr, const void *val) {
+        NPK_array_reserve_(size, arr, NPK_array_length(arr) + 1);
 
         void *cur = NPK_array_data(uint8_t, arr) + NPK_array_length(arr) * size;
 
@@ -680,14 +2619,12 @@ limitations under the License.
     }
 
     void NPK_array_sort_(int size, NPK_array *arr, int (*type_compare)(const void *p1, const void *p2), int dim) {
-        NPK_count_up(i, 0, NPK_array_length(arr)) {
-            if (dim > 1) {
-                NPK_array *cur = NPK_cast(NPK_array *, NPK_array_data(uint8_t, arr) + i * NPK_sizeof_type(NPK_array));
-
+        if (dim > 1) {
+            NPK_for_each (NPK_array, cur, arr) {
                 NPK_array_sort_(size, cur, type_compare, dim - 1);
-            } else {
-                qsort(arr->data, NPK_array_length(arr), size, type_compare);
             }
+        } else {
+            qsort(arr->data, NPK_array_length(arr), size, type_compare);
         }
     }
 
@@ -765,6 +2702,141 @@ limitations under the License.
         free(arr->data);
     }
 
+    NPK_ndarray NPK_ndarray_new_(int size, int dim, const int *shape) {
+        NPK_ndarray nd;
+
+        if (dim < 1 || dim > NPK_ndarray_max_dim) {
+            nd.dim = 0;
+            nd.len = 0;
+            nd.data = NULL;
+
+            return nd;
+        }
+
+        nd.dim = dim;
+        nd.len = 1;
+
+        // Row major order, the last dimension is the contiguous one
+        NPK_count_down (i, dim, 0) {
+            nd.shape[i] = shape[i];
+            nd.stride[i] = nd.len;
+            nd.len *= shape[i];
+        }
+
+        nd.data = calloc(nd.len > 0 ? nd.len : 1, size);
+        NPK_stats_alloc_(NPK_stats_ndarray, NPK_cast(int64_t, nd.len) * size);
+
+        return nd;
+    }
+
+    NPK_ndarray NPK_ndarray_from_array_new_(int size, const NPK_array *arr, int dim) {
+        int shape[NPK_ndarray_max_dim] = {0};
+
+        if (dim < 1 || dim > NPK_ndarray_max_dim) {
+            return NPK_ndarray_new_(size, dim, shape);
+        }
+
+        NPK_ndarray_shape_from_(arr, 0, dim, shape);
+
+        NPK_ndarray nd = NPK_ndarray_new_(size, dim, shape);
+
+        NPK_ndarray_copy_from_(size, &nd, arr, 0, 0);
+
+        return nd;
+    }
+
+    // Grows every length of the shape to the longest part of its dimension
+    void NPK_ndarray_shape_from_(const NPK_array *arr, int depth, int dim, int *shape) {
+        if (NPK_array_length(arr) > shape[depth]) {
+            shape[depth] = NPK_array_length(arr);
+        }
+
+        if (depth < dim - 1) {
+            NPK_for_each (NPK_array, elem, arr) {
+                NPK_ndarray_shape_from_(elem, depth + 1, dim, shape);
+            }
+        }
+    }
+
+    void NPK_ndarray_copy_from_(int size, NPK_ndarray *nd, const NPK_array *arr, int depth, int offset) {
+        int len = NPK_array_length(arr);
+
+        if (depth == nd->dim - 1) {
+            memcpy(NPK_ndarray_data(uint8_t, nd) + offset * size, arr->data, len * size);
+        } else {
+            NPK_count_up (i, 0, len) {
+                NPK_ndarray_copy_from_(size, nd, NPK_array_data(NPK_array, arr) + i, depth + 1, offset + i * nd->stride[depth]);
+            }
+        }
+    }
+
+    NPK_ndarray NPK_ndarray_copy_new_(int size, const NPK_ndarray *nd) {
+        NPK_ndarray copy = *nd;
+
+        copy.data = malloc(nd->len > 0 ? nd->len * size : 1);
+        NPK_stats_alloc_(NPK_stats_ndarray, NPK_cast(int64_t, nd->len) * size);
+        memcpy(copy.data, nd->data, nd->len * size);
+
+        return copy;
+    }
+
+    void *NPK_ndarray_at_(int size, const NPK_ndarray *nd, const int *idx) {
+        int offset = 0;
+
+        NPK_count_up (i, 0, nd->dim) {
+            offset += idx[i] * nd->stride[i];
+        }
+
+        return NPK_ndarray_data(uint8_t, nd) + offset * size;
+    }
+
+    NPK_array NPK_ndarray_row_(int size, const NPK_ndarray *nd, int idx) {
+        NPK_array row;
+
+        row.len = nd->shape[nd->dim - 1];
+        row.maxlen = row.len;
+        row.data = NPK_ndarray_data(uint8_t, nd) + idx * row.len * size;
+
+        return row;
+    }
+
+    bool NPK_ndarray_equals_(int size, const NPK_ndarray *nd1, const NPK_ndarray *nd2, bool (*type_equals)(const void *p1, const void *p2)) {
+        if (nd1->dim != nd2->dim || memcmp(nd1->shape, nd2->shape, nd1->dim * NPK_sizeof_type(int)) != 0) {
+            return false;
+        }
+
+        NPK_count_up (i, 0, nd1->len) {
+            if (type_equals(NPK_ndarray_data(uint8_t, nd1) + i * size, NPK_ndarray_data(uint8_t, nd2) + i * size) == false) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void NPK_ndarray_sort_(int size, NPK_ndarray *nd, int (*type_compare)(const void *p1, const void *p2)) {
+        NPK_count_up (i, 0, NPK_ndarray_rows(nd)) {
+            NPK_array row = NPK_ndarray_row_(size, nd, i);
+
+            qsort(row.data, NPK_array_length(&row), size, type_compare);
+        }
+    }
+
+    void NPK_ndarray_fill_(int size, NPK_ndarray *nd, const void *val) {
+        if (nd->len == 0) {
+            return;
+        }
+
+        // Every copy doubles the filled part of the buffer
+        memcpy(nd->data, val, size);
+
+        for (int filled = 1; filled < nd->len; filled *= 2) {
+            int count = filled < nd->len - filled ? filled : nd->len - filled;
+
+            memcpy(NPK_ndarray_data(uint8_t, nd) + filled * size, nd->data, count * size);
+        }
+    }
+
     NPK_string NPK_string_new(const NPK_cstring *s) {
         NPK_string str;
 
@@ -793,15 +2865,11 @@ limitations under the License.
         const NPK_cstring *end = strstr(str->data, delim);
 
         while (end != NULL) {
-            NPK_string part = NPK_string_new("");
-
-            while (begin != end) {
-                NPK_string_add(&part, *begin);
-                begin++;
-            }
+            NPK_string part = NPK_string_sized_new(end - begin + 2);
 
+            NPK_string_append_n_(&part, begin, end - begin);
             NPK_array_add(NPK_string, &parts, part);
-            begin += len;
+            begin = end + len;
             end = strstr(begin, delim);
         }
 
@@ -813,9 +2881,14 @@ limitations under the License.
     }
 
     void NPK_string_append(NPK_string *str, const NPK_cstring *s) {
-        for (; *s != '\0'; s++) {
-            NPK_string_add(str, *s);
-        }
+        NPK_string_append_n_(str, s, strlen(s));
+    }
+
+    void NPK_string_append_n_(NPK_string *str, const char *s, int n) {
+        NPK_array_reserve_(1, str, NPK_array_length(str) + n);
+        memcpy(NPK_string_data(str) + NPK_string_length(str), s, n);
+        str->len += n;
+        NPK_string_data(str)[NPK_string_length(str)] = '\0';
     }
 
     void NPK_string_add(NPK_string *str, char c) {
@@ -824,19 +2897,36 @@ limitations under the License.
     }
 
     void NPK_string_replace(NPK_string *str, const NPK_cstring *from, const NPK_cstring *to) {
-        NPK_string nstr = NPK_string_new("");
         int len = strlen(from);
+        int to_len = strlen(to);
+        int count = 0;
+
+        if (len == 0) {
+            return;
+        }
+
+        // Replacing with a string of the same length doesn't need a new string at all
+        for (NPK_cstring *pos = strstr(str->data, from); pos != NULL; pos = strstr(pos + len, from)) {
+            if (len == to_len) {
+                memcpy(pos, to, len);
+            }
+
+            count++;
+        }
+
+        if (count == 0 || len == to_len) {
+            return;
+        }
+
+        // Otherwise counting the occurences first, allows the new string to be allocated exactly once
+        NPK_string nstr = NPK_string_sized_new(NPK_array_length(str) + count * (to_len - len));
         const NPK_cstring *begin = str->data;
         const NPK_cstring *end = strstr(str->data, from);
 
         while (end != NULL) {
-            while (begin != end) {
-                NPK_string_add(&nstr, *begin);
-                begin++;
-            }
-
-            NPK_string_append(&nstr, to);
-            begin += len;
+            NPK_string_append_n_(&nstr, begin, end - begin);
+            NPK_string_append_n_(&nstr, to, to_len);
+            begin = end + len;
             end = strstr(begin, from);
         }
 
@@ -846,421 +2936,7224 @@ limitations under the License.
     }
 
     void NPK_string_to_lower(NPK_string *str) {
-        NPK_for_each (char, c, str) {
-            if (NPK_char_is_upper(*c)) {
-                *c = NPK_char_to_lower(*c);
-            }
-        }
+        NPK_ascii_case_(str->data, NPK_string_length(str), false);
     }
 
     void NPK_string_to_upper(NPK_string *str) {
-        NPK_for_each (char, c, str) {
-            if (NPK_char_is_lower(*c)) {
-                *c = NPK_char_to_upper(*c);
-            }
-        }
+        NPK_ascii_case_(str->data, NPK_string_length(str), true);
     }
 
-    void NPK_string_remove(NPK_string *str, const NPK_cstring *s) {
-        const NPK_cstring *pos = strstr(str->data, s);
-        int len = strlen(s);
-
-        while (pos != NULL) {
-            NPK_count_up (i, 0, len) {
-                NPK_string_remove_at(str, pos - NPK_string_data(str));
-            }
+    int NPK_string_compare_nocase(const NPK_string *str, const NPK_cstring *s) {
+        int len1 = NPK_string_length(str);
+        int len2 = strlen(s);
+        int len = len1 < len2 ? len1 : len2;
+        int idx = NPK_ascii_mismatch_nocase_(str->data, s, len);
 
-            pos = strstr(str->data, s);
+        if (idx < len) {
+            return NPK_cast(unsigned char, char_fold(NPK_string_data(str)[idx])) - NPK_cast(unsigned char, char_fold(s[idx]));
+        } else {
+            return (len1 > len2) - (len1 < len2);
         }
     }
 
-    #define map_maxlength(m) ((m)->keys.maxlen + 0)
-
-    NPK_map NPK_map_sized_new_(int size, int maxlen) {
-        NPK_map m;
+    bool NPK_string_equals_nocase(const NPK_string *str, const NPK_cstring *s) {
+        int len = NPK_string_length(str);
 
-        m.keys = NPK_array_sized_new(void *, maxlen);
-        m.values = NPK_array_sized_new_(size, maxlen);
-        memset(m.keys.data, 0, maxlen * NPK_sizeof_type(void *));
+        if (NPK_cast(size_t, len) != strlen(s)) {
+            return false;
+        }
 
-        return m;
+        return NPK_ascii_mismatch_nocase_(str->data, s, len) == len;
     }
 
-    NPK_map NPK_map_copy_new_(int size, const NPK_map *m, int dim) {
-        NPK_map copy;
+    int NPK_string_find_blank(const NPK_string *str) {
+        const char *s = str->data;
+        int len = NPK_string_length(str);
+        int i = 0;
 
-        copy.keys = NPK_array_copy_new(void *, &m->keys);
-        copy.values = NPK_array_copy_new_(size, &m->values, dim);
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, s + i));
+                int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), sse2_in_range(v, '\t', '\r')));
 
-        return copy;
-    }
+                if (mask != 0) {
+                    return i + NPK_ctz64_(mask);
+                }
+            }
+        #endif
 
-    NPK_array NPK_map_keys_new(const NPK_map *m) {
-        NPK_array keys = NPK_array_new(void *);
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
 
-        NPK_count_up (i, 0, map_maxlength(m)) {
-            void *key = NPK_array_data(void *, &m->keys)[i];
+            memcpy(&w, s + i, 8);
 
-            if (key != NULL) {
-                NPK_array_add(void *, &keys, key);
+            // A byte equal to ' ' is the only one that becomes 0 after the xor
+            uint64_t x = w ^ (swar_ones * ' ');
+            uint64_t space = ~(((x & ~swar_high) + ~swar_high) | x | ~swar_high);
+
+            if ((space | swar_in_range(w, '\t', '\r')) != 0) {
+                break;
             }
         }
 
-        return keys;
+        for (; i < len; i++) {
+            if (NPK_char_is_blank(s[i])) {
+                return i;
+            }
+        }
+
+        return -1;
     }
 
-    NPK_array NPK_map_values_new_(int size, const NPK_map *m, int dim) {
-        NPK_array vals;
-        NPK_array keys = NPK_map_keys_new(m);
+    void NPK_string_trim(NPK_string *str) {
+        const char *s = str->data;
+        int begin = 0;
+        int end = NPK_string_length(str);
 
-        if (dim > 1) {
-            vals = NPK_array_new(NPK_array);
-        } else {
-            vals = NPK_array_new_(size);
+        // Blank runs at the ends of a string are short, so a scalar scan is the fastest way
+        while (begin < end && NPK_char_is_blank(s[begin])) {
+            begin++;
         }
 
-        NPK_for_each (void *, key, &keys) {
-            if (dim > 1) {
-                NPK_array *cur = NPK_map_get(NPK_array, m, *key);
-                NPK_array copy = NPK_array_copy_new_(size, cur, dim - 1);
+        while (end > begin && NPK_char_is_blank(s[end - 1])) {
+            end--;
+        }
 
-                NPK_array_add(NPK_array, &vals, copy);
-            } else {
-                void *cur = NPK_map_get_(size, m, *key);
+        memmove(str->data, s + begin, end - begin);
+        NPK_string_data(str)[end - begin] = '\0';
+        str->len = end - begin + 1;
+    }
+
+    int NPK_string_count_digits(const NPK_string *str) {
+        const char *s = str->data;
+        int len = NPK_string_length(str);
+        int count = 0;
+        int i = 0;
 
-                NPK_array_add_(size, &vals, cur);
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, s + i));
+
+                count += NPK_popcount64_(_mm_movemask_epi8(sse2_in_range(v, '0', '9')));
             }
+        #endif
+
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+
+            memcpy(&w, s + i, 8);
+            count += NPK_popcount64_(swar_in_range(w, '0', '9'));
         }
 
-        NPK_array_del(&keys);
+        for (; i < len; i++) {
+            count += NPK_char_is_digit(s[i]);
+        }
 
-        return vals;
+        return count;
     }
 
-    void *NPK_map_get_(int size, const NPK_map *m, const void *key) {
-        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+    bool NPK_string_is_ascii(const NPK_string *str) {
+        const char *s = str->data;
+        int len = NPK_string_length(str);
+        uint64_t high = 0;
+        int i = 0;
 
-        NPK_count_up (i, idx, idx + map_maxlength(m)) {
-            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+        #if defined NPK_SSE2_
+            __m128i acc = _mm_setzero_si128();
 
-            if (cur_key == NULL) {
-                return NULL;
-            } else {
-                if (cur_key == key) {
-                    return NPK_array_data(uint8_t, &m->values) + (i % map_maxlength(m)) * size;
-                }
+            for (; i + 16 <= len; i += 16) {
+                acc = _mm_or_si128(acc, _mm_loadu_si128(NPK_cast(const __m128i *, s + i)));
             }
+
+            high |= _mm_movemask_epi8(acc);
+        #endif
+
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+
+            memcpy(&w, s + i, 8);
+            high |= w & swar_high;
         }
 
-        return NULL;
+        for (; i < len; i++) {
+            high |= NPK_cast(uint8_t, s[i]) & 0x80;
+        }
+
+        return high == 0;
     }
 
-    bool NPK_map_equals_(int size, const NPK_map *m1, const NPK_map *m2, bool (*type_equals)(const void *p1, const void *p2)) {
-        if (map_maxlength(m1) != map_maxlength(m2)) {
-            return false;
+    // Returns the length of the well formed sequence at the start of "s", or 0 if there is none
+    int NPK_utf8_decode_(const char *s, int len, uint32_t *cp) {
+        static const uint32_t smallest[] = {0, 0, 0x80, 0x800, 0x10000};
+        uint8_t lead = s[0];
+        int n = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+        uint32_t c = lead & (0x7F >> n);
+
+        if (lead < 0x80) {
+            *cp = lead;
+
+            return 1;
         }
 
-        NPK_count_up (i, 0, map_maxlength(m1)) {
-            void *key1 = NPK_array_data(void *, &m1->keys)[i];
-            void *key2 = NPK_array_data(void *, &m2->keys)[i];
+        if (n == 0 || lead > 0xF4 || n > len) {
+            return 0;
+        }
 
-            if (key1 != key2) {
-                return false;
-            } else {
-                if (key1 != NULL) {
-                    if (type_equals(NPK_map_get_(size, m1, key1), NPK_map_get_(size, m2, key2)) == false) {
-                        return false;
-                    }
-                }
+        NPK_count_up (i, 1, n) {
+            if ((s[i] & 0xC0) != 0x80) {
+                return 0;
             }
+
+            c = c << 6 | (s[i] & 0x3F);
         }
 
-        return true;
-    }
+        if (c < smallest[n] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            return 0;
+        }
 
-    bool NPK_map_contains_key(const NPK_map *m, const void *key) {
-        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+        *cp = c;
 
-        NPK_count_up (i, idx, idx + map_maxlength(m)) {
-            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+        return n;
+    }
 
-            if (cur_key == NULL) {
-                return false;
-            } else {
-                if (cur_key == key) {
-                    return true;
+    bool NPK_utf8_valid_(const char *s, int len) {
+        int i = 0;
+
+        #if defined NPK_AVX2_
+            // The lookup algorithm of Keiser and Lemire, the nibbles of every byte and of the byte before it index three
+            // tables of error bits, which only all agree on an error, and a byte two or three places after a lead of a long
+            // sequence must be a continuation, which is the only case where the bit of two continuations in a row is expected
+            #define utf8_too_short 0x01
+            #define utf8_too_long 0x02
+            #define utf8_overlong_3 0x04
+            #define utf8_too_large 0x08
+            #define utf8_surrogate 0x10
+            #define utf8_overlong_2 0x20
+            #define utf8_too_large_1000 0x40
+            #define utf8_overlong_4 0x40
+            #define utf8_two_conts (-0x80)
+            #define utf8_carry (utf8_too_short | utf8_too_long | utf8_two_conts)
+            #define utf8_table(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+            const __m256i byte_1_high = utf8_table(
+                utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+                utf8_two_conts, utf8_two_conts, utf8_two_conts, utf8_two_conts,
+                utf8_too_short | utf8_overlong_2,
+                utf8_too_short,
+                utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+                utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4);
+            const __m256i byte_1_low = utf8_table(
+                utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+                utf8_carry | utf8_overlong_2,
+                utf8_carry,
+                utf8_carry,
+                utf8_carry | utf8_too_large,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+                utf8_carry | utf8_too_large | utf8_too_large_1000,
+                utf8_carry | utf8_too_large | utf8_too_large_1000);
+            const __m256i byte_2_high = utf8_table(
+                utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+                utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+                utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large,
+                utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+                utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+                utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short);
+
+            // Saturating subtraction leaves a byte of the last three non-zero if it starts a sequence that doesn't fit
+            const __m256i incomplete = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0xF0 - 1 - 256, 0xE0 - 1 - 256, 0xC0 - 1 - 256);
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            __m256i prev = _mm256_setzero_si256();
+            __m256i error = _mm256_setzero_si256();
+            uint8_t tail[32];
+            bool last = false;
+
+            // The last block is padded with zeros, so a sequence cut short by the end of the string is an error in it
+            while (last == false) {
+                __m256i v;
+
+                if (i + 32 <= len) {
+                    v = _mm256_loadu_si256(NPK_cast(const __m256i *, s + i));
+                    i += 32;
+                } else {
+                    memset(tail, 0, 32);
+                    memcpy(tail, s + i, len - i);
+                    v = _mm256_loadu_si256(NPK_cast(const __m256i *, tail));
+                    last = true;
+                }
+
+                if (_mm256_movemask_epi8(v) == 0) {
+                    error = _mm256_or_si256(error, _mm256_subs_epu8(prev, incomplete));
+                } else {
+                    __m256i shifted = _mm256_permute2x128_si256(prev, v, 0x21);
+                    __m256i prev1 = _mm256_alignr_epi8(v, shifted, 15);
+                    __m256i prev2 = _mm256_alignr_epi8(v, shifted, 14);
+                    __m256i prev3 = _mm256_alignr_epi8(v, shifted, 13);
+                    __m256i special = _mm256_and_si256(_mm256_and_si256(
+                        _mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                        _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+                        _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+                    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)), _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80))), _mm256_set1_epi8(-0x80));
+
+                    error = _mm256_or_si256(error, _mm256_xor_si256(must_continue, special));
                 }
+
+                prev = v;
             }
-        }
 
-        return false;
-    }
+            #undef utf8_too_short
+            #undef utf8_too_long
+            #undef utf8_overlong_3
+            #undef utf8_too_large
+            #undef utf8_surrogate
+            #undef utf8_overlong_2
+            #undef utf8_too_large_1000
+            #undef utf8_overlong_4
+            #undef utf8_two_conts
+            #undef utf8_carry
+            #undef utf8_table
+
+            return _mm256_testz_si256(error, error);
+        #else
+            // Without shuffles the blocks of ASCII are skipped and every sequence in between is decoded
+            while (i < len) {
+                uint32_t cp;
+
+                #if defined NPK_SSE2_
+                    if (i + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128(NPK_cast(const __m128i *, s + i))) == 0) {
+                        i += 16;
+
+                        continue;
+                    }
+                #endif
 
-    bool NPK_map_contains_value_(int size, const NPK_map *m, const void *val, bool (*type_equals) (const void *p1, const void *p2), int dim) {
-        NPK_array vals = NPK_map_values_new_(size, m, dim);
+                int n = NPK_utf8_decode_(s + i, len - i, &cp);
+
+                if (n == 0) {
+                    return false;
+                }
 
-        if (NPK_array_contains_(size, &vals, val, type_equals)) {
-            NPK_array_dim_del(&vals, dim);
+                i += n;
+            }
 
             return true;
-        } else {
-            NPK_array_dim_del(&vals, dim);
+        #endif
+    }
 
-            return false;
-        }
+    bool NPK_string_is_utf8(const NPK_string *str) {
+        return NPK_utf8_valid_(str->data, NPK_string_length(str));
     }
 
-    void NPK_map_add_(int size, NPK_map *m, void *key, const void *val) {
-        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+    // Every byte but a continuation byte, which is 10xxxxxx and so below -64 as a signed char, starts a code point
+    int NPK_string_utf8_length(const NPK_string *str) {
+        const char *s = str->data;
+        int len = NPK_string_length(str);
+        int count = 0;
+        int i = 0;
 
-        NPK_count_up (i, idx, idx + map_maxlength(m)) {
-            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
-            void *cur_val = NPK_array_data(uint8_t, &m->values) + (i % map_maxlength(m)) * size;
+        #if defined NPK_AVX2_
+            for (; i + 32 <= len; i += 32) {
+                __m256i v = _mm256_loadu_si256(NPK_cast(const __m256i *, s + i));
 
-            if (cur_key == NULL) {
-                NPK_array_data(void *, &m->keys)[i % map_maxlength(m)] = key;
-                memcpy(cur_val, val, size);
-                m->keys.len++;
-                m->values.len++;
+                count += NPK_popcount64_(NPK_cast(uint32_t, _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65)))));
+            }
+        #endif
 
-                if (NPK_cast(double, NPK_map_length(m)) / NPK_cast(double, map_maxlength(m)) >= 0.5) {
-                    NPK_map nm = NPK_map_sized_new_(size, map_maxlength(m) * 1.5);
-                    NPK_array keys = NPK_map_keys_new(m);
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, s + i));
 
-                    NPK_for_each (void *, old_key, &keys) {
-                        void *old_val = NPK_map_get_(size, m, *old_key);
+                count += NPK_popcount64_(_mm_movemask_epi8(_mm_cmpgt_epi8(v, _mm_set1_epi8(-65))));
+            }
+        #endif
 
-                        NPK_map_add_(size, &nm, *old_key, old_val);
-                    }
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
 
-                    NPK_array_del(&keys);
-                    NPK_map_dim_del(m, 1);
-                    *m = nm;
-                }
+            memcpy(&w, s + i, 8);
+            count += 8 - NPK_popcount64_(w & ~(w << 1) & swar_high);
+        }
 
-                break;
-            } else {
-                if (cur_key == key) {
-                    memcpy(cur_val, val, size);
-                    break;
-                }
-            }
+        for (; i < len; i++) {
+            count += (s[i] & 0xC0) != 0x80;
         }
+
+        return count;
     }
 
-    void NPK_map_remove_(NPK_map *m, const void *key, int dim) {
-        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+    int NPK_string_utf8_next(const NPK_string *str, int idx, uint32_t *cp) {
+        int n = NPK_utf8_decode_(NPK_string_data(str) + idx, NPK_string_length(str) - idx, cp);
 
-        NPK_count_up (i, idx, idx + map_maxlength(m)) {
-            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+        if (n == 0) {
+            *cp = 0xFFFD;
 
-            if (cur_key == key) {
-                if (dim > 1) {
-                    NPK_array *cur_val = NPK_map_get(NPK_array, m, key);
+            return idx + 1;
+        }
 
-                    NPK_array_dim_del(cur_val, dim - 1);
+        return idx + n;
+    }
+
+    // Once the bytes are reversed every sequence ends with its lead, so each one is reversed back in place
+    void NPK_string_utf8_reverse(NPK_string *str) {
+        char *s = str->data;
+        int len = NPK_string_length(str);
+        int i = 0;
+
+        NPK_string_reverse(str);
+
+        while (i < len) {
+            int j = i;
+
+            #if defined NPK_SSE2_
+                if (i + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128(NPK_cast(const __m128i *, s + i))) == 0) {
+                    i += 16;
+
+                    continue;
                 }
+            #endif
 
-                NPK_array_data(void *, &m->keys)[i % map_maxlength(m)] = NULL;
-                m->keys.len--;
-                m->values.len--;
+            while (j < len && j - i < 3 && (s[j] & 0xC0) == 0x80) {
+                j++;
+            }
 
-                return;
+            // A stray continuation byte has no lead to pair with and stays where it is
+            if (j > i && j < len && (s[j] & 0xC0) == 0xC0) {
+                for (int lo = i, hi = j; lo < hi; lo++, hi--) {
+                    NPK_swap_(1, s + lo, s + hi);
+                }
             }
+
+            i = j + 1;
         }
     }
 
-    void NPK_map_dim_del(NPK_map *m, int dim) {
-        if (dim > 1) {
-            NPK_array keys = NPK_map_keys_new(m);
-
-            NPK_for_each (void *, key, &keys) {
-                NPK_array arr = *NPK_map_get(NPK_array, m, *key);
+    void NPK_string_remove(NPK_string *str, const NPK_cstring *s) {
+        const NPK_cstring *pos = strstr(str->data, s);
+        int len = strlen(s);
 
-                NPK_array_dim_del(&arr, dim - 1);
+        while (pos != NULL) {
+            NPK_count_up (i, 0, len) {
+                NPK_string_remove_at(str, pos - NPK_string_data(str));
             }
 
-            NPK_array_del(&keys);
+            pos = strstr(str->data, s);
         }
-
-        NPK_array_del(&m->keys);
-        NPK_array_dim_del(&m->values, 1);
     }
 
-    #undef map_maxlength
+    NPK_string_builder NPK_string_builder_new(void) {
+        return (NPK_string_builder) {NPK_array_new(NPK_array), 0};
+    }
 
-    bool NPK_uchar_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned char *, p1) == *NPK_cast(const unsigned char *, p2); }
-    bool NPK_ushrt_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned short *, p1) == *NPK_cast(const unsigned short *, p2); }
-    bool NPK_uint_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned int *, p1) == *NPK_cast(const unsigned int *, p2); }
-    bool NPK_ulong_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned long *, p1) == *NPK_cast(const unsigned long *, p2); }
-    bool NPK_ullong_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned long long *, p1) == *NPK_cast(const unsigned long long *, p2); }
+    void NPK_string_builder_append_n_(NPK_string_builder *sb, const char *s, int n) {
+        while (n > 0) {
+            NPK_array *last = NPK_array_data(NPK_array, &sb->chunks) + NPK_array_length(&sb->chunks) - 1;
+            int room = NPK_array_is_empty(&sb->chunks) ? 0 : last->maxlen - NPK_array_length(last);
 
-    bool NPK_schar_equals(const void *p1, const void *p2) { return *NPK_cast(const signed char *, p1) == *NPK_cast(const signed char *, p2); }
-    bool NPK_shrt_equals(const void *p1, const void *p2) { return *NPK_cast(const short *, p1) == *NPK_cast(const short *, p2); }
-    bool NPK_int_equals(const void *p1, const void *p2) { return *NPK_cast(const int *, p1) == *NPK_cast(const int *, p2); }
-    bool NPK_long_equals(const void *p1, const void *p2) { return *NPK_cast(const long *, p1) == *NPK_cast(const long *, p2); }
-    bool NPK_llong_equals(const void *p1, const void *p2) { return *NPK_cast(const long long *, p1) == *NPK_cast(const long long *, p2); }
+            // Chunks double in size up to 1 MiB, unless a single append needs a bigger one
+            if (room == 0) {
+                int maxlen = NPK_array_is_empty(&sb->chunks) ? 256 : last->maxlen * 2;
 
-    bool NPK_bool_equals(const void *p1, const void *p2) { return *NPK_cast(const bool *, p1) == *NPK_cast(const bool *, p2); }
-    bool NPK_char_equals(const void *p1, const void *p2) { return *NPK_cast(const char *, p1) == *NPK_cast(const char *, p2); }
-    bool NPK_flt_equals(const void *p1, const void *p2) { return fabsf(*NPK_cast(const float *, p1) - *NPK_cast(const float *, p2)) < FLT_EPSILON; }
-    bool NPK_dbl_equals(const void *p1, const void *p2) { return fabs(*NPK_cast(const double *, p1) - *NPK_cast(const double *, p2)) < DBL_EPSILON; }
-    bool NPK_ldbl_equals(const void *p1, const void *p2) { return fabsl(*NPK_cast(const long double *, p1) - *NPK_cast(const long double *, p2)) < LDBL_EPSILON; }
+                maxlen = maxlen < (1 << 20) ? maxlen : (1 << 20);
+                maxlen = maxlen > n ? maxlen : n;
+                NPK_array_add(NPK_array, &sb->chunks, NPK_array_sized_new(char, maxlen));
+                continue;
+            }
 
-    bool NPK_uint8_equals(const void *p1, const void *p2) { return *NPK_cast(const uint8_t *, p1) == *NPK_cast(const uint8_t *, p2); }
-    bool NPK_uint16_equals(const void *p1, const void *p2) { return *NPK_cast(const uint16_t *, p1) == *NPK_cast(const uint16_t *, p2); }
-    bool NPK_uint32_equals(const void *p1, const void *p2) { return *NPK_cast(const uint32_t *, p1) == *NPK_cast(const uint32_t *, p2); }
-    bool NPK_uint64_equals(const void *p1, const void *p2) { return *NPK_cast(const uint64_t *, p1) == *NPK_cast(const uint64_t *, p2); }
+            int len = n < room ? n : room;
 
-    bool NPK_int8_equals(const void *p1, const void *p2) { return *NPK_cast(const int8_t *, p1) == *NPK_cast(const int8_t *, p2); }
-    bool NPK_int16_equals(const void *p1, const void *p2) { return *NPK_cast(const int16_t *, p1) == *NPK_cast(const int16_t *, p2); }
-    bool NPK_int32_equals(const void *p1, const void *p2) { return *NPK_cast(const int32_t *, p1) == *NPK_cast(const int32_t *, p2); }
-    bool NPK_int64_equals(const void *p1, const void *p2) { return *NPK_cast(const int64_t *, p1) == *NPK_cast(const int64_t *, p2); }
+            memcpy(NPK_array_data(char, last) + NPK_array_length(last), s, len);
+            last->len += len;
+            sb->len += len;
+            s += len;
+            n -= len;
+        }
+    }
 
-    #define compare(type, name, order, val)                     \
-    int NPK_##name##_##order(const void *p1, const void *p2) {  \
-        const type *elem1 = p1;                                 \
-        const type *elem2 = p2;                                 \
-                                                                \
-        if (NPK_##name##_equals(elem1, elem2)) {                \
-            return 0;                                           \
-        } else if (*elem1 > *elem2) {                           \
-            return val;                                         \
-        } else {                                                \
-            return -val;                                        \
-        }                                                       \
+    void NPK_string_builder_append(NPK_string_builder *sb, const NPK_cstring *s) {
+        NPK_string_builder_append_n_(sb, s, strlen(s));
     }
 
-    compare(unsigned char, uchar, asc, 1)
-    compare(unsigned short, ushrt, asc, 1)
-    compare(unsigned int, uint, asc, 1)
-    compare(unsigned long, ulong, asc, 1)
-    compare(unsigned long long, ullong, asc, 1)
+    void NPK_string_builder_printf(NPK_string_builder *sb, const NPK_cstring *format, ...) {
+        va_list args;
+        va_list args_copy;
+        NPK_array *last = NPK_array_data(NPK_array, &sb->chunks) + NPK_array_length(&sb->chunks) - 1;
+        int room = NPK_array_is_empty(&sb->chunks) ? 0 : last->maxlen - NPK_array_length(last);
+
+        va_start(args, format);
+        va_copy(args_copy, args);
+
+        // Most of the time the result fits in the last chunk, so it is formatted in place
+        // The nul byte that vsnprintf writes needs a spot too, so the last spot of a chunk is never used here
+        int len = room > 0 ? vsnprintf(NPK_array_data(char, last) + NPK_array_length(last), room, format, args) : vsnprintf(NULL, 0, format, args);
+
+        if (len >= 0 && len < room) {
+            last->len += len;
+            sb->len += len;
+        } else if (len >= 0) {
+            char *buf = malloc(len + 1);
+
+            NPK_stats_alloc_(NPK_stats_other, len + 1);
+            vsnprintf(buf, len + 1, format, args_copy);
+            NPK_string_builder_append_n_(sb, buf, len);
+            free(buf);
+        }
 
-    compare(signed char, schar, asc, 1)
-    compare(short, shrt, asc, 1)
-    compare(int, int, asc, 1)
-    compare(long, long, asc, 1)
-    compare(long long, llong, asc, 1)
+        va_end(args_copy);
+        va_end(args);
+    }
 
-    compare(bool, bool, asc, 1)
-    compare(char, char, asc, 1)
-    compare(float, flt, asc, 1)
-    compare(double, dbl, asc, 1)
-    compare(long double, ldbl, asc, 1)
+    void NPK_string_builder_append_int64(NPK_string_builder *sb, int64_t val) {
+        char buf[20];
 
-    compare(uint8_t, uint8, asc, 1)
-    compare(uint16_t, uint16, asc, 1)
-    compare(uint32_t, uint32, asc, 1)
-    compare(uint64_t, uint64, asc, 1)
+        NPK_string_builder_append_n_(sb, buf, NPK_format_int64_(buf, val));
+    }
 
-    compare(int8_t, int8, asc, 1)
-    compare(int16_t, int16, asc, 1)
-    compare(int32_t, int32, asc, 1)
-    compare(int64_t, int64, asc, 1)
+    void NPK_string_builder_append_uint64(NPK_string_builder *sb, uint64_t val) {
+        char buf[20];
 
-    compare(unsigned char, uchar, desc, -1)
-    compare(unsigned short, ushrt, desc, -1)
-    compare(unsigned int, uint, desc, -1)
-    compare(unsigned long, ulong, desc, -1)
-    compare(unsigned long long, ullong, desc, -1)
+        NPK_string_builder_append_n_(sb, buf, NPK_format_uint64_(buf, val));
+    }
 
-    compare(signed char, schar, desc, -1)
-    compare(short, shrt, desc, -1)
-    compare(int, int, desc, -1)
-    compare(long, long, desc, -1)
-    compare(long long, llong, desc, -1)
+    void NPK_string_builder_append_dbl(NPK_string_builder *sb, double val) {
+        char buf[NPK_format_dbl_maxlen_];
 
-    compare(bool, bool, desc, -1)
-    compare(char, char, desc, -1)
-    compare(float, flt, desc, -1)
-    compare(double, dbl, desc, -1)
-    compare(long double, ldbl, desc, -1)
+        NPK_string_builder_append_n_(sb, buf, NPK_format_dbl_(buf, val));
+    }
 
-    compare(uint8_t, uint8, desc, -1)
-    compare(uint16_t, uint16, desc, -1)
-    compare(uint32_t, uint32, desc, -1)
-    compare(uint64_t, uint64, desc, -1)
+    NPK_string NPK_string_builder_to_string_new(const NPK_string_builder *sb) {
+        NPK_string str = NPK_string_sized_new(NPK_string_builder_length(sb) + 1);
 
-    compare(int8_t, int8, desc, -1)
-    compare(int16_t, int16, desc, -1)
-    compare(int32_t, int32, desc, -1)
-    compare(int64_t, int64, desc, -1)
+        NPK_for_each (NPK_array, chunk, &sb->chunks) {
+            NPK_string_append_n_(&str, chunk->data, NPK_array_length(chunk));
+        }
 
-    #undef compare
+        return str;
+    }
 
-    #define to_string(type, name, format)                   \
-    NPK_string NPK_##name##_to_string_new(type val) {       \
-        int len = snprintf(NULL, 0, format, val);           \
-        NPK_array arr = NPK_array_sized_new(char, len +1);  \
-                                                            \
-        snprintf(arr.data, len +1, format, val);            \
-        arr.len = len +1;                                   \
-                                                            \
-        return arr;                                         \
+    bool NPK_string_builder_write(const NPK_string_builder *sb, FILE *f) {
+        NPK_for_each (NPK_array, chunk, &sb->chunks) {
+            if (fwrite(chunk->data, 1, NPK_array_length(chunk), f) != NPK_cast(size_t, NPK_array_length(chunk))) {
+                return false;
+            }
+        }
+
+        return true;
     }
 
-    to_string(unsigned char, uchar, "%u")
-    to_string(unsigned short, ushrt, "%u")
-    to_string(unsigned int, uint, "%u")
-    to_string(unsigned long, ulong, "%lu")
-    to_string(unsigned long long, ullong, "%llu")
+    bool NPK_string_builder_write_fd(const NPK_string_builder *sb, int fd) {
+        #if defined NPK_POSIX_
+            #if defined IOV_MAX
+                #define iov_max (IOV_MAX < 64 ? IOV_MAX : 64)
+            #else
+                #define iov_max 16
+            #endif
+
+            struct iovec iov[iov_max];
+            int chunk = 0;
 
-    to_string(signed char, schar, "%i")
-    to_string(short, shrt, "%i")
-    to_string(int, int, "%i")
-    to_string(long, long, "%li")
-    to_string(long long, llong, "%lli")
+            // A batch of chunks is written per system call, partial writes continue from where they stopped
+            while (chunk < NPK_array_length(&sb->chunks)) {
+                int count = 0;
 
-    to_string(double, dbl, "%f")
-    to_string(long double, ldbl, "%Lf")
+                for (; count < iov_max && chunk + count < NPK_array_length(&sb->chunks); count++) {
+                    NPK_array *cur = NPK_array_data(NPK_array, &sb->chunks) + chunk + count;
 
-    to_string(uint8_t, uint8, "%"PRIu8)
-    to_string(uint16_t, uint16, "%"PRIu16)
-    to_string(uint32_t, uint32, "%"PRIu32)
-    to_string(uint64_t, uint64, "%"PRIu64)
+                    iov[count].iov_base = cur->data;
+                    iov[count].iov_len = NPK_array_length(cur);
+                }
 
-    to_string(int8_t, int8, "%"PRIi8)
-    to_string(int16_t, int16, "%"PRIi16)
-    to_string(int32_t, int32, "%"PRIi32)
-    to_string(int64_t, int64, "%"PRIi64)
+                struct iovec *pending = iov;
 
-    #undef to_string
+                while (count > 0) {
+                    ssize_t written = writev(fd, pending, count);
+
+                    // A signal that arrives before anything is written interrupts the call, which is simply retried
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (written < 0) {
+                        return false;
+                    }
+
+                    while (count > 0 && NPK_cast(size_t, written) >= pending->iov_len) {
+                        written -= pending->iov_len;
+                        pending++;
+                        count--;
+                        chunk++;
+                    }
+
+                    if (count > 0) {
+                        pending->iov_base = NPK_cast(char *, pending->iov_base) + written;
+                        pending->iov_len -= written;
+                    }
+                }
+            }
+
+            #undef iov_max
+
+            return true;
+        #else
+            // Each chunk is written until all of it is out, short writes continue from where they stopped
+            NPK_for_each (NPK_array, chunk, &sb->chunks) {
+                int done = 0;
+
+                while (done < NPK_array_length(chunk)) {
+                    int written = NPK_cast(int, write(fd, NPK_cast(char *, chunk->data) + done, NPK_array_length(chunk) - done));
+
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (written <= 0) {
+                        return false;
+                    }
+
+                    done += written;
+                }
+            }
+
+            return true;
+        #endif
+    }
+
+    // Every public function of the pool holds the lock, so the internal ones never have to
+    #if defined NPK_THREADS_
+        #define pool_lock(pool) mtx_lock((pool)->lock)
+        #define pool_unlock(pool) mtx_unlock((pool)->lock)
+    #else
+        #define pool_lock(pool)
+        #define pool_unlock(pool)
+    #endif
+
+    NPK_string_pool NPK_string_pool_new(void) {
+        NPK_string_pool pool;
+
+        pool.blocks = NPK_array_new(NPK_array);
+        pool.slots = NPK_array_sized_new(NPK_string *, 16);
+        pool.hashes = NPK_array_sized_new(uint64_t, 16);
+        memset(pool.slots.data, 0, 16 * NPK_sizeof_type(NPK_string *));
+
+        #if defined NPK_THREADS_
+            pool.lock = malloc(sizeof(mtx_t));
+            mtx_init(pool.lock, mtx_plain);
+        #endif
+
+        return pool;
+    }
+
+    NPK_string *NPK_string_pool_intern_n_(NPK_string_pool *pool, const char *s, int len, bool add) {
+        uint64_t hash = NPK_hash_bytes_(s, len, false);
+        NPK_string **slots = pool->slots.data;
+        uint64_t *hashes = pool->hashes.data;
+        int mask = pool->slots.maxlen - 1;
+        int idx = hash & mask;
+
+        // The table is a power of two that is never more than half full, so an empty slot always exists
+        for (; slots[idx] != NULL; idx = (idx + 1) & mask) {
+            if (hashes[idx] == hash && NPK_string_length(slots[idx]) == len && memcmp(slots[idx]->data, s, len) == 0) {
+                return slots[idx];
+            }
+        }
+
+        if (add == false) {
+            return NULL;
+        }
+
+        NPK_array *block = NPK_array_data(NPK_array, &pool->blocks) + NPK_array_length(&pool->blocks) - 1;
+
+        if (NPK_array_is_empty(&pool->blocks) || NPK_array_length(block) == block->maxlen) {
+            int maxlen = NPK_array_is_empty(&pool->blocks) ? 64 : block->maxlen * 2;
+
+            NPK_array_add(NPK_array, &pool->blocks, NPK_array_sized_new(NPK_string, maxlen));
+            block = NPK_array_data(NPK_array, &pool->blocks) + NPK_array_length(&pool->blocks) - 1;
+        }
+
+        NPK_string *str = NPK_array_data(NPK_string, block) + block->len++;
+
+        *str = NPK_string_sized_new(len + 1);
+        NPK_string_append_n_(str, s, len);
+        slots[idx] = str;
+        hashes[idx] = hash;
+        pool->slots.len++;
+
+        if (NPK_array_length(&pool->slots) * 2 >= pool->slots.maxlen) {
+            NPK_array nslots = NPK_array_sized_new(NPK_string *, pool->slots.maxlen * 2);
+            NPK_array nhashes = NPK_array_sized_new(uint64_t, pool->slots.maxlen * 2);
+
+            memset(nslots.data, 0, nslots.maxlen * NPK_sizeof_type(NPK_string *));
+            nslots.len = NPK_array_length(&pool->slots);
+            mask = nslots.maxlen - 1;
+
+            NPK_count_up (i, 0, pool->slots.maxlen) {
+                if (slots[i] != NULL) {
+                    int j = hashes[i] & mask;
+
+                    while (NPK_array_data(NPK_string *, &nslots)[j] != NULL) {
+                        j = (j + 1) & mask;
+                    }
+
+                    NPK_array_data(NPK_string *, &nslots)[j] = slots[i];
+                    NPK_array_data(uint64_t, &nhashes)[j] = hashes[i];
+                }
+            }
+
+            NPK_array_del(&pool->slots);
+            NPK_array_del(&pool->hashes);
+            pool->slots = nslots;
+            pool->hashes = nhashes;
+        }
+
+        return str;
+    }
+
+    NPK_string *NPK_string_pool_intern(NPK_string_pool *pool, const NPK_cstring *s) {
+        pool_lock(pool);
+
+        NPK_string *str = NPK_string_pool_intern_n_(pool, s, strlen(s), true);
+
+        pool_unlock(pool);
+
+        return str;
+    }
+
+    NPK_string *NPK_string_pool_find(NPK_string_pool *pool, const NPK_cstring *s) {
+        pool_lock(pool);
+
+        NPK_string *str = NPK_string_pool_intern_n_(pool, s, strlen(s), false);
+
+        pool_unlock(pool);
+
+        return str;
+    }
+
+    NPK_array NPK_string_pool_intern_all_new(NPK_string_pool *pool, const NPK_array *strs) {
+        NPK_array interned = NPK_array_sized_new(NPK_string *, NPK_array_length(strs) + 2);
+
+        // The lock is taken once for the whole batch
+        pool_lock(pool);
+
+        NPK_for_each (NPK_string, str, strs) {
+            NPK_string *canonical = NPK_string_pool_intern_n_(pool, str->data, NPK_string_length(str), true);
+
+            NPK_array_add(NPK_string *, &interned, canonical);
+        }
+
+        pool_unlock(pool);
+
+        return interned;
+    }
+
+    void NPK_string_pool_del(NPK_string_pool *pool) {
+        NPK_array_dim_del(&pool->blocks, 3);
+        NPK_array_del(&pool->slots);
+        NPK_array_del(&pool->hashes);
+
+        #if defined NPK_THREADS_
+            mtx_destroy(pool->lock);
+            free(pool->lock);
+        #endif
+    }
+
+    #undef pool_lock
+    #undef pool_unlock
+
+    #define map_maxlength(m) ((m)->keys.maxlen + 0)
+
+    NPK_map NPK_map_sized_new_(int size, int maxlen) {
+        NPK_map m;
+
+        // The slots are allocated here rather than as arrays, so that they count as map memory
+        m.keys.len = 0;
+        m.keys.maxlen = maxlen;
+        m.keys.data = calloc(maxlen, NPK_sizeof_type(void *));
+        m.values.len = 0;
+        m.values.maxlen = maxlen;
+        m.values.data = malloc(maxlen * size);
+        NPK_stats_alloc_(NPK_stats_map, NPK_cast(int64_t, maxlen) * NPK_sizeof_type(void *));
+        NPK_stats_alloc_(NPK_stats_map, NPK_cast(int64_t, maxlen) * size);
+
+        return m;
+    }
+
+    NPK_map NPK_map_copy_new_(int size, const NPK_map *m, int dim) {
+        NPK_map copy = NPK_map_sized_new_(dim > 1 ? NPK_cast(int, NPK_sizeof_type(NPK_array)) : size, map_maxlength(m));
+
+        // The slots are copied as they are, so the copy probes exactly like "m" and nothing is rehashed
+        memcpy(copy.keys.data, m->keys.data, map_maxlength(m) * NPK_sizeof_type(void *));
+        copy.keys.len = NPK_map_length(m);
+        copy.values.len = NPK_map_length(m);
+
+        // Only the slots that hold a key have a nested value, the others hold garbage
+        if (dim > 1) {
+            NPK_count_up (i, 0, map_maxlength(m)) {
+                if (NPK_array_data(void *, &m->keys)[i] != NULL) {
+                    NPK_array_data(NPK_array, &copy.values)[i] = NPK_array_copy_new_(size, NPK_array_data(NPK_array, &m->values) + i, dim - 1);
+                }
+            }
+        } else {
+            memcpy(copy.values.data, m->values.data, map_maxlength(m) * size);
+        }
+
+        return copy;
+    }
+
+    NPK_array NPK_map_keys_new(const NPK_map *m) {
+        NPK_array keys = NPK_array_sized_new(void *, NPK_map_length(m) > 0 ? NPK_map_length(m) : 1);
+
+        NPK_count_up (i, 0, map_maxlength(m)) {
+            void *key = NPK_array_data(void *, &m->keys)[i];
+
+            if (key != NULL) {
+                NPK_array_add(void *, &keys, key);
+            }
+        }
+
+        return keys;
+    }
+
+    NPK_array NPK_map_values_new_(int size, const NPK_map *m, int dim) {
+        int len = NPK_map_length(m);
+        NPK_array vals = NPK_array_sized_new_(dim > 1 ? NPK_cast(int, NPK_sizeof_type(NPK_array)) : size, len > 0 ? len : 1);
+
+        // The slots are scanned once in the order of NPK_map_keys_new, rather than looking up every key again
+        NPK_count_up (i, 0, map_maxlength(m)) {
+            if (NPK_array_data(void *, &m->keys)[i] != NULL) {
+                if (dim > 1) {
+                    NPK_array_data(NPK_array, &vals)[vals.len] = NPK_array_copy_new_(size, NPK_array_data(NPK_array, &m->values) + i, dim - 1);
+                } else {
+                    memcpy(NPK_array_data(uint8_t, &vals) + vals.len * size, NPK_array_data(uint8_t, &m->values) + i * size, size);
+                }
+
+                vals.len++;
+            }
+        }
+
+        return vals;
+    }
+
+    void *NPK_map_get_(int size, const NPK_map *m, const void *key) {
+        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+
+        NPK_count_up (i, idx, idx + map_maxlength(m)) {
+            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+
+            if (cur_key == NULL) {
+                NPK_stats_probe_(i - idx + 1);
+
+                return NULL;
+            } else {
+                if (cur_key == key) {
+                    NPK_stats_probe_(i - idx + 1);
+
+                    return NPK_array_data(uint8_t, &m->values) + (i % map_maxlength(m)) * size;
+                }
+            }
+        }
+
+        NPK_stats_probe_(map_maxlength(m));
+
+        return NULL;
+    }
+
+    bool NPK_map_equals_(int size, const NPK_map *m1, const NPK_map *m2, bool (*type_equals)(const void *p1, const void *p2)) {
+        if (NPK_map_length(m1) != NPK_map_length(m2)) {
+            return false;
+        }
+
+        // With the same number of keys, every key of "m1" being in "m2" means that they have the same keys
+        NPK_count_up (i, 0, map_maxlength(m1)) {
+            void *key = NPK_array_data(void *, &m1->keys)[i];
+
+            if (key != NULL) {
+                int slot = NPK_map_find_(m2, key, NPK_map_home_(m2, key));
+
+                if (slot < 0 || type_equals(NPK_array_data(uint8_t, &m1->values) + i * size, NPK_array_data(uint8_t, &m2->values) + slot * size) == false) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool NPK_map_contains_key(const NPK_map *m, const void *key) {
+        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+
+        NPK_count_up (i, idx, idx + map_maxlength(m)) {
+            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+
+            if (cur_key == NULL) {
+                NPK_stats_probe_(i - idx + 1);
+
+                return false;
+            } else {
+                if (cur_key == key) {
+                    NPK_stats_probe_(i - idx + 1);
+
+                    return true;
+                }
+            }
+        }
+
+        NPK_stats_probe_(map_maxlength(m));
+
+        return false;
+    }
+
+    bool NPK_map_contains_value_(int size, const NPK_map *m, const void *val, bool (*type_equals) (const void *p1, const void *p2), int dim) {
+        NPK_count_up (i, 0, map_maxlength(m)) {
+            if (NPK_array_data(void *, &m->keys)[i] != NULL) {
+                if (dim > 1) {
+                    if (NPK_array_equals_(size, NPK_array_data(NPK_array, &m->values) + i, val, type_equals, dim - 1)) {
+                        return true;
+                    }
+                } else if (type_equals(NPK_array_data(uint8_t, &m->values) + i * size, val)) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void NPK_map_add_(int size, NPK_map *m, void *key, const void *val) {
+        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+
+        NPK_count_up (i, idx, idx + map_maxlength(m)) {
+            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+            void *cur_val = NPK_array_data(uint8_t, &m->values) + (i % map_maxlength(m)) * size;
+
+            if (cur_key == NULL) {
+                NPK_stats_probe_(i - idx + 1);
+                NPK_array_data(void *, &m->keys)[i % map_maxlength(m)] = key;
+                memcpy(cur_val, val, size);
+                m->keys.len++;
+                m->values.len++;
+
+                if (NPK_cast(double, NPK_map_length(m)) / NPK_cast(double, map_maxlength(m)) >= 0.5) {
+                    NPK_map_rehash_(size, m, map_maxlength(m) * 1.5);
+                }
+
+                break;
+            } else {
+                if (cur_key == key) {
+                    NPK_stats_probe_(i - idx + 1);
+                    memcpy(cur_val, val, size);
+                    break;
+                }
+            }
+        }
+    }
+
+    void NPK_map_remove_(NPK_map *m, const void *key, int dim) {
+        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+
+        NPK_count_up (i, idx, idx + map_maxlength(m)) {
+            void *cur_key = NPK_array_data(void *, &m->keys)[i % map_maxlength(m)];
+
+            if (cur_key == key) {
+                if (dim > 1) {
+                    NPK_array *cur_val = NPK_map_get(NPK_array, m, key);
+
+                    NPK_array_dim_del(cur_val, dim - 1);
+                }
+
+                NPK_array_data(void *, &m->keys)[i % map_maxlength(m)] = NULL;
+                m->keys.len--;
+                m->values.len--;
+
+                return;
+            }
+        }
+    }
+
+    bool NPK_map_erase_(int size, NPK_map *m, const void *key) {
+        void **keys = NPK_array_data(void *, &m->keys);
+        int idx = NPK_cast(int64_t, key) % map_maxlength(m);
+
+        for (; keys[idx] != key; idx = (idx + 1) % map_maxlength(m)) {
+            if (keys[idx] == NULL) {
+                return false;
+            }
+        }
+
+        // Moves back every later key of the probe chain that the hole would make unreachable, so no lookup stops early
+        for (int i = (idx + 1) % map_maxlength(m); keys[i] != NULL; i = (i + 1) % map_maxlength(m)) {
+            int home = NPK_cast(int64_t, keys[i]) % map_maxlength(m);
+
+            if ((idx < i && (home <= idx || home > i)) || (idx > i && home <= idx && home > i)) {
+                keys[idx] = keys[i];
+                memcpy(NPK_array_data(uint8_t, &m->values) + idx * size, NPK_array_data(uint8_t, &m->values) + i * size, size);
+                idx = i;
+            }
+        }
+
+        keys[idx] = NULL;
+        m->keys.len--;
+        m->values.len--;
+
+        return true;
+    }
+
+    // Follows the growth of NPK_map_add_ from "maxlen" until "count" pairs take less than half of the slots
+    int NPK_map_grown_maxlen_(int maxlen, int count) {
+        while (2 * NPK_cast(int64_t, count) >= maxlen) {
+            maxlen += maxlen / 2 > 0 ? maxlen / 2 : 1;
+        }
+
+        return maxlen;
+    }
+
+    // Moves every pair to new slots, the old slots are read once in order and the keys are known to be distinct
+    void NPK_map_rehash_(int size, NPK_map *m, int maxlen) {
+        NPK_map nm = NPK_map_sized_new_(size, maxlen);
+
+        NPK_stats_rehash_(NPK_map_length(m));
+
+        NPK_count_up (i, 0, map_maxlength(m)) {
+            void *key = NPK_array_data(void *, &m->keys)[i];
+
+            if (key != NULL) {
+                int idx = NPK_map_home_(&nm, key);
+
+                while (NPK_array_data(void *, &nm.keys)[idx] != NULL) {
+                    idx = idx + 1 == maxlen ? 0 : idx + 1;
+                }
+
+                NPK_array_data(void *, &nm.keys)[idx] = key;
+                memcpy(NPK_array_data(uint8_t, &nm.values) + idx * size, NPK_array_data(uint8_t, &m->values) + i * size, size);
+            }
+        }
+
+        nm.keys.len = NPK_map_length(m);
+        nm.values.len = NPK_map_length(m);
+        NPK_map_dim_del(m, 1);
+        *m = nm;
+    }
+
+    void NPK_map_reserve_(int size, NPK_map *m, int count) {
+        int maxlen = NPK_map_grown_maxlen_(map_maxlength(m), count);
+
+        if (maxlen != map_maxlength(m)) {
+            NPK_map_rehash_(size, m, maxlen);
+        }
+    }
+
+    // The map starts at the size that adding the keys one by one would reach, so it never rehashes
+    NPK_map NPK_map_from_arrays_new_(int size, const NPK_array *keys, const NPK_array *values) {
+        NPK_map m = NPK_map_sized_new_(size, NPK_map_grown_maxlen_(9, NPK_array_length(keys)));
+
+        NPK_map_add_many_(size, &m, keys, values);
+
+        return m;
+    }
+
+    // Probes from slot "idx" and returns the slot of "key", or -1 if it is missing
+    int NPK_map_find_(const NPK_map *m, const void *key, int idx) {
+        void **keys = NPK_array_data(void *, &m->keys);
+
+        NPK_count_up (i, 0, map_maxlength(m)) {
+            if (keys[idx] == NULL || keys[idx] == key) {
+                NPK_stats_probe_(i + 1);
+
+                return keys[idx] == NULL ? -1 : idx;
+            }
+
+            idx = idx + 1 == map_maxlength(m) ? 0 : idx + 1;
+        }
+
+        NPK_stats_probe_(map_maxlength(m));
+
+        return -1;
+    }
+
+    // Probes from slot "idx" and returns the slot of "key", or the empty slot it would take, the map must have room for it
+    int NPK_map_slot_(const NPK_map *m, const void *key, int idx) {
+        void **keys = NPK_array_data(void *, &m->keys);
+
+        while (keys[idx] != NULL && keys[idx] != key) {
+            idx = idx + 1 == map_maxlength(m) ? 0 : idx + 1;
+        }
+
+        return idx;
+    }
+
+    // The batched operations run a pipeline over the keys, key "i" is hashed and its slot prefetched NPK_map_batch_ keys
+    // before it is probed, and "homes" holds the home slots in between
+    int NPK_map_get_many_(int size, const NPK_map *m, const NPK_array *keys, NPK_array *out) {
+        void **cur = NPK_array_data(void *, keys);
+        int len = NPK_array_length(keys);
+        int homes[NPK_map_batch_];
+        int found = 0;
+
+        NPK_array_reserve_(NPK_sizeof_type(void *), out, len);
+        out->len = len;
+
+        NPK_count_up (i, 0, len + NPK_map_batch_) {
+            int ring = i % NPK_map_batch_;
+
+            if (i >= NPK_map_batch_) {
+                int slot = NPK_map_find_(m, cur[i - NPK_map_batch_], homes[ring]);
+
+                NPK_array_data(void *, out)[i - NPK_map_batch_] = slot >= 0 ? NPK_array_data(uint8_t, &m->values) + slot * size : NULL;
+                found += slot >= 0;
+            }
+
+            if (i < len) {
+                homes[ring] = NPK_map_home_(m, cur[i]);
+                NPK_prefetch_(NPK_array_data(void *, &m->keys) + homes[ring]);
+            }
+        }
+
+        return found;
+    }
+
+    int NPK_map_contains_many(const NPK_map *m, const NPK_array *keys, NPK_array *out) {
+        void **cur = NPK_array_data(void *, keys);
+        int len = NPK_array_length(keys);
+        int homes[NPK_map_batch_];
+        int found = 0;
+
+        NPK_array_reserve_(NPK_sizeof_type(bool), out, len);
+        out->len = len;
+
+        NPK_count_up (i, 0, len + NPK_map_batch_) {
+            int ring = i % NPK_map_batch_;
+
+            if (i >= NPK_map_batch_) {
+                bool contains = NPK_map_find_(m, cur[i - NPK_map_batch_], homes[ring]) >= 0;
+
+                NPK_array_data(bool, out)[i - NPK_map_batch_] = contains;
+                found += contains;
+            }
+
+            if (i < len) {
+                homes[ring] = NPK_map_home_(m, cur[i]);
+                NPK_prefetch_(NPK_array_data(void *, &m->keys) + homes[ring]);
+            }
+        }
+
+        return found;
+    }
+
+    void NPK_map_add_many_(int size, NPK_map *m, const NPK_array *keys, const NPK_array *values) {
+        void **cur = NPK_array_data(void *, keys);
+        int len = NPK_array_length(keys);
+        int homes[NPK_map_batch_];
+
+        // Making room for every key first leaves the slots in place for the whole batch, so they can be prefetched
+        NPK_map_reserve_(size, m, NPK_map_length(m) + len);
+
+        void **slots = NPK_array_data(void *, &m->keys);
+
+        NPK_count_up (i, 0, len + NPK_map_batch_) {
+            int ring = i % NPK_map_batch_;
+
+            if (i >= NPK_map_batch_) {
+                void *key = cur[i - NPK_map_batch_];
+                int idx = NPK_map_slot_(m, key, homes[ring]);
+
+                if (slots[idx] == NULL) {
+                    slots[idx] = key;
+                    m->keys.len++;
+                    m->values.len++;
+                }
+
+                memcpy(NPK_array_data(uint8_t, &m->values) + idx * size, NPK_array_data(uint8_t, values) + (i - NPK_map_batch_) * size, size);
+            }
+
+            if (i < len) {
+                homes[ring] = NPK_map_home_(m, cur[i]);
+                NPK_prefetch_(slots + homes[ring]);
+                NPK_prefetch_(NPK_array_data(uint8_t, &m->values) + homes[ring] * size);
+            }
+        }
+    }
+
+    void NPK_map_merge_(int size, NPK_map *m, const NPK_map *other, void (*merge)(void *val, const void *other_val, void *ctx), void *ctx) {
+        int pending[NPK_map_batch_];
+        int homes[NPK_map_batch_];
+        int count = 0;
+
+        // Room for every key of both is made once, so the slots of "m" stay in place while "other" is scanned
+        NPK_map_reserve_(size, m, NPK_map_length(m) + NPK_map_length(other));
+
+        // The keys of "other" go through the pipeline of the batched operations, "pending" holds their slots in "other"
+        NPK_count_up (i, 0, map_maxlength(other) + NPK_map_batch_) {
+            void *key = i < map_maxlength(other) ? NPK_array_data(void *, &other->keys)[i] : NULL;
+
+            if (key == NULL && i < map_maxlength(other)) {
+                continue;
+            }
+
+            int ring = count++ % NPK_map_batch_;
+
+            if (count > NPK_map_batch_) {
+                void *pending_key = NPK_array_data(void *, &other->keys)[pending[ring]];
+                int idx = NPK_map_slot_(m, pending_key, homes[ring]);
+                void *val = NPK_array_data(uint8_t, &m->values) + idx * size;
+                const void *other_val = NPK_array_data(uint8_t, &other->values) + pending[ring] * size;
+
+                if (NPK_array_data(void *, &m->keys)[idx] == NULL) {
+                    NPK_array_data(void *, &m->keys)[idx] = pending_key;
+                    m->keys.len++;
+                    m->values.len++;
+                    memcpy(val, other_val, size);
+                } else if (merge != NULL) {
+                    merge(val, other_val, ctx);
+                } else {
+                    memcpy(val, other_val, size);
+                }
+            }
+
+            if (key != NULL) {
+                pending[ring] = i;
+                homes[ring] = NPK_map_home_(m, key);
+                NPK_prefetch_(NPK_array_data(void *, &m->keys) + homes[ring]);
+                NPK_prefetch_(NPK_array_data(uint8_t, &m->values) + homes[ring] * size);
+            }
+        }
+    }
+
+    void NPK_map_dim_del(NPK_map *m, int dim) {
+        if (dim > 1) {
+            NPK_count_up (i, 0, map_maxlength(m)) {
+                if (NPK_array_data(void *, &m->keys)[i] != NULL) {
+                    NPK_array_dim_del(NPK_array_data(NPK_array, &m->values) + i, dim - 1);
+                }
+            }
+        }
+
+        NPK_array_del(&m->keys);
+        NPK_array_dim_del(&m->values, 1);
+    }
+
+    #undef map_maxlength
+
+    #if defined NPK_THREADS_
+        #define cmap_lock(shard) mtx_lock(&(shard)->lock)
+        #define cmap_unlock(shard) mtx_unlock(&(shard)->lock)
+    #else
+        #define cmap_lock(shard)
+        #define cmap_unlock(shard)
+    #endif
+
+    NPK_cmap NPK_cmap_new_(int size, int shards) {
+        NPK_cmap cm;
+        int count = 1;
+
+        while (count < shards) {
+            count *= 2;
+        }
+
+        cm.size = size;
+        cm.shards = NPK_array_sized_new(NPK_cmap_shard_, count);
+        cm.shards.len = count;
+
+        NPK_for_each (NPK_cmap_shard_, shard, &cm.shards) {
+            shard->map = NPK_map_new_(size);
+
+            #if defined NPK_THREADS_
+                mtx_init(&shard->lock, mtx_plain);
+            #endif
+        }
+
+        return cm;
+    }
+
+    NPK_cmap_shard_ *NPK_cmap_shard_of_(const NPK_cmap *cm, const void *key) {
+        // The shard comes from the high bits of a multiplicative hash, the map inside it uses the address modulo its length
+        uint64_t hash = NPK_cast(uint64_t, NPK_cast(uintptr_t, key)) * 0x9E3779B97F4A7C15u;
+
+        return NPK_array_data(NPK_cmap_shard_, &cm->shards) + ((hash >> 40) & (NPK_array_length(&cm->shards) - 1));
+    }
+
+    bool NPK_cmap_get(NPK_cmap *cm, const void *key, void *val) {
+        NPK_cmap_shard_ *shard = NPK_cmap_shard_of_(cm, key);
+
+        cmap_lock(shard);
+
+        void *cur = NPK_map_get_(cm->size, &shard->map, key);
+
+        if (cur != NULL) {
+            memcpy(val, cur, cm->size);
+        }
+
+        cmap_unlock(shard);
+
+        return cur != NULL;
+    }
+
+    bool NPK_cmap_contains_key(NPK_cmap *cm, const void *key) {
+        NPK_cmap_shard_ *shard = NPK_cmap_shard_of_(cm, key);
+
+        cmap_lock(shard);
+
+        bool found = NPK_map_contains_key(&shard->map, key);
+
+        cmap_unlock(shard);
+
+        return found;
+    }
+
+    void NPK_cmap_add_(NPK_cmap *cm, void *key, const void *val) {
+        NPK_cmap_shard_ *shard = NPK_cmap_shard_of_(cm, key);
+
+        cmap_lock(shard);
+        NPK_map_add_(cm->size, &shard->map, key, val);
+        cmap_unlock(shard);
+    }
+
+    bool NPK_cmap_remove(NPK_cmap *cm, const void *key) {
+        NPK_cmap_shard_ *shard = NPK_cmap_shard_of_(cm, key);
+
+        cmap_lock(shard);
+
+        bool found = NPK_map_erase_(cm->size, &shard->map, key);
+
+        cmap_unlock(shard);
+
+        return found;
+    }
+
+    int NPK_cmap_length(NPK_cmap *cm) {
+        int len = 0;
+
+        NPK_for_each (NPK_cmap_shard_, shard, &cm->shards) {
+            cmap_lock(shard);
+            len += NPK_map_length(&shard->map);
+            cmap_unlock(shard);
+        }
+
+        return len;
+    }
+
+    void NPK_cmap_del(NPK_cmap *cm) {
+        NPK_for_each (NPK_cmap_shard_, shard, &cm->shards) {
+            NPK_map_del(&shard->map);
+
+            #if defined NPK_THREADS_
+                mtx_destroy(&shard->lock);
+            #endif
+        }
+
+        NPK_array_del(&cm->shards);
+    }
+
+    #undef cmap_lock
+    #undef cmap_unlock
+
+    int NPK_ceil_pow2_(int n) {
+        int pow2 = 1;
+
+        while (pow2 < n) {
+            pow2 *= 2;
+        }
+
+        return pow2;
+    }
+
+    NPK_ring NPK_ring_sized_new_(int size, int maxlen) {
+        NPK_ring r;
+
+        r.items = NPK_array_sized_new_(size, NPK_ceil_pow2_(maxlen));
+        r.head = 0;
+
+        return r;
+    }
+
+    void *NPK_ring_at_(int size, const NPK_ring *r, int idx) {
+        return NPK_array_data(uint8_t, &r->items) + ((r->head + idx) & (r->items.maxlen - 1)) * size;
+    }
+
+    void NPK_ring_push_(int size, NPK_ring *r, const void *val, bool front) {
+        int maxlen = r->items.maxlen;
+
+        if (NPK_ring_length(r) == maxlen) {
+            NPK_array_reserve_(size, &r->items, 2 * maxlen);
+
+            // The elements that wrapped around to the start now belong right after the old end
+            int wrapped = r->head + NPK_ring_length(r) - maxlen;
+
+            memcpy(NPK_array_data(uint8_t, &r->items) + maxlen * size, r->items.data, wrapped * size);
+        }
+
+        if (front) {
+            r->head = (r->head - 1) & (r->items.maxlen - 1);
+            memcpy(NPK_ring_at_(size, r, 0), val, size);
+        } else {
+            memcpy(NPK_ring_at_(size, r, NPK_ring_length(r)), val, size);
+        }
+
+        r->items.len++;
+    }
+
+    bool NPK_ring_pop_(int size, NPK_ring *r, void *val, bool front) {
+        if (NPK_ring_is_empty(r)) {
+            return false;
+        }
+
+        void *cur = NPK_ring_at_(size, r, front ? 0 : NPK_ring_length(r) - 1);
+
+        if (val != NULL) {
+            memcpy(val, cur, size);
+        }
+
+        if (front) {
+            r->head = (r->head + 1) & (r->items.maxlen - 1);
+        }
+
+        r->items.len--;
+
+        return true;
+    }
+
+    #if defined NPK_ATOMICS_
+        // The indices of the queues only ever grow, the slot of an index is the index modulo the power of two length
+        void NPK_ring_copy_in_(int size, NPK_array *slots, size_t pos, const void *vals, int n) {
+            int idx = pos & (slots->maxlen - 1);
+            int first = n < slots->maxlen - idx ? n : slots->maxlen - idx;
+
+            memcpy(NPK_array_data(uint8_t, slots) + idx * size, vals, first * size);
+            memcpy(slots->data, NPK_cast(const uint8_t *, vals) + first * size, (n - first) * size);
+        }
+
+        void NPK_ring_copy_out_(int size, const NPK_array *slots, size_t pos, void *vals, int n) {
+            int idx = pos & (slots->maxlen - 1);
+            int first = n < slots->maxlen - idx ? n : slots->maxlen - idx;
+
+            memcpy(vals, NPK_array_data(uint8_t, slots) + idx * size, first * size);
+            memcpy(NPK_cast(uint8_t *, vals) + first * size, slots->data, (n - first) * size);
+        }
+
+        NPK_spsc_queue NPK_spsc_queue_new_(int size, int maxlen) {
+            NPK_spsc_queue q;
+
+            q.size = size;
+            q.slots = NPK_array_sized_new_(size, NPK_ceil_pow2_(maxlen));
+            atomic_init(&q.tail, 0);
+            atomic_init(&q.head, 0);
+            q.cached_head = 0;
+            q.cached_tail = 0;
+
+            return q;
+        }
+
+        int NPK_spsc_queue_push_n(NPK_spsc_queue *q, const void *vals, int n) {
+            size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            int space = q->slots.maxlen - NPK_cast(int, tail - q->cached_head);
+
+            if (space < n) {
+                q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+                space = q->slots.maxlen - NPK_cast(int, tail - q->cached_head);
+            }
+
+            n = n < space ? n : space;
+
+            if (n > 0) {
+                NPK_ring_copy_in_(q->size, &q->slots, tail, vals, n);
+                atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+            }
+
+            return n;
+        }
+
+        int NPK_spsc_queue_pop_n(NPK_spsc_queue *q, void *vals, int n) {
+            size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+            int ready = NPK_cast(int, q->cached_tail - head);
+
+            if (ready < n) {
+                q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+                ready = NPK_cast(int, q->cached_tail - head);
+            }
+
+            n = n < ready ? n : ready;
+
+            if (n > 0) {
+                NPK_ring_copy_out_(q->size, &q->slots, head, vals, n);
+                atomic_store_explicit(&q->head, head + n, memory_order_release);
+            }
+
+            return n;
+        }
+
+        NPK_mpmc_queue NPK_mpmc_queue_new_(int size, int maxlen) {
+            NPK_mpmc_queue q;
+            int len = NPK_ceil_pow2_(maxlen);
+
+            q.size = size;
+            q.slots = NPK_array_sized_new_(size, len);
+            q.seqs = NPK_array_sized_new(atomic_size_t, len);
+            atomic_init(&q.tail, 0);
+            atomic_init(&q.head, 0);
+
+            // A slot whose sequence equals an index is free for the producer of that index
+            NPK_count_up (i, 0, len) {
+                atomic_init(NPK_array_data(atomic_size_t, &q.seqs) + i, i);
+            }
+
+            return q;
+        }
+
+        int NPK_mpmc_queue_push_n(NPK_mpmc_queue *q, const void *vals, int n) {
+            atomic_size_t *seqs = q->seqs.data;
+            size_t mask = q->seqs.maxlen - 1;
+            size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            int count;
+
+            while (true) {
+                count = 0;
+
+                // A free slot stays free until the index is claimed, so the whole run can be claimed at once
+                while (count < n && atomic_load_explicit(seqs + ((tail + count) & mask), memory_order_acquire) == tail + count) {
+                    count++;
+                }
+
+                if (count == 0) {
+                    size_t seq = atomic_load_explicit(seqs + (tail & mask), memory_order_acquire);
+
+                    // The slot still holds an element of the previous lap, so the queue is full
+                    if (NPK_cast(int64_t, seq - tail) < 0) {
+                        return 0;
+                    }
+
+                    tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+                } else if (atomic_compare_exchange_weak_explicit(&q->tail, &tail, tail + count, memory_order_relaxed, memory_order_relaxed)) {
+                    break;
+                }
+            }
+
+            NPK_count_up (i, 0, count) {
+                memcpy(NPK_array_data(uint8_t, &q->slots) + ((tail + i) & mask) * q->size, NPK_cast(const uint8_t *, vals) + i * q->size, q->size);
+                atomic_store_explicit(seqs + ((tail + i) & mask), tail + i + 1, memory_order_release);
+            }
+
+            return count;
+        }
+
+        int NPK_mpmc_queue_pop_n(NPK_mpmc_queue *q, void *vals, int n) {
+            atomic_size_t *seqs = q->seqs.data;
+            size_t mask = q->seqs.maxlen - 1;
+            size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+            int count;
+
+            while (true) {
+                count = 0;
+
+                // A slot whose sequence is one past an index holds the element of that index
+                while (count < n && atomic_load_explicit(seqs + ((head + count) & mask), memory_order_acquire) == head + count + 1) {
+                    count++;
+                }
+
+                if (count == 0) {
+                    size_t seq = atomic_load_explicit(seqs + (head & mask), memory_order_acquire);
+
+                    // The producer of this index hasn't finished yet, so the queue is empty
+                    if (NPK_cast(int64_t, seq - (head + 1)) < 0) {
+                        return 0;
+                    }
+
+                    head = atomic_load_explicit(&q->head, memory_order_relaxed);
+                } else if (atomic_compare_exchange_weak_explicit(&q->head, &head, head + count, memory_order_relaxed, memory_order_relaxed)) {
+                    break;
+                }
+            }
+
+            NPK_count_up (i, 0, count) {
+                memcpy(NPK_cast(uint8_t *, vals) + i * q->size, NPK_array_data(uint8_t, &q->slots) + ((head + i) & mask) * q->size, q->size);
+                atomic_store_explicit(seqs + ((head + i) & mask), head + i + mask + 1, memory_order_release);
+            }
+
+            return count;
+        }
+
+        void NPK_mpmc_queue_del(NPK_mpmc_queue *q) {
+            NPK_array_del(&q->slots);
+            NPK_array_del(&q->seqs);
+        }
+    #endif
+
+    int NPK_cpu_count_(void) {
+        #if defined NPK_POSIX_ && defined _SC_NPROCESSORS_ONLN
+            long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+            return count > 0 ? count : 1;
+        #else
+            return 4;
+        #endif
+    }
+
+    #if defined NPK_PARALLEL_
+        typedef struct {
+            void (*fn)(void *ctx, int begin, int end);
+            void *ctx;
+            int begin;
+            int end;
+            atomic_int *pending;
+        } NPK_pool_task_;
+
+        typedef union {
+            struct {
+                NPK_ring tasks;
+                mtx_t lock;
+                thrd_t thread;
+                int idx;
+                struct NPK_pool_state_ *state;
+            };
+
+            // Keeps the lock of every worker on its own cache lines
+            char padding[128];
+        } NPK_pool_worker_;
+
+        // Lives on the heap, so the workers can point at it no matter where the NPK_pool value is copied
+        struct NPK_pool_state_ {
+            NPK_array workers;
+            mtx_t lock;
+            cnd_t wake;
+            atomic_int queued;
+            atomic_uint next;
+            bool stop;
+        };
+
+        // The owner takes its newest task, which is the most likely to still be in its cache, and thieves take the oldest
+        bool NPK_pool_take_(struct NPK_pool_state_ *state, int self, void *task) {
+            int count = NPK_array_length(&state->workers);
+
+            NPK_count_up (i, 0, count) {
+                NPK_pool_worker_ *worker = NPK_array_data(NPK_pool_worker_, &state->workers) + (self + i) % count;
+                bool found;
+
+                mtx_lock(&worker->lock);
+
+                if (i == 0 && self < count) {
+                    found = NPK_ring_pop_back(NPK_pool_task_, &worker->tasks, task);
+                } else {
+                    found = NPK_ring_pop_front(NPK_pool_task_, &worker->tasks, task);
+                }
+
+                mtx_unlock(&worker->lock);
+
+                if (found) {
+                    atomic_fetch_sub(&state->queued, 1);
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        int NPK_pool_work_(void *p) {
+            NPK_pool_worker_ *worker = p;
+            struct NPK_pool_state_ *state = worker->state;
+            NPK_pool_task_ task;
+
+            while (true) {
+                if (NPK_pool_take_(state, worker->idx, &task)) {
+                    task.fn(task.ctx, task.begin, task.end);
+                    atomic_fetch_sub_explicit(task.pending, 1, memory_order_release);
+
+                    continue;
+                }
+
+                mtx_lock(&state->lock);
+
+                while (atomic_load(&state->queued) == 0 && state->stop == false) {
+                    cnd_wait(&state->wake, &state->lock);
+                }
+
+                bool stop = state->stop && atomic_load(&state->queued) == 0;
+
+                mtx_unlock(&state->lock);
+
+                if (stop) {
+                    return 0;
+                }
+            }
+        }
+    #endif
+
+    NPK_pool NPK_pool_new(int threads) {
+        NPK_pool pool;
+
+        pool.threads = threads > 0 ? threads : NPK_cpu_count_();
+        pool.state = NULL;
+
+        #if defined NPK_PARALLEL_
+            struct NPK_pool_state_ *state = malloc(sizeof *state);
+
+            NPK_stats_alloc_(NPK_stats_other, NPK_sizeof_type(struct NPK_pool_state_));
+            state->workers = NPK_array_sized_new(NPK_pool_worker_, pool.threads);
+            state->workers.len = pool.threads;
+            mtx_init(&state->lock, mtx_plain);
+            cnd_init(&state->wake);
+            atomic_init(&state->queued, 0);
+            atomic_init(&state->next, 0);
+            state->stop = false;
+
+            NPK_count_up (i, 0, pool.threads) {
+                NPK_pool_worker_ *worker = NPK_array_data(NPK_pool_worker_, &state->workers) + i;
+
+                worker->tasks = NPK_ring_new(NPK_pool_task_);
+                worker->idx = i;
+                worker->state = state;
+                mtx_init(&worker->lock, mtx_plain);
+            }
+
+            // The workers only start once every deque exists, since they steal from all of them
+            NPK_for_each (NPK_pool_worker_, worker, &state->workers) {
+                thrd_create(&worker->thread, NPK_pool_work_, worker);
+            }
+
+            pool.state = state;
+        #endif
+
+        return pool;
+    }
+
+    void NPK_pool_run(NPK_pool *pool, int len, int grain, void (*fn)(void *ctx, int begin, int end), void *ctx) {
+        grain = grain > 0 ? grain : 1;
+
+        if (pool == NULL || pool->state == NULL || len <= grain) {
+            NPK_count_up (i, 0, (len + grain - 1) / grain) {
+                fn(ctx, i * grain, (i + 1) * grain < len ? (i + 1) * grain : len);
+            }
+
+            return;
+        }
+
+        #if defined NPK_PARALLEL_
+            struct NPK_pool_state_ *state = pool->state;
+            int count = (len + grain - 1) / grain;
+            int workers = NPK_array_length(&state->workers);
+            int first = atomic_fetch_add(&state->next, 1) % workers;
+            atomic_int pending;
+            NPK_pool_task_ task;
+
+            atomic_init(&pending, count);
+
+            // Consecutive ranges go to the same worker, so that stealing takes whole blocks of neighbouring ranges
+            NPK_count_up (w, 0, workers) {
+                NPK_pool_worker_ *worker = NPK_array_data(NPK_pool_worker_, &state->workers) + (first + w) % workers;
+                int from = NPK_cast(int64_t, count) * w / workers;
+                int to = NPK_cast(int64_t, count) * (w + 1) / workers;
+
+                mtx_lock(&worker->lock);
+
+                NPK_count_down (i, to, from) {
+                    task = (NPK_pool_task_) {fn, ctx, i * grain, (i + 1) * grain < len ? (i + 1) * grain : len, &pending};
+                    NPK_ring_push_back(NPK_pool_task_, &worker->tasks, task);
+                }
+
+                mtx_unlock(&worker->lock);
+            }
+
+            atomic_fetch_add(&state->queued, count);
+            mtx_lock(&state->lock);
+            cnd_broadcast(&state->wake);
+            mtx_unlock(&state->lock);
+
+            // Helps with any queued task instead of blocking, which is what keeps nested parallel operations from deadlocking
+            while (atomic_load_explicit(&pending, memory_order_acquire) > 0) {
+                if (NPK_pool_take_(state, workers, &task)) {
+                    task.fn(task.ctx, task.begin, task.end);
+                    atomic_fetch_sub_explicit(task.pending, 1, memory_order_release);
+                } else {
+                    thrd_yield();
+                }
+            }
+        #endif
+    }
+
+    void NPK_pool_del(NPK_pool *pool) {
+        #if defined NPK_PARALLEL_
+            struct NPK_pool_state_ *state = pool->state;
+
+            mtx_lock(&state->lock);
+            state->stop = true;
+            cnd_broadcast(&state->wake);
+            mtx_unlock(&state->lock);
+
+            NPK_for_each (NPK_pool_worker_, worker, &state->workers) {
+                thrd_join(worker->thread, NULL);
+            }
+
+            NPK_for_each (NPK_pool_worker_, worker, &state->workers) {
+                NPK_ring_del(&worker->tasks);
+                mtx_destroy(&worker->lock);
+            }
+
+            NPK_array_del(&state->workers);
+            mtx_destroy(&state->lock);
+            cnd_destroy(&state->wake);
+            free(state);
+        #endif
+
+        pool->state = NULL;
+    }
+
+    // Everything a parallel operation on an array needs to process a single range
+    typedef struct {
+        int size;
+        int out_size;
+        int grain;
+        int dim;
+        const NPK_array *arr;
+        NPK_array *out;
+        void *partials;
+        void (*fn)(void);
+        void *ctx;
+    } NPK_parallel_array_;
+
+    void NPK_parallel_for_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        void (*fn)(void *chunk, int len, void *ctx) = NPK_cast(void (*)(void *, int, void *), op->fn);
+
+        fn(NPK_array_data(uint8_t, op->arr) + begin * op->size, end - begin, op->ctx);
+    }
+
+    void NPK_array_parallel_for_(int size, NPK_pool *pool, const NPK_array *arr, void (*fn)(void *chunk, int len, void *ctx), void *ctx) {
+        NPK_parallel_array_ op = {.size = size, .arr = arr, .fn = NPK_cast(void (*)(void), fn), .ctx = ctx};
+
+        NPK_pool_run(pool, NPK_array_length(arr), NPK_pool_grain_(size), NPK_parallel_for_range_, &op);
+    }
+
+    void NPK_parallel_map_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        void (*fn)(const void *in, void *out, int len, void *ctx) = NPK_cast(void (*)(const void *, void *, int, void *), op->fn);
+
+        fn(NPK_array_data(uint8_t, op->arr) + begin * op->size, NPK_array_data(uint8_t, op->out) + begin * op->out_size, end - begin, op->ctx);
+    }
+
+    NPK_array NPK_array_parallel_map_new_(int size, int out_size, NPK_pool *pool, const NPK_array *arr, void (*fn)(const void *in, void *out, int len, void *ctx), void *ctx) {
+        NPK_array out = NPK_array_sized_new_(out_size, NPK_array_length(arr) > 0 ? NPK_array_length(arr) : 1);
+        NPK_parallel_array_ op = {.size = size, .out_size = out_size, .arr = arr, .out = &out, .fn = NPK_cast(void (*)(void), fn), .ctx = ctx};
+
+        out.len = NPK_array_length(arr);
+        NPK_pool_run(pool, NPK_array_length(arr), NPK_pool_grain_(size), NPK_parallel_map_range_, &op);
+
+        return out;
+    }
+
+    void NPK_parallel_reduce_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        void (*reduce)(const void *chunk, int len, void *partial, void *ctx) = NPK_cast(void (*)(const void *, int, void *, void *), op->fn);
+
+        NPK_count_up (i, begin, end) {
+            int from = i * op->grain;
+            int to = from + op->grain < NPK_array_length(op->arr) ? from + op->grain : NPK_array_length(op->arr);
+
+            reduce(NPK_array_data(uint8_t, op->arr) + from * op->size, to - from, NPK_cast(uint8_t *, op->partials) + i * op->out_size, op->ctx);
+        }
+    }
+
+    void NPK_array_parallel_reduce_(int size, int acc_size, NPK_pool *pool, const NPK_array *arr, void *acc, void (*reduce)(const void *chunk, int len, void *partial, void *ctx), void (*merge)(void *acc, const void *partial, void *ctx), void *ctx) {
+        int grain = NPK_pool_grain_(size);
+        int count = (NPK_array_length(arr) + grain - 1) / grain;
+
+        if (count == 0) {
+            return;
+        }
+
+        NPK_parallel_array_ op = {.size = size, .out_size = acc_size, .grain = grain, .arr = arr, .partials = malloc(count * acc_size), .fn = NPK_cast(void (*)(void), reduce), .ctx = ctx};
+
+        NPK_stats_alloc_(NPK_stats_other, count * acc_size);
+
+        NPK_count_up (i, 0, count) {
+            memcpy(NPK_cast(uint8_t *, op.partials) + i * acc_size, acc, acc_size);
+        }
+
+        NPK_pool_run(pool, count, 1, NPK_parallel_reduce_range_, &op);
+
+        // The partials are merged in the order of their ranges, so the result never depends on the scheduling
+        memcpy(acc, op.partials, acc_size);
+
+        NPK_count_up (i, 1, count) {
+            merge(acc, NPK_cast(uint8_t *, op.partials) + i * acc_size, ctx);
+        }
+
+        free(op.partials);
+    }
+
+    void NPK_parallel_filter_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        bool (*keep)(const void *elem, void *ctx) = NPK_cast(bool (*)(const void *, void *), op->fn);
+
+        NPK_count_up (i, begin, end) {
+            NPK_array *part = NPK_cast(NPK_array *, op->partials) + i;
+            int to = (i + 1) * op->grain < NPK_array_length(op->arr) ? (i + 1) * op->grain : NPK_array_length(op->arr);
+
+            *part = NPK_array_new_(op->size);
+
+            NPK_count_up (j, i * op->grain, to) {
+                void *cur = NPK_array_data(uint8_t, op->arr) + j * op->size;
+
+                if (keep(cur, op->ctx)) {
+                    NPK_array_add_(op->size, part, cur);
+                }
+            }
+        }
+    }
+
+    NPK_array NPK_array_parallel_filter_new_(int size, NPK_pool *pool, const NPK_array *arr, bool (*keep)(const void *elem, void *ctx), void *ctx) {
+        int grain = NPK_pool_grain_(size);
+        int count = (NPK_array_length(arr) + grain - 1) / grain;
+        NPK_parallel_array_ op = {.size = size, .grain = grain, .arr = arr, .partials = malloc((count > 0 ? count : 1) * NPK_sizeof_type(NPK_array)), .fn = NPK_cast(void (*)(void), keep), .ctx = ctx};
+        int len = 0;
+
+        NPK_stats_alloc_(NPK_stats_other, (count > 0 ? count : 1) * NPK_sizeof_type(NPK_array));
+        NPK_pool_run(pool, count, 1, NPK_parallel_filter_range_, &op);
+
+        NPK_count_up (i, 0, count) {
+            len += NPK_array_length(NPK_cast(NPK_array *, op.partials) + i);
+        }
+
+        NPK_array kept = NPK_array_sized_new_(size, len > 0 ? len : 1);
+
+        NPK_count_up (i, 0, count) {
+            NPK_array *part = NPK_cast(NPK_array *, op.partials) + i;
+
+            memcpy(NPK_array_data(uint8_t, &kept) + kept.len * size, part->data, NPK_array_length(part) * size);
+            kept.len += NPK_array_length(part);
+            NPK_array_del(part);
+        }
+
+        free(op.partials);
+
+        return kept;
+    }
+
+    void NPK_parallel_sort_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        int (*type_compare)(const void *p1, const void *p2) = NPK_cast(int (*)(const void *, const void *), op->fn);
+
+        NPK_count_up (i, begin, end) {
+            int from = i * op->grain;
+            int to = from + op->grain < NPK_array_length(op->arr) ? from + op->grain : NPK_array_length(op->arr);
+
+            qsort(NPK_array_data(uint8_t, op->arr) + from * op->size, to - from, op->size, type_compare);
+        }
+    }
+
+    // Merges the sorted runs of length "grain" pairwise from "arr" into "out", taking the left element on ties
+    void NPK_parallel_merge_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        int (*type_compare)(const void *p1, const void *p2) = NPK_cast(int (*)(const void *, const void *), op->fn);
+        int len = NPK_array_length(op->arr);
+        uint8_t *src = op->arr->data;
+        uint8_t *dst = op->out->data;
+
+        NPK_count_up (i, begin, end) {
+            int left = 2 * i * op->grain;
+            int mid = left + op->grain < len ? left + op->grain : len;
+            int right = mid + op->grain < len ? mid + op->grain : len;
+            int l = left;
+            int r = mid;
+            int k = left;
+
+            while (l < mid && r < right) {
+                if (type_compare(src + r * op->size, src + l * op->size) < 0) {
+                    memcpy(dst + k++ * op->size, src + r++ * op->size, op->size);
+                } else {
+                    memcpy(dst + k++ * op->size, src + l++ * op->size, op->size);
+                }
+            }
+
+            memcpy(dst + k * op->size, src + l * op->size, (mid - l) * op->size);
+            k += mid - l;
+            memcpy(dst + k * op->size, src + r * op->size, (right - r) * op->size);
+        }
+    }
+
+    void NPK_array_parallel_sort_(int size, NPK_pool *pool, NPK_array *arr, int (*type_compare)(const void *p1, const void *p2)) {
+        int len = NPK_array_length(arr);
+        int grain = (len + 31) / 32;
+
+        // Small arrays aren't worth the extra copies of the merge passes, the runs never depend on the number of threads
+        // since qsort may order equal elements differently for different runs
+        if (len <= 4 * NPK_pool_grain_(size)) {
+            qsort(arr->data, len, size, type_compare);
+
+            return;
+        }
+
+        NPK_array tmp = NPK_array_sized_new_(size, len);
+        NPK_array src = *arr;
+        NPK_array dst = tmp;
+        NPK_parallel_array_ op = {.size = size, .grain = grain, .arr = &src, .out = &dst, .fn = NPK_cast(void (*)(void), type_compare)};
+
+        NPK_pool_run(pool, (len + grain - 1) / grain, 1, NPK_parallel_sort_range_, &op);
+
+        for (; op.grain < len; op.grain *= 2) {
+            int pairs = (len + 2 * op.grain - 1) / (2 * op.grain);
+
+            dst.len = len;
+            NPK_pool_run(pool, pairs, 1, NPK_parallel_merge_range_, &op);
+
+            NPK_array swap = src;
+
+            src = dst;
+            dst = swap;
+        }
+
+        if (src.data != arr->data) {
+            memcpy(arr->data, src.data, len * size);
+        }
+
+        NPK_array_del(&tmp);
+    }
+
+    void NPK_parallel_copy_range_(void *ctx, int begin, int end) {
+        NPK_parallel_array_ *op = ctx;
+        if (op->dim > 1) {
+            NPK_count_up (i, begin, end) {
+                NPK_array_data(NPK_array, op->out)[i] = NPK_array_copy_new_(op->size, NPK_array_data(NPK_array, op->arr) + i, op->dim - 1);
+            }
+        } else {
+            memcpy(NPK_array_data(uint8_t, op->out) + begin * op->size, NPK_array_data(uint8_t, op->arr) + begin * op->size, (end - begin) * op->size);
+        }
+    }
+
+    NPK_array NPK_array_parallel_copy_new_(int size, NPK_pool *pool, const NPK_array *arr, int dim) {
+        NPK_array copy = NPK_array_sized_new_(dim > 1 ? NPK_cast(int, NPK_sizeof_type(NPK_array)) : size, arr->maxlen);
+        NPK_parallel_array_ op = {.size = size, .arr = arr, .dim = dim, .out = &copy};
+
+        copy.len = NPK_array_length(arr);
+        NPK_pool_run(pool, NPK_array_length(arr), dim > 1 ? 1 : NPK_pool_grain_(size), NPK_parallel_copy_range_, &op);
+
+        return copy;
+    }
+
+    NPK_heap NPK_heap_new_(int size, int (*type_compare)(const void *p1, const void *p2), int arity, int limit, bool indexed) {
+        NPK_heap h;
+
+        h.size = size;
+        h.arity = arity > 1 ? arity : 2;
+        h.limit = limit;
+        h.items = NPK_array_sized_new_(size, limit > 0 ? limit + 1 : 8);
+        h.type_compare = type_compare;
+
+        // Handles are only tracked by an indexed heap, the others leave these arrays unallocated
+        h.ids = (NPK_array) {0, 0, NULL};
+        h.positions = (NPK_array) {0, 0, NULL};
+        h.free_ids = (NPK_array) {0, 0, NULL};
+
+        if (indexed) {
+            h.ids = NPK_array_new(int);
+            h.positions = NPK_array_new(int);
+            h.free_ids = NPK_array_new(int);
+        }
+
+        return h;
+    }
+
+    NPK_heap NPK_heap_from_array_new_(int size, const NPK_array *arr, int (*type_compare)(const void *p1, const void *p2)) {
+        NPK_heap h = NPK_heap_new_(size, type_compare, 2, 0, false);
+
+        NPK_array_reserve_(size, &h.items, NPK_array_length(arr));
+        memcpy(h.items.data, arr->data, NPK_array_length(arr) * size);
+        h.items.len = NPK_array_length(arr);
+
+        // Sifting down every parent, starting from the last one, costs O(n) in total
+        NPK_count_down (i, NPK_heap_length(&h) / 2, 0) {
+            NPK_heap_sift_down_(&h, i);
+        }
+
+        return h;
+    }
+
+    // Moves the element at "from" to "to" along with its handle
+    void NPK_heap_move_(NPK_heap *h, int from, int to) {
+        memcpy(NPK_array_data(uint8_t, &h->items) + to * h->size, NPK_array_data(uint8_t, &h->items) + from * h->size, h->size);
+
+        if (h->ids.data != NULL) {
+            int id = NPK_array_data(int, &h->ids)[from];
+
+            NPK_array_data(int, &h->ids)[to] = id;
+            NPK_array_data(int, &h->positions)[id] = to;
+        }
+    }
+
+    // The element is held aside while its ancestors move down, instead of being swapped at every level
+    void NPK_heap_sift_up_(NPK_heap *h, int pos) {
+        void *tmp = alloca(h->size);
+        int id = h->ids.data != NULL ? NPK_array_data(int, &h->ids)[pos] : -1;
+
+        memcpy(tmp, NPK_array_data(uint8_t, &h->items) + pos * h->size, h->size);
+
+        while (pos > 0) {
+            int parent = (pos - 1) / h->arity;
+
+            if (h->type_compare(tmp, NPK_array_data(uint8_t, &h->items) + parent * h->size) >= 0) {
+                break;
+            }
+
+            NPK_heap_move_(h, parent, pos);
+            pos = parent;
+        }
+
+        memcpy(NPK_array_data(uint8_t, &h->items) + pos * h->size, tmp, h->size);
+
+        if (id != -1) {
+            NPK_array_data(int, &h->ids)[pos] = id;
+            NPK_array_data(int, &h->positions)[id] = pos;
+        }
+    }
+
+    void NPK_heap_sift_down_(NPK_heap *h, int pos) {
+        void *tmp = alloca(h->size);
+        int id = h->ids.data != NULL ? NPK_array_data(int, &h->ids)[pos] : -1;
+        int len = NPK_heap_length(h);
+
+        memcpy(tmp, NPK_array_data(uint8_t, &h->items) + pos * h->size, h->size);
+
+        while (true) {
+            int first = pos * h->arity + 1;
+            int last = first + h->arity < len ? first + h->arity : len;
+            int best = first;
+
+            if (first >= len) {
+                break;
+            }
+
+            NPK_count_up (child, first + 1, last) {
+                if (h->type_compare(NPK_array_data(uint8_t, &h->items) + child * h->size, NPK_array_data(uint8_t, &h->items) + best * h->size) < 0) {
+                    best = child;
+                }
+            }
+
+            if (h->type_compare(NPK_array_data(uint8_t, &h->items) + best * h->size, tmp) >= 0) {
+                break;
+            }
+
+            NPK_heap_move_(h, best, pos);
+            pos = best;
+        }
+
+        memcpy(NPK_array_data(uint8_t, &h->items) + pos * h->size, tmp, h->size);
+
+        if (id != -1) {
+            NPK_array_data(int, &h->ids)[pos] = id;
+            NPK_array_data(int, &h->positions)[id] = pos;
+        }
+    }
+
+    int NPK_heap_push_(NPK_heap *h, const void *val) {
+        int id = -1;
+
+        if (h->limit > 0 && NPK_heap_length(h) == h->limit) {
+            // A full bounded heap only takes an element that beats its top, which is the least of those it keeps
+            if (h->type_compare(val, h->items.data) > 0) {
+                memcpy(h->items.data, val, h->size);
+                NPK_heap_sift_down_(h, 0);
+            }
+
+            return -1;
+        }
+
+        NPK_array_add_(h->size, &h->items, val);
+
+        if (h->ids.data != NULL) {
+            if (NPK_array_is_empty(&h->free_ids)) {
+                id = NPK_array_length(&h->positions);
+                NPK_array_add(int, &h->positions, 0);
+            } else {
+                id = NPK_array_data(int, &h->free_ids)[--h->free_ids.len];
+            }
+
+            NPK_array_add(int, &h->ids, id);
+            NPK_array_data(int, &h->positions)[id] = NPK_heap_length(h) - 1;
+        }
+
+        NPK_heap_sift_up_(h, NPK_heap_length(h) - 1);
+
+        return id;
+    }
+
+    void NPK_heap_remove_at_(NPK_heap *h, int pos, void *val) {
+        int last = NPK_heap_length(h) - 1;
+
+        if (val != NULL) {
+            memcpy(val, NPK_array_data(uint8_t, &h->items) + pos * h->size, h->size);
+        }
+
+        if (h->ids.data != NULL) {
+            int id = NPK_array_data(int, &h->ids)[pos];
+
+            NPK_array_data(int, &h->positions)[id] = -1;
+            NPK_array_add(int, &h->free_ids, id);
+        }
+
+        // The last element fills the hole and then moves whichever way restores the order
+        if (pos != last) {
+            NPK_heap_move_(h, last, pos);
+        }
+
+        h->items.len--;
+        h->ids.len -= h->ids.data != NULL;
+
+        if (pos < last) {
+            NPK_heap_sift_down_(h, pos);
+            NPK_heap_sift_up_(h, pos);
+        }
+    }
+
+    bool NPK_heap_pop(NPK_heap *h, void *val) {
+        if (NPK_heap_is_empty(h)) {
+            return false;
+        }
+
+        NPK_heap_remove_at_(h, 0, val);
+
+        return true;
+    }
+
+    bool NPK_heap_contains(const NPK_heap *h, int handle) {
+        return h->positions.data != NULL && handle >= 0 && handle < NPK_array_length(&h->positions) && NPK_array_data(int, &h->positions)[handle] != -1;
+    }
+
+    void NPK_heap_update_(NPK_heap *h, int handle, const void *val) {
+        if (NPK_heap_contains(h, handle) == false) {
+            return;
+        }
+
+        int pos = NPK_array_data(int, &h->positions)[handle];
+
+        memcpy(NPK_array_data(uint8_t, &h->items) + pos * h->size, val, h->size);
+        NPK_heap_sift_up_(h, pos);
+        NPK_heap_sift_down_(h, NPK_array_data(int, &h->positions)[handle]);
+    }
+
+    bool NPK_heap_remove(NPK_heap *h, int handle) {
+        if (NPK_heap_contains(h, handle) == false) {
+            return false;
+        }
+
+        NPK_heap_remove_at_(h, NPK_array_data(int, &h->positions)[handle], NULL);
+
+        return true;
+    }
+
+    void NPK_heap_del(NPK_heap *h) {
+        NPK_array_del(&h->items);
+
+        if (h->ids.data != NULL) {
+            NPK_array_del(&h->ids);
+            NPK_array_del(&h->positions);
+            NPK_array_del(&h->free_ids);
+        }
+    }
+
+    NPK_bitset NPK_bitset_new(int len) {
+        NPK_bitset bs;
+        int count = NPK_bitset_word_count_(len);
+
+        bs.len = len;
+        bs.words = NPK_array_sized_new(uint64_t, count > 0 ? count : 1);
+        bs.words.len = count;
+        memset(bs.words.data, 0, count * NPK_sizeof_type(uint64_t));
+
+        return bs;
+    }
+
+    NPK_bitset NPK_bitset_copy_new(const NPK_bitset *bs) {
+        NPK_bitset copy = NPK_bitset_new(NPK_bitset_length(bs));
+
+        memcpy(copy.words.data, bs->words.data, NPK_array_length(&bs->words) * NPK_sizeof_type(uint64_t));
+
+        return copy;
+    }
+
+    NPK_bitset NPK_bitset_from_bools_new(const NPK_array *bools) {
+        NPK_bitset bs = NPK_bitset_new(NPK_array_length(bools));
+        const bool *b = bools->data;
+        int len = NPK_array_length(bools);
+        int i = 0;
+
+        // A bool is stored as a 0 or 1 byte, so comparing bytes against zero and taking the sign bits packs them in order
+        #if defined NPK_AVX2_
+            for (; i + 32 <= len; i += 32) {
+                __m256i v = _mm256_loadu_si256(NPK_cast(const __m256i *, b + i));
+                uint32_t bits = ~NPK_cast(uint32_t, _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+
+                NPK_bitset_words(&bs)[i / 64] |= NPK_cast(uint64_t, bits) << (i % 64);
+            }
+        #endif
+
+        #if defined NPK_SSE2_
+            for (; i + 16 <= len; i += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, b + i));
+                uint32_t bits = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) & 0xFFFF;
+
+                NPK_bitset_words(&bs)[i / 64] |= NPK_cast(uint64_t, bits) << (i % 64);
+            }
+        #endif
+
+        for (; i < len; i++) {
+            NPK_bitset_words(&bs)[i / 64] |= NPK_cast(uint64_t, b[i] != false) << (i % 64);
+        }
+
+        return bs;
+    }
+
+    NPK_array NPK_bitset_to_bools_new(const NPK_bitset *bs) {
+        NPK_array bools = NPK_array_sized_new(bool, NPK_bitset_length(bs) > 0 ? NPK_bitset_length(bs) : 1);
+
+        NPK_count_up (i, 0, NPK_bitset_length(bs)) {
+            NPK_array_data(bool, &bools)[i] = NPK_bitset_get(bs, i);
+        }
+
+        bools.len = NPK_bitset_length(bs);
+
+        return bools;
+    }
+
+    void NPK_bitset_fill(NPK_bitset *bs, bool val) {
+        int count = NPK_array_length(&bs->words);
+
+        memset(bs->words.data, val ? 0xFF : 0, count * NPK_sizeof_type(uint64_t));
+
+        if (val && count > 0) {
+            NPK_bitset_words(bs)[count - 1] &= NPK_bitset_tail_mask_(NPK_bitset_length(bs));
+        }
+    }
+
+    int NPK_bitset_count(const NPK_bitset *bs) {
+        int count = 0;
+
+        NPK_for_each (uint64_t, word, &bs->words) {
+            count += NPK_popcount64_(*word);
+        }
+
+        return count;
+    }
+
+    bool NPK_bitset_equals(const NPK_bitset *bs1, const NPK_bitset *bs2) {
+        return NPK_bitset_length(bs1) == NPK_bitset_length(bs2) && memcmp(bs1->words.data, bs2->words.data, NPK_array_length(&bs1->words) * NPK_sizeof_type(uint64_t)) == 0;
+    }
+
+    // Generates a function that combines two bitsets with the same operation on vectors and on single words
+    // The bits of "dst" past the end of a shorter "src" are put back into the last word they share
+    #define bitset_op(name, avx2_op, sse2_op, word_op)                                         \
+    void NPK_bitset_##name(NPK_bitset *dst, const NPK_bitset *src) {                           \
+        int count = NPK_array_length(&dst->words);                                             \
+        uint64_t *d = dst->words.data;                                                         \
+        const uint64_t *s = src->words.data;                                                   \
+        uint64_t kept = 0;                                                                     \
+        int i = 0;                                                                             \
+                                                                                               \
+        count = count < NPK_array_length(&src->words) ? count : NPK_array_length(&src->words); \
+                                                                                               \
+        if (count > 0 && NPK_bitset_length(src) < NPK_bitset_length(dst)) {                   \
+            kept = d[count - 1] & ~NPK_bitset_tail_mask_(NPK_bitset_length(src));             \
+        }                                                                                      \
+                                                                                               \
+        avx2_op                                                                                \
+        sse2_op                                                                                \
+                                                                                               \
+        for (; i < count; i++) {                                                               \
+            d[i] = word_op;                                                                    \
+        }                                                                                      \
+                                                                                               \
+        if (count > 0) {                                                                       \
+            d[count - 1] |= kept;                                                              \
+        }                                                                                      \
+                                                                                               \
+        if (count > 0 && count == NPK_array_length(&dst->words)) {                             \
+            d[count - 1] &= NPK_bitset_tail_mask_(NPK_bitset_length(dst));                     \
+        }                                                                                      \
+    }
+
+    #if defined NPK_AVX2_
+        #define avx2_loop(intrinsic)                                           \
+        for (; i + 4 <= count; i += 4) {                                       \
+            __m256i vd = _mm256_loadu_si256(NPK_cast(const __m256i *, d + i)); \
+            __m256i vs = _mm256_loadu_si256(NPK_cast(const __m256i *, s + i)); \
+                                                                               \
+            _mm256_storeu_si256(NPK_cast(__m256i *, d + i), intrinsic);        \
+        }
+    #else
+        #define avx2_loop(intrinsic)
+    #endif
+
+    #if defined NPK_SSE2_
+        #define sse2_loop(intrinsic)                                        \
+        for (; i + 2 <= count; i += 2) {                                    \
+            __m128i vd = _mm_loadu_si128(NPK_cast(const __m128i *, d + i)); \
+            __m128i vs = _mm_loadu_si128(NPK_cast(const __m128i *, s + i)); \
+                                                                            \
+            _mm_storeu_si128(NPK_cast(__m128i *, d + i), intrinsic);        \
+        }
+    #else
+        #define sse2_loop(intrinsic)
+    #endif
+
+    bitset_op(and, avx2_loop(_mm256_and_si256(vd, vs)), sse2_loop(_mm_and_si128(vd, vs)), d[i] & s[i])
+    bitset_op(or, avx2_loop(_mm256_or_si256(vd, vs)), sse2_loop(_mm_or_si128(vd, vs)), d[i] | s[i])
+    bitset_op(xor, avx2_loop(_mm256_xor_si256(vd, vs)), sse2_loop(_mm_xor_si128(vd, vs)), d[i] ^ s[i])
+    bitset_op(andnot, avx2_loop(_mm256_andnot_si256(vs, vd)), sse2_loop(_mm_andnot_si128(vs, vd)), d[i] & ~s[i])
+
+    #undef bitset_op
+    #undef avx2_loop
+    #undef sse2_loop
+
+    int NPK_bitset_next_set(const NPK_bitset *bs, int idx) {
+        if (idx < 0 || idx >= NPK_bitset_length(bs)) {
+            return -1;
+        }
+
+        int i = idx / 64;
+        uint64_t word = NPK_bitset_words(bs)[i] & (UINT64_MAX << (idx % 64));
+
+        while (word == 0) {
+            if (++i == NPK_array_length(&bs->words)) {
+                return -1;
+            }
+
+            word = NPK_bitset_words(bs)[i];
+        }
+
+        return i * 64 + NPK_ctz64_(word);
+    }
+
+    int NPK_bitset_rank(const NPK_bitset *bs, int idx) {
+        int rank = 0;
+
+        idx = idx < NPK_bitset_length(bs) ? idx : NPK_bitset_length(bs);
+
+        NPK_count_up (i, 0, idx / 64) {
+            rank += NPK_popcount64_(NPK_bitset_words(bs)[i]);
+        }
+
+        if (idx % 64 != 0) {
+            rank += NPK_popcount64_(NPK_bitset_words(bs)[idx / 64] & ((UINT64_C(1) << (idx % 64)) - 1));
+        }
+
+        return rank;
+    }
+
+    int NPK_bitset_select(const NPK_bitset *bs, int rank) {
+        if (rank < 0) {
+            return -1;
+        }
+
+        NPK_count_up (i, 0, NPK_array_length(&bs->words)) {
+            uint64_t word = NPK_bitset_words(bs)[i];
+            int count = NPK_popcount64_(word);
+
+            if (rank < count) {
+                // Drops the lowest set bits of the word until the wanted one is the lowest
+                NPK_count_up (j, 0, rank) {
+                    word &= word - 1;
+                }
+
+                return i * 64 + NPK_ctz64_(word);
+            }
+
+            rank -= count;
+        }
+
+        return -1;
+    }
+
+    double NPK_bloom_rate_(double load) {
+        // The number of elements in a block follows a Poisson distribution with mean "load"
+        // An absent element is reported when its bit is set in each of the 8 words of its block
+        double p = exp(-load);
+        double rate = 0;
+
+        NPK_count_up (j, 0, NPK_cast(int, load * 4) + 64) {
+            rate += p * pow(1 - pow(31.0 / 32.0, j), 8);
+            p *= load / (j + 1);
+        }
+
+        return rate;
+    }
+
+    NPK_bloom NPK_bloom_new(int count, double fpr) {
+        NPK_bloom bf;
+        double lo = 0.01;
+        double hi = 256;
+        double blocks;
+
+        fpr = fpr < 1e-9 ? 1e-9 : fpr > 0.5 ? 0.5 : fpr;
+
+        // Finds the most elements per block that still keep the rate
+        NPK_count_up (i, 0, 50) {
+            double mid = (lo + hi) / 2;
+
+            if (NPK_bloom_rate_(mid) > fpr) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+
+        // The words of all the blocks are a single allocation, whose size in bytes must still fit in an int
+        int max_blocks = INT_MAX / NPK_cast(int, 8 * NPK_sizeof_type(uint32_t));
+
+        blocks = ceil((count > 0 ? count : 1) / lo);
+        bf.blocks = blocks < max_blocks ? NPK_cast(int, blocks) : max_blocks;
+        bf.words = NPK_array_sized_new(uint32_t, bf.blocks * 8);
+        bf.words.len = bf.blocks * 8;
+        NPK_bloom_clear(&bf);
+
+        return bf;
+    }
+
+    NPK_bloom NPK_bloom_from_array_new_(int size, const NPK_array *arr, double fpr) {
+        NPK_bloom bf = NPK_bloom_new(NPK_array_length(arr), fpr);
+
+        NPK_count_up (i, 0, NPK_array_length(arr)) {
+            NPK_bloom_add_(&bf, NPK_array_data(uint8_t, arr) + i * size, size);
+        }
+
+        return bf;
+    }
+
+    NPK_bloom NPK_bloom_from_map_new(const NPK_map *m, double fpr) {
+        NPK_bloom bf = NPK_bloom_new(NPK_map_length(m), fpr);
+
+        NPK_count_up (i, 0, m->keys.maxlen) {
+            void *key = NPK_array_data(void *, &m->keys)[i];
+
+            if (key != NULL) {
+                NPK_bloom_add_key(&bf, key);
+            }
+        }
+
+        return bf;
+    }
+
+    uint32_t *NPK_bloom_block_(const NPK_bloom *bf, uint64_t hash) {
+        // The high half of the hash is scaled to the number of blocks, which avoids both a division and a power of two size
+        return NPK_array_data(uint32_t, &bf->words) + ((hash >> 32) * NPK_cast(uint64_t, bf->blocks) >> 32) * 8;
+    }
+
+    void NPK_bloom_add_(NPK_bloom *bf, const void *p, int len) {
+        uint64_t hash = NPK_hash_bytes_(p, len, false);
+        uint32_t *block = NPK_bloom_block_(bf, hash);
+
+        #if defined NPK_AVX2_
+            __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(NPK_cast(int, hash)), _mm256_setr_epi32(NPK_bloom_salts_)), 27);
+            __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+
+            _mm256_storeu_si256(NPK_cast(__m256i *, block), _mm256_or_si256(_mm256_loadu_si256(NPK_cast(const __m256i *, block)), mask));
+        #else
+            static const uint32_t salts[8] = {NPK_bloom_salts_};
+
+            NPK_count_up (i, 0, 8) {
+                block[i] |= UINT32_C(1) << ((NPK_cast(uint32_t, hash) * salts[i]) >> 27);
+            }
+        #endif
+    }
+
+    bool NPK_bloom_contains_(const NPK_bloom *bf, const void *p, int len) {
+        uint64_t hash = NPK_hash_bytes_(p, len, false);
+        const uint32_t *block = NPK_bloom_block_(bf, hash);
+
+        #if defined NPK_AVX2_
+            __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(NPK_cast(int, hash)), _mm256_setr_epi32(NPK_bloom_salts_)), 27);
+            __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+
+            // Checks that no bit of the mask is missing from the block
+            return _mm256_testc_si256(_mm256_loadu_si256(NPK_cast(const __m256i *, block)), mask) != 0;
+        #else
+            static const uint32_t salts[8] = {NPK_bloom_salts_};
+            uint32_t missing = 0;
+
+            NPK_count_up (i, 0, 8) {
+                missing |= ~block[i] & (UINT32_C(1) << ((NPK_cast(uint32_t, hash) * salts[i]) >> 27));
+            }
+
+            return missing == 0;
+        #endif
+    }
+
+    void *NPK_map_filtered_get_(int size, const NPK_map *m, const NPK_bloom *bf, const void *key) {
+        return NPK_bloom_contains_key(bf, key) ? NPK_map_get_(size, m, key) : NULL;
+    }
+
+    bool NPK_map_filtered_contains_key(const NPK_map *m, const NPK_bloom *bf, const void *key) {
+        return NPK_bloom_contains_key(bf, key) && NPK_map_contains_key(m, key);
+    }
+
+    void NPK_map_filtered_add_(int size, NPK_map *m, NPK_bloom *bf, void *key, const void *val) {
+        NPK_bloom_add_key(bf, key);
+        NPK_map_add_(size, m, key, val);
+    }
+
+    #if defined NPK_DS_STATS
+        NPK_stats_counters_ NPK_stats_state_;
+
+        void NPK_stats_realloc_(NPK_stats_kind kind, bool moved, int64_t old_bytes, int64_t new_bytes) {
+            NPK_stats_add_(reallocs[kind], 1);
+            NPK_stats_add_(bytes[kind], new_bytes - old_bytes);
+
+            // A moved block carries over what fits in both sizes, which is all of it unless it shrank
+            if (moved) {
+                NPK_stats_add_(realloc_copies[kind], 1);
+                NPK_stats_add_(copied_bytes[kind], old_bytes < new_bytes ? old_bytes : new_bytes);
+            }
+        }
+
+        void NPK_stats_probe_(int64_t probes) {
+            int bucket = 0;
+
+            while (bucket < NPK_stats_probe_buckets - 1 && probes >> (bucket + 1) != 0) {
+                bucket++;
+            }
+
+            NPK_stats_add_(map_lookups, 1);
+            NPK_stats_add_(map_probes, probes);
+            NPK_stats_add_(map_probe_histogram[bucket], 1);
+        }
+
+        // Copies every counter from "src" to "dst", reading each one of "src" with "load"
+        #define stats_copy(dst, src, load)                                         \
+        NPK_count_up (i, 0, NPK_stats_kind_count) {                              \
+            (dst).allocs[i] = load((src).allocs[i]);                             \
+            (dst).bytes[i] = load((src).bytes[i]);                               \
+            (dst).reallocs[i] = load((src).reallocs[i]);                         \
+            (dst).realloc_copies[i] = load((src).realloc_copies[i]);             \
+            (dst).copied_bytes[i] = load((src).copied_bytes[i]);                 \
+        }                                                                        \
+                                                                                 \
+        NPK_count_up (i, 0, NPK_stats_probe_buckets) {                           \
+            (dst).map_probe_histogram[i] = load((src).map_probe_histogram[i]);   \
+        }                                                                        \
+                                                                                 \
+        (dst).map_lookups = load((src).map_lookups);                             \
+        (dst).map_probes = load((src).map_probes);                               \
+        (dst).map_rehashes = load((src).map_rehashes);                           \
+        (dst).map_rehashed_keys = load((src).map_rehashed_keys);
+
+        #if defined NPK_ATOMICS_
+            #define stats_load(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+        #else
+            #define stats_load(counter) (counter)
+        #endif
+
+        #define stats_value(counter) (counter)
+    #endif
+
+    NPK_stats NPK_stats_snapshot(void) {
+        NPK_stats stats;
+
+        memset(&stats, 0, sizeof stats);
+
+        #if defined NPK_DS_STATS
+            stats_copy(stats, NPK_stats_state_, stats_load)
+        #endif
+
+        return stats;
+    }
+
+    void NPK_stats_reset(void) {
+        #if defined NPK_DS_STATS
+            NPK_stats zero;
+
+            memset(&zero, 0, sizeof zero);
+            stats_copy(NPK_stats_state_, zero, stats_value)
+        #endif
+    }
+
+    void NPK_stats_dump(const NPK_stats *stats, FILE *f) {
+        const char *kinds[] = {"array", "map", "ndarray", "other"};
+
+        #if !defined NPK_DS_STATS
+            fprintf(f, "NPK_DS_STATS is not defined, so nothing was counted\n");
+        #endif
+
+        fprintf(f, "%-8s %14s %16s %14s %16s %16s\n", "kind", "allocs", "bytes", "reallocs", "realloc copies", "copied bytes");
+
+        NPK_count_up (i, 0, NPK_stats_kind_count) {
+            fprintf(f, "%-8s %14" PRId64 " %16" PRId64 " %14" PRId64 " %16" PRId64 " %16" PRId64 "\n",
+                    kinds[i], stats->allocs[i], stats->bytes[i], stats->reallocs[i], stats->realloc_copies[i], stats->copied_bytes[i]);
+        }
+
+        fprintf(f, "map lookups %" PRId64 ", mean probe length %.2f, rehashes %" PRId64 ", rehashed keys %" PRId64 "\n", stats->map_lookups,
+                stats->map_lookups > 0 ? NPK_cast(double, stats->map_probes) / stats->map_lookups : 0.0, stats->map_rehashes, stats->map_rehashed_keys);
+
+        NPK_count_up (i, 0, NPK_stats_probe_buckets) {
+            if (stats->map_probe_histogram[i] != 0) {
+                fprintf(f, "probes %6" PRId64 " to %6" PRId64 ": %" PRId64 "\n", INT64_C(1) << i, (INT64_C(1) << (i + 1)) - 1, stats->map_probe_histogram[i]);
+            }
+        }
+    }
+
+    #if defined NPK_DS_STATS
+        #undef stats_copy
+        #undef stats_load
+        #undef stats_value
+    #endif
+
+    uint64_t NPK_snapshot_checksum_(uint64_t checksum, const void *p, int len) {
+        return (checksum ^ NPK_hash_bytes_(p, len, false)) * UINT64_C(0x100000001B3);
+    }
+
+    bool NPK_snapshot_begin_(NPK_snapshot_writer_ *w, const NPK_cstring *path) {
+        NPK_snapshot_header_ header;
+
+        // The header is written again with the checksum once the body is complete
+        memset(&header, 0, sizeof header);
+        w->f = fopen(path, "wb");
+        w->buf = malloc(NPK_snapshot_chunk_);
+        w->used = 0;
+        w->bytes = 0;
+        w->checksum = UINT64_C(0xCBF29CE484222325);
+        w->ok = w->f != NULL && w->buf != NULL && fwrite(&header, sizeof header, 1, w->f) == 1;
+
+        return w->ok;
+    }
+
+    void NPK_snapshot_put_(NPK_snapshot_writer_ *w, const void *p, uint64_t len) {
+        const uint8_t *bytes = p;
+
+        while (w->ok && len > 0) {
+            int n = NPK_cast(uint64_t, NPK_snapshot_chunk_ - w->used) < len ? NPK_snapshot_chunk_ - w->used : NPK_cast(int, len);
+
+            memcpy(w->buf + w->used, bytes, n);
+            w->used += n;
+            w->bytes += n;
+            bytes += n;
+            len -= n;
+
+            if (w->used == NPK_snapshot_chunk_) {
+                w->checksum = NPK_snapshot_checksum_(w->checksum, w->buf, w->used);
+                w->ok = fwrite(w->buf, 1, w->used, w->f) == NPK_cast(size_t, w->used);
+                w->used = 0;
+            }
+        }
+    }
+
+    void NPK_snapshot_pad_(NPK_snapshot_writer_ *w) {
+        static const uint8_t zeros[NPK_snapshot_align_];
+
+        NPK_snapshot_put_(w, zeros, NPK_snapshot_padded_(w->bytes) - w->bytes);
+    }
+
+    bool NPK_snapshot_end_(NPK_snapshot_writer_ *w, NPK_snapshot_header_ *header) {
+        if (w->ok && w->used > 0) {
+            w->checksum = NPK_snapshot_checksum_(w->checksum, w->buf, w->used);
+            w->ok = fwrite(w->buf, 1, w->used, w->f) == NPK_cast(size_t, w->used);
+        }
+
+        memcpy(header->magic, NPK_snapshot_magic_, sizeof header->magic);
+        header->version = NPK_snapshot_version_;
+        header->byte_order = 0x01020304;
+        header->body_bytes = w->bytes;
+        header->checksum = 0;
+
+        // The header is folded in last, with its checksum field still zero
+        header->checksum = NPK_snapshot_checksum_(w->checksum, header, sizeof *header);
+
+        if (w->ok) {
+            w->ok = fseek(w->f, 0, SEEK_SET) == 0 && fwrite(header, sizeof *header, 1, w->f) == 1;
+        }
+
+        if (w->f != NULL) {
+            w->ok = fclose(w->f) == 0 && w->ok;
+        }
+
+        free(w->buf);
+
+        return w->ok;
+    }
+
+    void NPK_snapshot_put_level_(NPK_snapshot_writer_ *w, const NPK_array *arr, int depth, int level, uint64_t *total) {
+        NPK_for_each (NPK_array, child, arr) {
+            if (depth == level) {
+                NPK_snapshot_put_(w, total, sizeof *total);
+                *total += NPK_array_length(child);
+            } else {
+                NPK_snapshot_put_level_(w, child, depth + 1, level, total);
+            }
+        }
+    }
+
+    void NPK_snapshot_put_leaves_(NPK_snapshot_writer_ *w, int size, const NPK_array *arr, int depth, int dim) {
+        if (depth == dim - 1) {
+            NPK_snapshot_put_(w, arr->data, NPK_cast(uint64_t, NPK_array_length(arr)) * size);
+        } else {
+            NPK_for_each (NPK_array, child, arr) {
+                NPK_snapshot_put_leaves_(w, size, child, depth + 1, dim);
+            }
+        }
+    }
+
+    bool NPK_snapshot_write_(const NPK_cstring *path, NPK_snapshot_kind kind, int size, const NPK_array *arr, int dim) {
+        NPK_snapshot_writer_ w;
+        NPK_snapshot_header_ header;
+
+        memset(&header, 0, sizeof header);
+        header.kind = kind;
+        header.dim = dim;
+        header.size = size;
+        header.len = NPK_array_length(arr);
+
+        if (NPK_snapshot_begin_(&w, path)) {
+            // Every level holds the offsets of the arrays one level deeper, followed by the total that ends the last of them
+            NPK_count_up (level, 0, dim - 1) {
+                uint64_t total = 0;
+
+                NPK_snapshot_put_level_(&w, arr, 0, level, &total);
+                NPK_snapshot_put_(&w, &total, sizeof total);
+                NPK_snapshot_pad_(&w);
+            }
+
+            NPK_snapshot_put_leaves_(&w, size, arr, 0, dim);
+            NPK_snapshot_pad_(&w);
+        }
+
+        return NPK_snapshot_end_(&w, &header);
+    }
+
+    bool NPK_snapshot_write_map_(const NPK_cstring *path, int size, const NPK_map *m) {
+        NPK_snapshot_writer_ w;
+        NPK_snapshot_header_ header;
+
+        memset(&header, 0, sizeof header);
+        header.kind = NPK_snapshot_of_map;
+        header.dim = 1;
+        header.size = size;
+        header.len = m->keys.maxlen;
+        header.keys_len = NPK_map_length(m);
+
+        if (NPK_snapshot_begin_(&w, path)) {
+            if (sizeof(void *) == sizeof(uint64_t)) {
+                NPK_snapshot_put_(&w, m->keys.data, NPK_cast(uint64_t, m->keys.maxlen) * sizeof(uint64_t));
+            } else {
+                NPK_count_up (i, 0, m->keys.maxlen) {
+                    uint64_t key = NPK_cast(uintptr_t, NPK_array_data(void *, &m->keys)[i]);
+
+                    NPK_snapshot_put_(&w, &key, sizeof key);
+                }
+            }
+
+            NPK_snapshot_pad_(&w);
+            NPK_snapshot_put_(&w, m->values.data, NPK_cast(uint64_t, m->keys.maxlen) * size);
+            NPK_snapshot_pad_(&w);
+        }
+
+        return NPK_snapshot_end_(&w, &header);
+    }
+
+    bool NPK_snapshot_parse_(NPK_snapshot *snap, bool verify) {
+        const NPK_snapshot_header_ *header = snap->base;
+        const uint8_t *body = NPK_cast(const uint8_t *, snap->base) + sizeof *header;
+        uint64_t body_bytes = snap->bytes - sizeof *header;
+        uint64_t pos = 0;
+        uint64_t count;
+
+        if (memcmp(header->magic, NPK_snapshot_magic_, sizeof header->magic) != 0 || header->version != NPK_snapshot_version_ || header->byte_order != 0x01020304) {
+            return false;
+        }
+
+        if (header->body_bytes != body_bytes || header->kind > NPK_snapshot_of_map || header->dim < 1 || header->dim > 64 || header->size < 1 || header->size > INT_MAX) {
+            return false;
+        }
+
+        if (header->len < 0 || header->len > INT_MAX || header->keys_len < 0 || header->keys_len > header->len) {
+            return false;
+        }
+
+        if (header->kind == NPK_snapshot_of_strings && (header->dim != 2 || header->size != 1)) {
+            return false;
+        }
+
+        // A map needs at least one slot and always an empty one, which ends every probe
+        if (header->kind == NPK_snapshot_of_map && (header->len < 1 || header->keys_len >= header->len)) {
+            return false;
+        }
+
+        if (verify) {
+            uint64_t checksum = UINT64_C(0xCBF29CE484222325);
+            NPK_snapshot_header_ copy = *header;
+
+            for (uint64_t i = 0; i < body_bytes; i += NPK_snapshot_chunk_) {
+                checksum = NPK_snapshot_checksum_(checksum, body + i, body_bytes - i < NPK_snapshot_chunk_ ? NPK_cast(int, body_bytes - i) : NPK_snapshot_chunk_);
+            }
+
+            copy.checksum = 0;
+            checksum = NPK_snapshot_checksum_(checksum, &copy, sizeof copy);
+
+            if (checksum != header->checksum) {
+                return false;
+            }
+        }
+
+        snap->kind = header->kind;
+        snap->dim = header->dim;
+        snap->size = header->size;
+        snap->len = header->len;
+        snap->keys_len = header->keys_len;
+        snap->rows = 1;
+        count = header->len;
+
+        // Walks the sections to find where each one starts, checking that every one of them fits in the file
+        if (snap->kind == NPK_snapshot_of_map) {
+            if (sizeof(void *) != sizeof(uint64_t) || NPK_snapshot_padded_(count * 8) + NPK_snapshot_padded_(count * snap->size) > body_bytes) {
+                return false;
+            }
+
+            snap->keys = NPK_cast(const uint64_t *, body);
+            snap->elements = body + NPK_snapshot_padded_(count * 8);
+
+            // The number of keys must match the used slots, or a probe could find no empty slot
+            int64_t used = 0;
+
+            for (uint64_t i = 0; i < count; i++) {
+                used += snap->keys[i] != 0;
+            }
+
+            if (used != snap->keys_len) {
+                return false;
+            }
+
+            return true;
+        }
+
+        NPK_count_up (level, 0, snap->dim - 1) {
+            const uint64_t *offsets = NPK_cast(const uint64_t *, body + pos);
+
+            if (count >= body_bytes / 8 || pos + NPK_snapshot_padded_((count + 1) * 8) > body_bytes) {
+                return false;
+            }
+
+            // The arrays of a level follow each other, so its offsets start at zero and never decrease
+            if (offsets[0] != 0) {
+                return false;
+            }
+
+            for (uint64_t i = 0; i < count; i++) {
+                if (offsets[i + 1] < offsets[i] || offsets[i + 1] - offsets[i] > INT_MAX) {
+                    return false;
+                }
+            }
+
+            snap->offsets = level == 0 ? offsets : snap->offsets;
+            snap->leaf_offsets = offsets;
+            snap->rows = count;
+            pos += NPK_snapshot_padded_((count + 1) * 8);
+            count = offsets[count];
+        }
+
+        if (count > (body_bytes - pos) / snap->size) {
+            return false;
+        }
+
+        snap->elements = body + pos;
+
+        // Every string is viewed with its nul byte, which must be there
+        if (snap->kind == NPK_snapshot_of_strings) {
+            for (int64_t i = 0; i < snap->rows; i++) {
+                if (snap->leaf_offsets[i + 1] == snap->leaf_offsets[i] || snap->elements[snap->leaf_offsets[i + 1] - 1] != '\0') {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool NPK_snapshot_open(const NPK_cstring *path, NPK_snapshot *snap, bool verify) {
+        memset(snap, 0, sizeof *snap);
+
+        #if defined NPK_POSIX_
+            struct stat st;
+            int fd = open(path, O_RDONLY);
+
+            if (fd < 0) {
+                return false;
+            }
+
+            if (fstat(fd, &st) != 0 || st.st_size < NPK_cast(off_t, sizeof(NPK_snapshot_header_))) {
+                close(fd);
+
+                return false;
+            }
+
+            // The pages are only read from the disk when they are first touched
+            snap->base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            snap->bytes = st.st_size;
+            close(fd);
+
+            if (snap->base == MAP_FAILED) {
+                snap->base = NULL;
+
+                return false;
+            }
+        #else
+            FILE *f = fopen(path, "rb");
+            long bytes;
+
+            if (f == NULL) {
+                return false;
+            }
+
+            if (fseek(f, 0, SEEK_END) != 0 || (bytes = ftell(f)) < NPK_cast(long, sizeof(NPK_snapshot_header_)) || fseek(f, 0, SEEK_SET) != 0) {
+                fclose(f);
+
+                return false;
+            }
+
+            snap->base = malloc(bytes);
+            snap->bytes = bytes;
+
+            if (snap->base == NULL || fread(snap->base, 1, bytes, f) != NPK_cast(size_t, bytes)) {
+                fclose(f);
+                NPK_snapshot_close(snap);
+
+                return false;
+            }
+
+            fclose(f);
+        #endif
+
+        if (NPK_snapshot_parse_(snap, verify) == false) {
+            NPK_snapshot_close(snap);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    NPK_array NPK_snapshot_row(const NPK_snapshot *snap, int64_t idx) {
+        NPK_array row;
+        uint64_t begin = snap->dim > 1 ? snap->leaf_offsets[idx] : 0;
+        uint64_t end = snap->dim > 1 ? snap->leaf_offsets[idx + 1] : NPK_cast(uint64_t, snap->len);
+
+        row.len = end - begin;
+        row.maxlen = row.len;
+        row.data = NPK_cast(void *, snap->elements + begin * snap->size);
+
+        return row;
+    }
+
+    const uint64_t *NPK_snapshot_offsets(const NPK_snapshot *snap, int level) {
+        const uint64_t *offsets = snap->offsets;
+        uint64_t count = snap->len;
+
+        NPK_count_up (i, 0, level) {
+            uint64_t next = offsets[count];
+
+            offsets += NPK_snapshot_padded_((count + 1) * 8) / 8;
+            count = next;
+        }
+
+        return offsets;
+    }
+
+    NPK_map NPK_snapshot_map(const NPK_snapshot *snap) {
+        NPK_map m;
+
+        m.keys.len = snap->keys_len;
+        m.keys.maxlen = snap->len;
+        m.keys.data = NPK_cast(void *, snap->keys);
+        m.values.len = snap->keys_len;
+        m.values.maxlen = snap->len;
+        m.values.data = NPK_cast(void *, snap->elements);
+
+        return m;
+    }
+
+    NPK_array NPK_snapshot_copy_level_(const NPK_snapshot *snap, const uint64_t **levels, int level, uint64_t begin, uint64_t end) {
+        int len = end - begin;
+        NPK_array arr;
+
+        if (level == snap->dim - 1) {
+            arr = NPK_array_sized_new_(snap->size, len > 0 ? len : 1);
+            memcpy(arr.data, snap->elements + begin * snap->size, NPK_cast(size_t, len) * snap->size);
+        } else {
+            arr = NPK_array_sized_new(NPK_array, len > 0 ? len : 1);
+
+            NPK_count_up (i, 0, len) {
+                NPK_array_data(NPK_array, &arr)[i] = NPK_snapshot_copy_level_(snap, levels, level + 1, levels[level][begin + i], levels[level][begin + i + 1]);
+            }
+        }
+
+        arr.len = len;
+
+        return arr;
+    }
+
+    NPK_array NPK_snapshot_copy_new(const NPK_snapshot *snap) {
+        const uint64_t **levels = alloca(snap->dim * sizeof *levels);
+
+        NPK_count_up (level, 0, snap->dim - 1) {
+            levels[level] = NPK_snapshot_offsets(snap, level);
+        }
+
+        return NPK_snapshot_copy_level_(snap, levels, 0, 0, snap->len);
+    }
+
+    void NPK_snapshot_close(NPK_snapshot *snap) {
+        if (snap->base != NULL) {
+            #if defined NPK_POSIX_
+                munmap(snap->base, snap->bytes);
+            #else
+                free(snap->base);
+            #endif
+        }
+
+        snap->base = NULL;
+    }
+
+    NPK_btree NPK_btree_new_(int key_size, int size, int (*type_compare)(const void *p1, const void *p2)) {
+        NPK_btree bt;
+        int cap = NPK_btree_key_bytes_ / key_size > 4 ? NPK_btree_key_bytes_ / key_size : 4;
+
+        bt.key_size = key_size;
+        bt.size = size;
+        bt.len = 0;
+        bt.height = 0;
+        bt.root = -1;
+        bt.first = -1;
+        bt.leaf_cap = cap;
+        bt.inner_cap = cap;
+
+        // The values and the children start 16 byte aligned, and every record is a whole number of cache lines
+        bt.values_offset = NPK_btree_header_ + (cap * key_size + 15) / 16 * 16;
+        bt.children_offset = bt.values_offset;
+        bt.leaf_bytes = (bt.values_offset + cap * size + 63) / 64 * 64;
+        bt.inner_bytes = (bt.children_offset + (cap + 1) * NPK_cast(int, NPK_sizeof_type(int)) + 63) / 64 * 64;
+        bt.leaves = NPK_array_sized_new_(bt.leaf_bytes, 1);
+        bt.inners = NPK_array_sized_new_(bt.inner_bytes, 1);
+        bt.free_leaves = NPK_array_new(int);
+        bt.free_inners = NPK_array_new(int);
+        bt.type_compare = type_compare;
+
+        return bt;
+    }
+
+    NPK_btree NPK_btree_from_arrays_new_(int key_size, int size, const NPK_array *keys, const NPK_array *values, int (*type_compare)(const void *p1, const void *p2)) {
+        NPK_btree bt = NPK_btree_new_(key_size, size, type_compare);
+        int len = NPK_array_length(keys);
+        int unique = 0;
+
+        #define key_at(i) (NPK_array_data(uint8_t, keys) + NPK_cast(size_t, i) * key_size)
+
+        NPK_count_up (i, 0, len) {
+            unique += i + 1 == len || type_compare(key_at(i), key_at(i + 1)) != 0;
+        }
+
+        if (unique == 0) {
+            return bt;
+        }
+
+        // The keys are spread evenly over the fewest leaves that hold them, so every node is at least half full
+        int count = (unique + bt.leaf_cap - 1) / bt.leaf_cap;
+        NPK_array level = NPK_array_sized_new(int, count);
+        NPK_array firsts = NPK_array_sized_new_(key_size, count);
+        int src = 0;
+
+        NPK_array_reserve_(bt.leaf_bytes, &bt.leaves, count);
+
+        NPK_count_up (i, 0, count) {
+            int node = NPK_btree_node_new_(&bt, true);
+            uint8_t *leaf = NPK_btree_leaf_(&bt, node);
+            int filled = NPK_cast(int, NPK_cast(int64_t, unique) * (i + 1) / count - NPK_cast(int64_t, unique) * i / count);
+
+            NPK_count_up (j, 0, filled) {
+                while (src + 1 < len && type_compare(key_at(src), key_at(src + 1)) == 0) {
+                    src++;
+                }
+
+                memcpy(NPK_btree_keys_(leaf) + j * key_size, key_at(src), key_size);
+
+                if (values != NULL) {
+                    memcpy(NPK_btree_values_(&bt, leaf) + j * size, NPK_array_data(uint8_t, values) + NPK_cast(size_t, src) * size, size);
+                } else {
+                    memset(NPK_btree_values_(&bt, leaf) + j * size, 0, size);
+                }
+
+                src++;
+            }
+
+            NPK_btree_count_(leaf) = filled;
+            NPK_btree_next_(leaf) = i + 1 < count ? node + 1 : -1;
+            NPK_array_add(int, &level, node);
+            NPK_array_add_(key_size, &firsts, NPK_btree_keys_(leaf));
+        }
+
+        #undef key_at
+
+        bt.len = unique;
+        bt.height = 1;
+        bt.first = NPK_array_data(int, &level)[0];
+
+        // Every level above is built the same way from the nodes below it and the first key of each of them
+        while (NPK_array_length(&level) > 1) {
+            int below = NPK_array_length(&level);
+            int next_count = (below + bt.inner_cap) / (bt.inner_cap + 1);
+            NPK_array next_level = NPK_array_sized_new(int, next_count);
+            NPK_array next_firsts = NPK_array_sized_new_(key_size, next_count);
+            int child = 0;
+
+            NPK_count_up (i, 0, next_count) {
+                int node = NPK_btree_node_new_(&bt, false);
+                uint8_t *inner = NPK_btree_inner_(&bt, node);
+                int children = NPK_cast(int, NPK_cast(int64_t, below) * (i + 1) / next_count - NPK_cast(int64_t, below) * i / next_count);
+
+                NPK_count_up (j, 0, children) {
+                    NPK_btree_children_(&bt, inner)[j] = NPK_array_data(int, &level)[child + j];
+
+                    if (j > 0) {
+                        memcpy(NPK_btree_keys_(inner) + (j - 1) * key_size, NPK_array_data(uint8_t, &firsts) + (child + j) * key_size, key_size);
+                    }
+                }
+
+                NPK_btree_count_(inner) = children - 1;
+                NPK_array_add(int, &next_level, node);
+                NPK_array_add_(key_size, &next_firsts, NPK_array_data(uint8_t, &firsts) + child * key_size);
+                child += children;
+            }
+
+            NPK_array_del(&level);
+            NPK_array_del(&firsts);
+            level = next_level;
+            firsts = next_firsts;
+            bt.height++;
+        }
+
+        bt.root = NPK_array_data(int, &level)[0];
+        NPK_array_del(&level);
+        NPK_array_del(&firsts);
+
+        return bt;
+    }
+
+    // Reuses a freed node before appending a new record, which can move every node of its kind
+    int NPK_btree_node_new_(NPK_btree *bt, bool leaf) {
+        NPK_array *nodes = leaf ? &bt->leaves : &bt->inners;
+        NPK_array *free_nodes = leaf ? &bt->free_leaves : &bt->free_inners;
+        int node;
+
+        if (NPK_array_is_empty(free_nodes)) {
+            NPK_array_reserve_(leaf ? bt->leaf_bytes : bt->inner_bytes, nodes, NPK_array_length(nodes) + 1);
+            node = nodes->len++;
+        } else {
+            node = NPK_array_data(int, free_nodes)[--free_nodes->len];
+        }
+
+        uint8_t *cur = leaf ? NPK_btree_leaf_(bt, node) : NPK_btree_inner_(bt, node);
+
+        NPK_btree_count_(cur) = 0;
+        NPK_btree_next_(cur) = -1;
+
+        return node;
+    }
+
+    // Returns the number of keys of the node that come before "key", or that don't come after it for "upper"
+    int NPK_btree_search_(const NPK_btree *bt, const uint8_t *node, const void *key, bool upper) {
+        const uint8_t *keys = NPK_btree_keys_(node);
+        int lo = 0;
+        int hi = NPK_btree_count_(node);
+
+        // The lines of the keys are requested together, so the probes of the binary search don't wait for them one by one
+        for (int i = 64; i < NPK_btree_header_ + hi * bt->key_size; i += 64) {
+            NPK_prefetch_(node + i);
+        }
+
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            int order = bt->type_compare(keys + mid * bt->key_size, key);
+
+            if (order < 0 || (upper && order == 0)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    void *NPK_btree_get_(const NPK_btree *bt, const void *key) {
+        if (bt->root == -1) {
+            return NULL;
+        }
+
+        int node = bt->root;
+
+        NPK_count_up (level, 1, bt->height) {
+            uint8_t *inner = NPK_btree_inner_(bt, node);
+
+            node = NPK_btree_children_(bt, inner)[NPK_btree_search_(bt, inner, key, true)];
+        }
+
+        uint8_t *leaf = NPK_btree_leaf_(bt, node);
+        int pos = NPK_btree_search_(bt, leaf, key, false);
+
+        if (pos < NPK_btree_count_(leaf) && bt->type_compare(NPK_btree_keys_(leaf) + pos * bt->key_size, key) == 0) {
+            return NPK_btree_values_(bt, leaf) + pos * bt->size;
+        }
+
+        return NULL;
+    }
+
+    void NPK_btree_add_(NPK_btree *bt, const void *key, const void *val) {
+        int path[NPK_btree_max_height_];
+        int slots[NPK_btree_max_height_];
+        bool append = true;
+
+        if (bt->root == -1) {
+            bt->root = NPK_btree_node_new_(bt, true);
+            bt->first = bt->root;
+            bt->height = 1;
+        }
+
+        int node = bt->root;
+
+        NPK_count_up (level, 0, bt->height - 1) {
+            uint8_t *inner = NPK_btree_inner_(bt, node);
+            int slot = NPK_btree_search_(bt, inner, key, true);
+
+            append = append && slot == NPK_btree_count_(inner);
+            path[level] = node;
+            slots[level] = slot;
+            node = NPK_btree_children_(bt, inner)[slot];
+        }
+
+        uint8_t *leaf = NPK_btree_leaf_(bt, node);
+        int count = NPK_btree_count_(leaf);
+        int pos = NPK_btree_search_(bt, leaf, key, false);
+
+        if (pos < count && bt->type_compare(NPK_btree_keys_(leaf) + pos * bt->key_size, key) == 0) {
+            memcpy(NPK_btree_values_(bt, leaf) + pos * bt->size, val, bt->size);
+
+            return;
+        }
+
+        bt->len++;
+
+        if (count == bt->leaf_cap) {
+            NPK_btree_split_(bt, path, slots, node, pos, key, val, append && pos == count);
+
+            return;
+        }
+
+        uint8_t *keys = NPK_btree_keys_(leaf) + pos * bt->key_size;
+        uint8_t *values = NPK_btree_values_(bt, leaf) + pos * bt->size;
+
+        memmove(keys + bt->key_size, keys, (count - pos) * bt->key_size);
+        memmove(values + bt->size, values, (count - pos) * bt->size);
+        memcpy(keys, key, bt->key_size);
+        memcpy(values, val, bt->size);
+        NPK_btree_count_(leaf)++;
+    }
+
+    // Splits the full leaf for the new key and then every full ancestor that its separator reaches
+    // Keys that go past the end of the last leaf leave the full nodes as they are, so appending in order fills every node
+    void NPK_btree_split_(NPK_btree *bt, const int *path, const int *slots, int leaf, int pos, const void *key, const void *val, bool append) {
+        int key_size = bt->key_size;
+        int size = bt->size;
+        int cap = bt->leaf_cap;
+        int right = NPK_btree_node_new_(bt, true);
+        uint8_t *l = NPK_btree_leaf_(bt, leaf);
+        uint8_t *r = NPK_btree_leaf_(bt, right);
+        int mid = append ? cap : (cap + 1) / 2;
+        uint8_t *sep = alloca(key_size);
+
+        memcpy(NPK_btree_keys_(r), NPK_btree_keys_(l) + mid * key_size, (cap - mid) * key_size);
+        memcpy(NPK_btree_values_(bt, r), NPK_btree_values_(bt, l) + mid * size, (cap - mid) * size);
+        NPK_btree_count_(l) = mid;
+        NPK_btree_count_(r) = cap - mid;
+        NPK_btree_next_(r) = NPK_btree_next_(l);
+        NPK_btree_next_(l) = right;
+
+        // The new key goes to whichever half it belongs to, which has room for it now
+        uint8_t *half = pos < mid ? l : r;
+        int at = pos < mid ? pos : pos - mid;
+        int count = NPK_btree_count_(half);
+
+        memmove(NPK_btree_keys_(half) + (at + 1) * key_size, NPK_btree_keys_(half) + at * key_size, (count - at) * key_size);
+        memmove(NPK_btree_values_(bt, half) + (at + 1) * size, NPK_btree_values_(bt, half) + at * size, (count - at) * size);
+        memcpy(NPK_btree_keys_(half) + at * key_size, key, key_size);
+        memcpy(NPK_btree_values_(bt, half) + at * size, val, size);
+        NPK_btree_count_(half)++;
+        memcpy(sep, NPK_btree_keys_(r), key_size);
+
+        // The separator and the new node go up one level at a time, a full inner node is split around its middle key
+        cap = bt->inner_cap;
+
+        uint8_t *keys = alloca((cap + 1) * key_size);
+        int *children = alloca((cap + 2) * NPK_sizeof_type(int));
+
+        NPK_count_down (level, bt->height - 1, 0) {
+            uint8_t *inner = NPK_btree_inner_(bt, path[level]);
+            int slot = slots[level];
+            int len = NPK_btree_count_(inner);
+
+            if (len < cap) {
+                memmove(NPK_btree_keys_(inner) + (slot + 1) * key_size, NPK_btree_keys_(inner) + slot * key_size, (len - slot) * key_size);
+                memmove(NPK_btree_children_(bt, inner) + slot + 2, NPK_btree_children_(bt, inner) + slot + 1, (len - slot) * NPK_sizeof_type(int));
+                memcpy(NPK_btree_keys_(inner) + slot * key_size, sep, key_size);
+                NPK_btree_children_(bt, inner)[slot + 1] = right;
+                NPK_btree_count_(inner)++;
+
+                return;
+            }
+
+            memcpy(keys, NPK_btree_keys_(inner), slot * key_size);
+            memcpy(keys + slot * key_size, sep, key_size);
+            memcpy(keys + (slot + 1) * key_size, NPK_btree_keys_(inner) + slot * key_size, (cap - slot) * key_size);
+            memcpy(children, NPK_btree_children_(bt, inner), (slot + 1) * NPK_sizeof_type(int));
+            children[slot + 1] = right;
+            memcpy(children + slot + 2, NPK_btree_children_(bt, inner) + slot + 1, (cap - slot) * NPK_sizeof_type(int));
+
+            // The key at "mid" moves up, the left node keeps the keys before it and the new right node those after it
+            mid = append ? cap - 1 : (cap + 1) / 2;
+            right = NPK_btree_node_new_(bt, false);
+            inner = NPK_btree_inner_(bt, path[level]);
+            r = NPK_btree_inner_(bt, right);
+
+            memcpy(NPK_btree_keys_(inner), keys, mid * key_size);
+            memcpy(NPK_btree_children_(bt, inner), children, (mid + 1) * NPK_sizeof_type(int));
+            NPK_btree_count_(inner) = mid;
+            memcpy(NPK_btree_keys_(r), keys + (mid + 1) * key_size, (cap - mid) * key_size);
+            memcpy(NPK_btree_children_(bt, r), children + mid + 1, (cap - mid + 1) * NPK_sizeof_type(int));
+            NPK_btree_count_(r) = cap - mid;
+            memcpy(sep, keys + mid * key_size, key_size);
+        }
+
+        // The root itself was split, so a new root with the two halves makes the tree one level taller
+        int root = NPK_btree_node_new_(bt, false);
+        uint8_t *inner = NPK_btree_inner_(bt, root);
+
+        memcpy(NPK_btree_keys_(inner), sep, key_size);
+        NPK_btree_children_(bt, inner)[0] = bt->root;
+        NPK_btree_children_(bt, inner)[1] = right;
+        NPK_btree_count_(inner) = 1;
+        bt->root = root;
+        bt->height++;
+    }
+
+    bool NPK_btree_remove_(NPK_btree *bt, const void *key) {
+        int path[NPK_btree_max_height_];
+        int slots[NPK_btree_max_height_];
+
+        if (bt->root == -1) {
+            return false;
+        }
+
+        int node = bt->root;
+
+        NPK_count_up (level, 0, bt->height - 1) {
+            uint8_t *inner = NPK_btree_inner_(bt, node);
+
+            path[level] = node;
+            slots[level] = NPK_btree_search_(bt, inner, key, true);
+            node = NPK_btree_children_(bt, inner)[slots[level]];
+        }
+
+        uint8_t *leaf = NPK_btree_leaf_(bt, node);
+        int count = NPK_btree_count_(leaf);
+        int pos = NPK_btree_search_(bt, leaf, key, false);
+
+        if (pos == count || bt->type_compare(NPK_btree_keys_(leaf) + pos * bt->key_size, key) != 0) {
+            return false;
+        }
+
+        uint8_t *keys = NPK_btree_keys_(leaf) + pos * bt->key_size;
+        uint8_t *values = NPK_btree_values_(bt, leaf) + pos * bt->size;
+
+        memmove(keys, keys + bt->key_size, (count - pos - 1) * bt->key_size);
+        memmove(values, values + bt->size, (count - pos - 1) * bt->size);
+        NPK_btree_count_(leaf)--;
+        bt->len--;
+
+        // A node that fell below half full borrows from or merges with a sibling, which can leave its parent below half full
+        // Separators are left as they are, since a removed key still separates the keys on its two sides
+        bool is_leaf = true;
+
+        NPK_count_down (level, bt->height - 1, 0) {
+            uint8_t *cur = is_leaf ? NPK_btree_leaf_(bt, node) : NPK_btree_inner_(bt, node);
+
+            if (NPK_btree_count_(cur) >= (is_leaf ? bt->leaf_cap : bt->inner_cap) / 2) {
+                break;
+            }
+
+            NPK_btree_rebalance_(bt, path[level], slots[level], is_leaf);
+            node = path[level];
+            is_leaf = false;
+        }
+
+        // An empty root leaf empties the tree, and a root with a single child hands the root over to it
+        if (bt->height == 1 && NPK_btree_count_(NPK_btree_leaf_(bt, bt->root)) == 0) {
+            NPK_array_add(int, &bt->free_leaves, bt->root);
+            bt->root = -1;
+            bt->first = -1;
+            bt->height = 0;
+        } else if (bt->height > 1 && NPK_btree_count_(NPK_btree_inner_(bt, bt->root)) == 0) {
+            NPK_array_add(int, &bt->free_inners, bt->root);
+            bt->root = NPK_btree_children_(bt, NPK_btree_inner_(bt, bt->root))[0];
+            bt->height--;
+        }
+
+        return true;
+    }
+
+    // Fixes the child at "slot" of "parent" after it fell below half full, together with its left sibling if it has one
+    void NPK_btree_rebalance_(NPK_btree *bt, int parent, int slot, bool leaf) {
+        int key_size = bt->key_size;
+        int size = bt->size;
+        uint8_t *p = NPK_btree_inner_(bt, parent);
+        int sep = slot > 0 ? slot - 1 : 0;
+        int *siblings = NPK_btree_children_(bt, p) + sep;
+        uint8_t *l = leaf ? NPK_btree_leaf_(bt, siblings[0]) : NPK_btree_inner_(bt, siblings[0]);
+        uint8_t *r = leaf ? NPK_btree_leaf_(bt, siblings[1]) : NPK_btree_inner_(bt, siblings[1]);
+        int l_count = NPK_btree_count_(l);
+        int r_count = NPK_btree_count_(r);
+        int half = (leaf ? bt->leaf_cap : bt->inner_cap) / 2;
+        uint8_t *sep_key = NPK_btree_keys_(p) + sep * key_size;
+
+        // The sibling can spare a key, so one key moves across and the separator between them changes
+        if (slot == sep + 1 && l_count > half) {
+            if (leaf) {
+                memmove(NPK_btree_keys_(r) + key_size, NPK_btree_keys_(r), r_count * key_size);
+                memmove(NPK_btree_values_(bt, r) + size, NPK_btree_values_(bt, r), r_count * size);
+                memcpy(NPK_btree_keys_(r), NPK_btree_keys_(l) + (l_count - 1) * key_size, key_size);
+                memcpy(NPK_btree_values_(bt, r), NPK_btree_values_(bt, l) + (l_count - 1) * size, size);
+                memcpy(sep_key, NPK_btree_keys_(r), key_size);
+            } else {
+                memmove(NPK_btree_keys_(r) + key_size, NPK_btree_keys_(r), r_count * key_size);
+                memmove(NPK_btree_children_(bt, r) + 1, NPK_btree_children_(bt, r), (r_count + 1) * NPK_sizeof_type(int));
+                memcpy(NPK_btree_keys_(r), sep_key, key_size);
+                NPK_btree_children_(bt, r)[0] = NPK_btree_children_(bt, l)[l_count];
+                memcpy(sep_key, NPK_btree_keys_(l) + (l_count - 1) * key_size, key_size);
+            }
+
+            NPK_btree_count_(l)--;
+            NPK_btree_count_(r)++;
+
+            return;
+        }
+
+        if (slot == sep && r_count > half) {
+            if (leaf) {
+                memcpy(NPK_btree_keys_(l) + l_count * key_size, NPK_btree_keys_(r), key_size);
+                memcpy(NPK_btree_values_(bt, l) + l_count * size, NPK_btree_values_(bt, r), size);
+                memmove(NPK_btree_keys_(r), NPK_btree_keys_(r) + key_size, (r_count - 1) * key_size);
+                memmove(NPK_btree_values_(bt, r), NPK_btree_values_(bt, r) + size, (r_count - 1) * size);
+                memcpy(sep_key, NPK_btree_keys_(r), key_size);
+            } else {
+                memcpy(NPK_btree_keys_(l) + l_count * key_size, sep_key, key_size);
+                NPK_btree_children_(bt, l)[l_count + 1] = NPK_btree_children_(bt, r)[0];
+                memcpy(sep_key, NPK_btree_keys_(r), key_size);
+                memmove(NPK_btree_keys_(r), NPK_btree_keys_(r) + key_size, (r_count - 1) * key_size);
+                memmove(NPK_btree_children_(bt, r), NPK_btree_children_(bt, r) + 1, r_count * NPK_sizeof_type(int));
+            }
+
+            NPK_btree_count_(l)++;
+            NPK_btree_count_(r)--;
+
+            return;
+        }
+
+        // Otherwise the two fit in one node, so the right one is merged into the left one and leaves its parent
+        if (leaf) {
+            memcpy(NPK_btree_keys_(l) + l_count * key_size, NPK_btree_keys_(r), r_count * key_size);
+            memcpy(NPK_btree_values_(bt, l) + l_count * size, NPK_btree_values_(bt, r), r_count * size);
+            NPK_btree_count_(l) = l_count + r_count;
+            NPK_btree_next_(l) = NPK_btree_next_(r);
+            NPK_array_add(int, &bt->free_leaves, siblings[1]);
+        } else {
+            memcpy(NPK_btree_keys_(l) + l_count * key_size, sep_key, key_size);
+            memcpy(NPK_btree_keys_(l) + (l_count + 1) * key_size, NPK_btree_keys_(r), r_count * key_size);
+            memcpy(NPK_btree_children_(bt, l) + l_count + 1, NPK_btree_children_(bt, r), (r_count + 1) * NPK_sizeof_type(int));
+            NPK_btree_count_(l) = l_count + r_count + 1;
+            NPK_array_add(int, &bt->free_inners, siblings[1]);
+        }
+
+        int count = NPK_btree_count_(p);
+
+        memmove(sep_key, sep_key + key_size, (count - sep - 1) * key_size);
+        memmove(siblings + 1, siblings + 2, (count - sep - 1) * NPK_sizeof_type(int));
+        NPK_btree_count_(p)--;
+    }
+
+    NPK_btree_cursor NPK_btree_first(const NPK_btree *bt) {
+        return (NPK_btree_cursor) {bt, bt->first, 0};
+    }
+
+    NPK_btree_cursor NPK_btree_seek_(const NPK_btree *bt, const void *key, bool upper) {
+        NPK_btree_cursor cur = {bt, -1, 0};
+
+        if (bt->root == -1) {
+            return cur;
+        }
+
+        int node = bt->root;
+
+        NPK_count_up (level, 1, bt->height) {
+            uint8_t *inner = NPK_btree_inner_(bt, node);
+
+            node = NPK_btree_children_(bt, inner)[NPK_btree_search_(bt, inner, key, true)];
+        }
+
+        uint8_t *leaf = NPK_btree_leaf_(bt, node);
+
+        cur.leaf = node;
+        cur.pos = NPK_btree_search_(bt, leaf, key, upper);
+
+        // Past the last key of its leaf the cursor moves to the first key of the next one, leaves are never empty
+        if (cur.pos == NPK_btree_count_(leaf)) {
+            cur.leaf = NPK_btree_next_(leaf);
+            cur.pos = 0;
+        }
+
+        return cur;
+    }
+
+    void NPK_btree_cursor_next(NPK_btree_cursor *cur) {
+        uint8_t *leaf = NPK_btree_leaf_(cur->bt, cur->leaf);
+
+        if (++cur->pos == NPK_btree_count_(leaf)) {
+            cur->leaf = NPK_btree_next_(leaf);
+            cur->pos = 0;
+        }
+    }
+
+    bool NPK_btree_cursor_before_(const NPK_btree_cursor *cur, const void *key) {
+        return NPK_btree_cursor_valid(cur) && cur->bt->type_compare(NPK_btree_cursor_key(uint8_t, cur), key) < 0;
+    }
+
+    void NPK_btree_del(NPK_btree *bt) {
+        NPK_array_del(&bt->leaves);
+        NPK_array_del(&bt->inners);
+        NPK_array_del(&bt->free_leaves);
+        NPK_array_del(&bt->free_inners);
+    }
+
+    // Every stage starts out with no state, so NPK_iter_del can tell which ones hold a buffer or a file
+    NPK_iter NPK_iter_stage_(int size, bool (*next)(NPK_iter *it, void *out), NPK_iter *src) {
+        NPK_iter it;
+
+        memset(&it, 0, NPK_sizeof_type(NPK_iter));
+        it.size = size;
+        it.next = next;
+        it.src = src;
+
+        return it;
+    }
+
+    NPK_iter NPK_iter_array_(int size, const NPK_array *arr) {
+        NPK_iter it = NPK_iter_stage_(size, NPK_iter_array_next_, NULL);
+
+        it.arr = arr;
+
+        return it;
+    }
+
+    bool NPK_iter_array_next_(NPK_iter *it, void *out) {
+        if (it->count == NPK_array_length(it->arr)) {
+            return false;
+        }
+
+        memcpy(out, NPK_array_data(uint8_t, it->arr) + it->count++ * it->size, it->size);
+
+        return true;
+    }
+
+    NPK_iter NPK_iter_split_new(const NPK_string *str, const NPK_cstring *delim) {
+        NPK_iter it = NPK_iter_stage_(NPK_sizeof_type(NPK_string), NPK_iter_split_next_, NULL);
+
+        it.cursor = str->data;
+        it.delim = delim;
+        it.buf = NPK_string_new("");
+
+        return it;
+    }
+
+    // "cursor" is the start of the next part, and NULL once the part after the last delimiter was given
+    bool NPK_iter_split_next_(NPK_iter *it, void *out) {
+        if (it->cursor == NULL) {
+            return false;
+        }
+
+        const NPK_cstring *end = it->delim[0] != '\0' ? strstr(it->cursor, it->delim) : NULL;
+        int len = end != NULL ? NPK_cast(int, end - it->cursor) : NPK_cast(int, strlen(it->cursor));
+
+        it->buf.len = 1;
+        NPK_string_append_n_(&it->buf, it->cursor, len);
+        it->cursor = end != NULL ? end + strlen(it->delim) : NULL;
+        memcpy(out, &it->buf, NPK_sizeof_type(NPK_string));
+
+        return true;
+    }
+
+    NPK_iter NPK_iter_lines_new(const NPK_cstring *path) {
+        NPK_iter it = NPK_iter_stage_(NPK_sizeof_type(NPK_string), NPK_iter_lines_next_, NULL);
+
+        it.f = fopen(path, "r");
+        it.buf = NPK_string_new("");
+
+        return it;
+    }
+
+    // The file is read a block at a time and closed after its last line, which is empty when the file ends with a newline
+    bool NPK_iter_lines_next_(NPK_iter *it, void *out) {
+        char block[4096];
+
+        if (it->f == NULL) {
+            return false;
+        }
+
+        it->buf.len = 1;
+        NPK_string_data(&it->buf)[0] = '\0';
+
+        while (true) {
+            if (fgets(block, NPK_cast(int, sizeof block), it->f) == NULL) {
+                fclose(it->f);
+                it->f = NULL;
+                break;
+            }
+
+            int len = strlen(block);
+
+            if (len > 0 && block[len - 1] == '\n') {
+                NPK_string_append_n_(&it->buf, block, len - 1);
+                break;
+            }
+
+            NPK_string_append_n_(&it->buf, block, len);
+        }
+
+        memcpy(out, &it->buf, NPK_sizeof_type(NPK_string));
+
+        return true;
+    }
+
+    NPK_iter NPK_iter_code_points(const NPK_string *str) {
+        NPK_iter it = NPK_iter_stage_(NPK_sizeof_type(uint32_t), NPK_iter_code_points_next_, NULL);
+
+        it.arr = str;
+
+        return it;
+    }
+
+    // "count" is the index of the byte where the next code point starts
+    bool NPK_iter_code_points_next_(NPK_iter *it, void *out) {
+        uint32_t cp;
+
+        if (it->count >= NPK_string_length(it->arr)) {
+            return false;
+        }
+
+        it->count = NPK_string_utf8_next(it->arr, it->count, &cp);
+        memcpy(out, &cp, NPK_sizeof_type(uint32_t));
+
+        return true;
+    }
+
+    NPK_iter NPK_iter_filter(NPK_iter *src, bool (*keep)(const void *elem, void *ctx), void *ctx) {
+        NPK_iter it = NPK_iter_stage_(src->size, NPK_iter_filter_next_, src);
+
+        it.fn = NPK_cast(void (*)(void), keep);
+        it.ctx = ctx;
+
+        return it;
+    }
+
+    bool NPK_iter_filter_next_(NPK_iter *it, void *out) {
+        bool (*keep)(const void *elem, void *ctx) = NPK_cast(bool (*)(const void *, void *), it->fn);
+
+        while (it->src->next(it->src, out)) {
+            if (keep(out, it->ctx)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    NPK_iter NPK_iter_map_(int size, NPK_iter *src, void (*fn)(const void *in, void *out, void *ctx), void *ctx) {
+        NPK_iter it = NPK_iter_stage_(size, NPK_iter_map_next_, src);
+
+        it.fn = NPK_cast(void (*)(void), fn);
+        it.ctx = ctx;
+
+        return it;
+    }
+
+    bool NPK_iter_map_next_(NPK_iter *it, void *out) {
+        void (*fn)(const void *in, void *out, void *ctx) = NPK_cast(void (*)(const void *, void *, void *), it->fn);
+        void *in = alloca(it->src->size);
+
+        if (it->src->next(it->src, in) == false) {
+            return false;
+        }
+
+        fn(in, out, it->ctx);
+
+        return true;
+    }
+
+    NPK_iter NPK_iter_take(NPK_iter *src, int64_t n) {
+        NPK_iter it = NPK_iter_stage_(src->size, NPK_iter_take_next_, src);
+
+        it.count = n;
+
+        return it;
+    }
+
+    // Nothing is pulled from the source after the last element, so taking from an endless source ends too
+    bool NPK_iter_take_next_(NPK_iter *it, void *out) {
+        if (it->count <= 0) {
+            return false;
+        }
+
+        it->count--;
+
+        return it->src->next(it->src, out);
+    }
+
+    NPK_iter NPK_iter_skip(NPK_iter *src, int64_t n) {
+        NPK_iter it = NPK_iter_stage_(src->size, NPK_iter_skip_next_, src);
+
+        it.count = n;
+
+        return it;
+    }
+
+    // The skipped elements are pulled into "out" itself, which the first element that is kept then overwrites
+    bool NPK_iter_skip_next_(NPK_iter *it, void *out) {
+        for (; it->count > 0; it->count--) {
+            if (it->src->next(it->src, out) == false) {
+                it->count = 0;
+
+                return false;
+            }
+        }
+
+        return it->src->next(it->src, out);
+    }
+
+    NPK_iter NPK_iter_chunk_new(NPK_iter *src, int n) {
+        NPK_iter it = NPK_iter_stage_(NPK_sizeof_type(NPK_array), NPK_iter_chunk_next_, src);
+
+        it.count = n > 0 ? n : 1;
+        it.buf = NPK_array_sized_new_(src->size, it.count);
+
+        return it;
+    }
+
+    bool NPK_iter_chunk_next_(NPK_iter *it, void *out) {
+        it->buf.len = 0;
+
+        while (it->buf.len < it->count && it->src->next(it->src, NPK_array_data(uint8_t, &it->buf) + it->buf.len * it->src->size)) {
+            it->buf.len++;
+        }
+
+        if (it->buf.len == 0) {
+            return false;
+        }
+
+        memcpy(out, &it->buf, NPK_sizeof_type(NPK_array));
+
+        return true;
+    }
+
+    bool NPK_iter_next(NPK_iter *it, void *out) {
+        return it->next(it, out);
+    }
+
+    NPK_array NPK_iter_collect_new(NPK_iter *it) {
+        NPK_array arr = NPK_array_new_(it->size);
+
+        // Elements are pulled straight into the free space at the end of the array
+        while (true) {
+            NPK_array_reserve_(it->size, &arr, NPK_array_length(&arr) + 1);
+
+            if (it->next(it, NPK_array_data(uint8_t, &arr) + NPK_array_length(&arr) * it->size) == false) {
+                break;
+            }
+
+            arr.len++;
+        }
+
+        return arr;
+    }
+
+    NPK_array NPK_iter_collect_strings_new(NPK_iter *it) {
+        NPK_array strs = NPK_array_new(NPK_string);
+        NPK_string str;
+
+        while (it->next(it, &str)) {
+            NPK_array_add(NPK_string, &strs, NPK_string_copy_new(&str));
+        }
+
+        return strs;
+    }
+
+    int64_t NPK_iter_count(NPK_iter *it) {
+        void *elem = alloca(it->size);
+        int64_t count = 0;
+
+        while (it->next(it, elem)) {
+            count++;
+        }
+
+        return count;
+    }
+
+    void NPK_iter_reduce(NPK_iter *it, void *acc, void (*reduce)(void *acc, const void *elem, void *ctx), void *ctx) {
+        void *elem = alloca(it->size);
+
+        while (it->next(it, elem)) {
+            reduce(acc, elem, ctx);
+        }
+    }
+
+    bool NPK_iter_write(NPK_iter *it, const NPK_cstring *path) {
+        FILE *f = fopen(path, "w");
+        NPK_string line;
+
+        if (f == NULL) {
+            return false;
+        }
+
+        while (it->next(it, &line)) {
+            fwrite(line.data, 1, NPK_string_length(&line), f);
+            fputc('\n', f);
+        }
+
+        return fclose(f) == 0;
+    }
+
+    void NPK_iter_del(NPK_iter *it) {
+        for (; it != NULL; it = it->src) {
+            if (it->buf.data != NULL) {
+                NPK_array_del(&it->buf);
+            }
+
+            if (it->f != NULL) {
+                fclose(it->f);
+                it->f = NULL;
+            }
+        }
+    }
+
+    // The slots never move, so the workers and the kernel can keep pointers into the requests that are in flight
+    struct NPK_aio_state_ {
+        NPK_array slots;
+        NPK_array free;
+        NPK_ring queued;
+        NPK_ring finished;
+        int busy;
+
+        #if defined NPK_IO_URING_
+            int ring_fd;
+            int in_kernel;
+            unsigned unsubmitted;
+            void *sq_ring;
+            void *cq_ring;
+            struct io_uring_sqe *sqes;
+            size_t sq_bytes;
+            size_t cq_bytes;
+            size_t sqes_bytes;
+            unsigned *sq_tail;
+            unsigned *sq_mask;
+            unsigned *sq_array;
+            unsigned *cq_head;
+            unsigned *cq_tail;
+            unsigned *cq_mask;
+            struct io_uring_cqe *cqes;
+        #endif
+
+        #if defined NPK_THREADS_
+            NPK_ring work;
+            NPK_array workers;
+            mtx_t lock;
+            cnd_t wake;
+            cnd_t done;
+            int working;
+            bool stop;
+        #endif
+    };
+
+    // The workers only share the work and finished queues, every other member belongs to the calling thread
+    #if defined NPK_THREADS_
+        #define aio_lock(state) mtx_lock(&(state)->lock)
+        #define aio_unlock(state) mtx_unlock(&(state)->lock)
+    #else
+        #define aio_lock(state)
+        #define aio_unlock(state)
+    #endif
+
+    #define aio_uses_uring(state) ((state)->ring_fd >= 0)
+
+    NPK_aio NPK_aio_new(int depth) {
+        NPK_aio aio;
+        struct NPK_aio_state_ *state = malloc(sizeof *state);
+
+        NPK_stats_alloc_(NPK_stats_other, NPK_sizeof_type(struct NPK_aio_state_));
+        aio.depth = depth > 0 ? depth : 64;
+        aio.state = state;
+        state->slots = NPK_array_sized_new(NPK_aio_request_, aio.depth);
+        state->slots.len = aio.depth;
+        state->free = NPK_array_sized_new(int, aio.depth);
+        state->queued = NPK_ring_new(NPK_aio_request_);
+        state->finished = NPK_ring_sized_new(int, aio.depth);
+        state->busy = 0;
+
+        // The first slots are handed out first
+        NPK_count_down (i, aio.depth, 0) {
+            NPK_array_add(int, &state->free, i);
+        }
+
+        // The lock guards the finished queue with either backend, only the workers are left out with io_uring
+        #if defined NPK_THREADS_
+            int workers = aio.depth < NPK_aio_max_workers_ ? aio.depth : NPK_aio_max_workers_;
+
+            state->work = NPK_ring_sized_new(int, aio.depth);
+            state->workers = NPK_array_sized_new(thrd_t, workers);
+            mtx_init(&state->lock, mtx_plain);
+            cnd_init(&state->wake);
+            cnd_init(&state->done);
+            state->working = 0;
+            state->stop = false;
+        #endif
+
+        #if defined NPK_IO_URING_
+            if (NPK_aio_uring_new_(state, aio.depth)) {
+                return aio;
+            }
+        #endif
+
+        #if defined NPK_THREADS_
+            state->workers.len = workers;
+
+            NPK_for_each (thrd_t, thread, &state->workers) {
+                thrd_create(thread, NPK_aio_work_, state);
+            }
+        #endif
+
+        return aio;
+    }
+
+    #if defined NPK_IO_URING_
+        bool NPK_aio_uring_new_(struct NPK_aio_state_ *state, int depth) {
+            struct io_uring_params params;
+
+            memset(&params, 0, sizeof params);
+            state->sq_ring = NULL;
+            state->cq_ring = NULL;
+            state->sqes = NULL;
+            state->in_kernel = 0;
+            state->unsubmitted = 0;
+            state->ring_fd = syscall(__NR_io_uring_setup, depth, &params);
+
+            // Kernels too old for plain reads and writes, and sandboxes that forbid io_uring, get the worker threads
+            if (state->ring_fd < 0 || (params.features & IORING_FEAT_FAST_POLL) == 0) {
+                NPK_aio_uring_del_(state);
+
+                return false;
+            }
+
+            // Each of the three regions is mapped on its own, which every kernel with io_uring supports
+            state->sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            state->cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+            state->sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+            state->sq_ring = mmap(NULL, state->sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, state->ring_fd, IORING_OFF_SQ_RING);
+            state->cq_ring = mmap(NULL, state->cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, state->ring_fd, IORING_OFF_CQ_RING);
+            state->sqes = mmap(NULL, state->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, state->ring_fd, IORING_OFF_SQES);
+            state->sq_ring = state->sq_ring == MAP_FAILED ? NULL : state->sq_ring;
+            state->cq_ring = state->cq_ring == MAP_FAILED ? NULL : state->cq_ring;
+            state->sqes = state->sqes == MAP_FAILED ? NULL : state->sqes;
+
+            if (state->sq_ring == NULL || state->cq_ring == NULL || state->sqes == NULL) {
+                NPK_aio_uring_del_(state);
+
+                return false;
+            }
+
+            state->sq_tail = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->sq_ring) + params.sq_off.tail);
+            state->sq_mask = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->sq_ring) + params.sq_off.ring_mask);
+            state->sq_array = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->sq_ring) + params.sq_off.array);
+            state->cq_head = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->cq_ring) + params.cq_off.head);
+            state->cq_tail = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->cq_ring) + params.cq_off.tail);
+            state->cq_mask = NPK_cast(unsigned *, NPK_cast(uint8_t *, state->cq_ring) + params.cq_off.ring_mask);
+            state->cqes = NPK_cast(struct io_uring_cqe *, NPK_cast(uint8_t *, state->cq_ring) + params.cq_off.cqes);
+
+            return true;
+        }
+
+        void NPK_aio_uring_del_(struct NPK_aio_state_ *state) {
+            if (state->sq_ring != NULL) {
+                munmap(state->sq_ring, state->sq_bytes);
+            }
+
+            if (state->cq_ring != NULL) {
+                munmap(state->cq_ring, state->cq_bytes);
+            }
+
+            if (state->sqes != NULL) {
+                munmap(state->sqes, state->sqes_bytes);
+            }
+
+            if (state->ring_fd >= 0) {
+                close(state->ring_fd);
+            }
+
+            state->ring_fd = -1;
+        }
+
+        // Every slot has at most one entry in the rings, and both rings have at least "depth" entries, so neither can overflow
+        void NPK_aio_prep_(struct NPK_aio_state_ *state, int slot) {
+            NPK_aio_request_ *req = NPK_array_data(NPK_aio_request_, &state->slots) + slot;
+            unsigned tail = *state->sq_tail;
+            unsigned idx = tail & *state->sq_mask;
+            struct io_uring_sqe *sqe = state->sqes + idx;
+
+            memset(sqe, 0, sizeof *sqe);
+            sqe->opcode = req->write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = req->fd;
+            sqe->addr = NPK_cast(uintptr_t, NPK_cast(uint8_t *, req->arr->data) + req->offset);
+            sqe->len = req->bytes - req->offset;
+            sqe->off = req->offset;
+            sqe->user_data = slot;
+            state->sq_array[idx] = idx;
+
+            // The kernel must see the entry before it sees the new tail
+            __atomic_store_n(state->sq_tail, tail + 1, __ATOMIC_RELEASE);
+            state->unsubmitted++;
+            state->in_kernel++;
+        }
+
+        // Submits every prepared entry with one system call, waits for a completion if asked to, then reaps all of them
+        void NPK_aio_enter_(struct NPK_aio_state_ *state, bool wait) {
+            wait = wait && state->in_kernel > 0;
+
+            if (state->unsubmitted > 0 || wait) {
+                int submitted = syscall(__NR_io_uring_enter, state->ring_fd, state->unsubmitted, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+                // An interrupted call is simply made again by the next loop of NPK_aio_complete_
+                state->unsubmitted -= submitted > 0 ? submitted : 0;
+            }
+
+            unsigned head = *state->cq_head;
+            unsigned tail = __atomic_load_n(state->cq_tail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; head++) {
+                struct io_uring_cqe *cqe = state->cqes + (head & *state->cq_mask);
+                int slot = cqe->user_data;
+                NPK_aio_request_ *req = NPK_array_data(NPK_aio_request_, &state->slots) + slot;
+
+                state->in_kernel--;
+                req->offset += cqe->res > 0 ? cqe->res : 0;
+                req->ok = cqe->res >= 0;
+
+                // A short transfer continues where it stopped, and a read of zero bytes means the file got shorter
+                if (cqe->res > 0 && req->offset < req->bytes) {
+                    NPK_aio_prep_(state, slot);
+                } else {
+                    NPK_ring_push_back(int, &state->finished, slot);
+                }
+            }
+
+            __atomic_store_n(state->cq_head, head, __ATOMIC_RELEASE);
+        }
+    #endif
+
+    #if defined NPK_THREADS_
+        int NPK_aio_work_(void *p) {
+            struct NPK_aio_state_ *state = p;
+            int slot;
+
+            mtx_lock(&state->lock);
+
+            while (true) {
+                while (NPK_ring_pop_front(int, &state->work, &slot) == false) {
+                    if (state->stop) {
+                        mtx_unlock(&state->lock);
+
+                        return 0;
+                    }
+
+                    cnd_wait(&state->wake, &state->lock);
+                }
+
+                mtx_unlock(&state->lock);
+                NPK_aio_transfer_(NPK_array_data(NPK_aio_request_, &state->slots) + slot);
+                mtx_lock(&state->lock);
+
+                NPK_ring_push_back(int, &state->finished, slot);
+                state->working--;
+                cnd_signal(&state->done);
+            }
+        }
+    #endif
+
+    void NPK_aio_submit_(NPK_aio *aio, const NPK_cstring *path, NPK_array *arr, bool write, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx) {
+        NPK_aio_request_ req;
+
+        memset(&req, 0, sizeof req);
+        req.arr = arr;
+        req.done = done;
+        req.ctx = ctx;
+        req.path = NPK_string_new(path);
+        req.write = write;
+        NPK_ring_push_back(NPK_aio_request_, &aio->state->queued, req);
+        NPK_aio_start_(aio->state);
+    }
+
+    void NPK_aio_read_bytes_new(NPK_aio *aio, const NPK_cstring *path, NPK_array *out, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx) {
+        *out = NPK_array_new(uint8_t);
+        NPK_aio_submit_(aio, path, out, false, done, ctx);
+    }
+
+    void NPK_aio_write_bytes(NPK_aio *aio, const NPK_cstring *path, const NPK_array *arr, void (*done)(NPK_array *arr, bool ok, void *ctx), void *ctx) {
+        NPK_aio_submit_(aio, path, NPK_cast(NPK_array *, arr), true, done, ctx);
+    }
+
+    NPK_array NPK_aio_read_all_new(NPK_aio *aio, const NPK_array *paths) {
+        NPK_array files = NPK_array_sized_new(NPK_array, NPK_array_length(paths) > 0 ? NPK_array_length(paths) : 1);
+
+        // The arrays are written in place, so their addresses must not change while the requests are in flight
+        files.len = NPK_array_length(paths);
+
+        NPK_count_up (i, 0, NPK_array_length(paths)) {
+            const NPK_string *path = NPK_array_data(NPK_string, paths) + i;
+
+            NPK_aio_read_bytes_new(aio, NPK_string_data(path), NPK_array_data(NPK_array, &files) + i, NULL, NULL);
+        }
+
+        NPK_aio_wait(aio);
+
+        return files;
+    }
+
+    // Hands queued requests to the backend for as long as there are free slots
+    void NPK_aio_start_(struct NPK_aio_state_ *state) {
+        while (NPK_array_is_empty(&state->free) == false && NPK_ring_is_empty(&state->queued) == false) {
+            int slot = NPK_array_data(int, &state->free)[--state->free.len];
+            NPK_aio_request_ *req = NPK_array_data(NPK_aio_request_, &state->slots) + slot;
+
+            NPK_ring_pop_front(NPK_aio_request_, &state->queued, req);
+            state->busy++;
+
+            // Requests that fail to open, or have nothing to transfer, finish right away
+            if (NPK_aio_open_(req) == false || req->offset == req->bytes) {
+                aio_lock(state);
+                NPK_ring_push_back(int, &state->finished, slot);
+                aio_unlock(state);
+
+                continue;
+            }
+
+            #if defined NPK_IO_URING_
+                if (aio_uses_uring(state)) {
+                    NPK_aio_prep_(state, slot);
+
+                    continue;
+                }
+            #endif
+
+            #if defined NPK_THREADS_
+                mtx_lock(&state->lock);
+                NPK_ring_push_back(int, &state->work, slot);
+                state->working++;
+                cnd_signal(&state->wake);
+                mtx_unlock(&state->lock);
+            #else
+                NPK_aio_transfer_(req);
+                NPK_ring_push_back(int, &state->finished, slot);
+            #endif
+        }
+    }
+
+    // Opens the file and sizes the transfer on the calling thread, so that reads allocate their array there
+    bool NPK_aio_open_(NPK_aio_request_ *req) {
+        int64_t bytes = NPK_array_length(req->arr);
+
+        req->ok = false;
+
+        #if defined NPK_POSIX_
+            struct stat st;
+
+            req->fd = open(NPK_string_data(&req->path), req->write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY, 0666);
+
+            if (req->fd < 0 || (req->write == false && fstat(req->fd, &st) != 0)) {
+                return false;
+            }
+
+            bytes = req->write ? bytes : st.st_size;
+        #else
+            req->f = fopen(NPK_string_data(&req->path), req->write ? "wb" : "rb");
+
+            if (req->f == NULL) {
+                return false;
+            }
+
+            if (req->write == false) {
+                if (fseek(req->f, 0, SEEK_END) != 0 || (bytes = ftell(req->f)) < 0 || fseek(req->f, 0, SEEK_SET) != 0) {
+                    return false;
+                }
+            }
+        #endif
+
+        if (req->write == false) {
+            if (bytes > INT_MAX) {
+                return false;
+            }
+
+            if (bytes > req->arr->maxlen) {
+                NPK_array_del(req->arr);
+                *req->arr = NPK_array_sized_new(uint8_t, bytes);
+            }
+        }
+
+        req->bytes = bytes;
+        req->ok = true;
+
+        return true;
+    }
+
+    // The blocking transfer the workers run, or the calling thread when there are neither threads nor io_uring
+    void NPK_aio_transfer_(NPK_aio_request_ *req) {
+        uint8_t *data = req->arr->data;
+
+        while (req->offset < req->bytes) {
+            #if defined NPK_POSIX_
+                ssize_t n;
+
+                // Every request has a descriptor of its own, so its position always matches the offset
+                if (req->write) {
+                    n = write(req->fd, data + req->offset, req->bytes - req->offset);
+                } else {
+                    n = read(req->fd, data + req->offset, req->bytes - req->offset);
+                }
+
+                req->ok = n >= 0;
+            #else
+                size_t n;
+
+                if (req->write) {
+                    n = fwrite(data + req->offset, 1, req->bytes - req->offset, req->f);
+                } else {
+                    n = fread(data + req->offset, 1, req->bytes - req->offset, req->f);
+                }
+
+                req->ok = ferror(req->f) == 0;
+            #endif
+
+            if (n <= 0) {
+                return;
+            }
+
+            req->offset += n;
+        }
+    }
+
+    // Frees the slot before the callback runs, so that the callback can submit new requests
+    void NPK_aio_finish_(struct NPK_aio_state_ *state, int slot) {
+        NPK_aio_request_ *req = NPK_array_data(NPK_aio_request_, &state->slots) + slot;
+        NPK_array *arr = req->arr;
+        void (*done)(NPK_array *arr, bool ok, void *ctx) = req->done;
+        void *ctx = req->ctx;
+        bool ok = req->ok && (req->write == false || req->offset == req->bytes);
+
+        // Closing a written file can still report a failed write
+        #if defined NPK_POSIX_
+            if (req->fd >= 0) {
+                ok = close(req->fd) == 0 && ok;
+            }
+        #else
+            if (req->f != NULL) {
+                ok = fclose(req->f) == 0 && ok;
+            }
+        #endif
+
+        if (req->write == false) {
+            arr->len = ok ? req->offset : 0;
+        }
+
+        NPK_string_del(&req->path);
+        NPK_array_add(int, &state->free, slot);
+        state->busy--;
+
+        if (done != NULL) {
+            done(arr, ok, ctx);
+        }
+    }
+
+    int NPK_aio_complete_(struct NPK_aio_state_ *state, bool wait) {
+        int finished = 0;
+        int slot;
+
+        while (true) {
+            #if defined NPK_IO_URING_
+                if (aio_uses_uring(state)) {
+                    NPK_aio_enter_(state, wait && NPK_ring_is_empty(&state->finished));
+                }
+            #endif
+
+            aio_lock(state);
+
+            #if defined NPK_THREADS_
+                while (wait && NPK_ring_is_empty(&state->finished) && state->working > 0) {
+                    cnd_wait(&state->done, &state->lock);
+                }
+            #endif
+
+            bool found = NPK_ring_pop_front(int, &state->finished, &slot);
+
+            aio_unlock(state);
+
+            if (found) {
+                NPK_aio_finish_(state, slot);
+                NPK_aio_start_(state);
+                finished++;
+            } else if (wait == false || state->busy == 0) {
+                return finished;
+            }
+        }
+    }
+
+    int NPK_aio_poll(NPK_aio *aio) {
+        return NPK_aio_complete_(aio->state, false);
+    }
+
+    int NPK_aio_wait(NPK_aio *aio) {
+        return NPK_aio_complete_(aio->state, true);
+    }
+
+    int NPK_aio_pending(const NPK_aio *aio) {
+        return aio->state->busy + NPK_ring_length(&aio->state->queued);
+    }
+
+    void NPK_aio_del(NPK_aio *aio) {
+        struct NPK_aio_state_ *state = aio->state;
+
+        NPK_aio_wait(aio);
+
+        #if defined NPK_IO_URING_
+            NPK_aio_uring_del_(state);
+        #endif
+
+        #if defined NPK_THREADS_
+            mtx_lock(&state->lock);
+            state->stop = true;
+            cnd_broadcast(&state->wake);
+            mtx_unlock(&state->lock);
+
+            NPK_for_each (thrd_t, thread, &state->workers) {
+                thrd_join(*thread, NULL);
+            }
+
+            NPK_ring_del(&state->work);
+            NPK_array_del(&state->workers);
+            mtx_destroy(&state->lock);
+            cnd_destroy(&state->wake);
+            cnd_destroy(&state->done);
+        #endif
+
+        NPK_array_del(&state->slots);
+        NPK_array_del(&state->free);
+        NPK_ring_del(&state->queued);
+        NPK_ring_del(&state->finished);
+        free(state);
+        aio->state = NULL;
+    }
+
+    #undef aio_lock
+    #undef aio_unlock
+    #undef aio_uses_uring
+
+    NPK_radix NPK_radix_new_(int size) {
+        NPK_radix t;
+
+        t.size = size;
+        t.len = 0;
+        t.leaf_bytes = sizeof(NPK_radix_leaf_) + (size + 7) / 8 * 8;
+        t.root = 0;
+        t.blocks = NPK_array_new(NPK_array);
+
+        NPK_count_up (i, 0, 5) {
+            t.pools[i] = NPK_array_sized_new_(NPK_radix_kind_bytes_(&t, i + 1), 8);
+            t.free[i] = NPK_array_new(uint32_t);
+        }
+
+        return t;
+    }
+
+    // An add or a remove allocates at most one node of each kind, so reserving one up front keeps every node pointer valid
+    void NPK_radix_reserve_(NPK_radix *t) {
+        NPK_count_up (i, 0, 5) {
+            NPK_array_reserve_(NPK_radix_kind_bytes_(t, i + 1), t->pools + i, NPK_array_length(t->pools + i) + 1);
+        }
+    }
+
+    uint32_t NPK_radix_alloc_(NPK_radix *t, int kind) {
+        NPK_array *pool = t->pools + kind - 1;
+        NPK_array *free_nodes = t->free + kind - 1;
+        uint32_t ref;
+
+        if (NPK_array_is_empty(free_nodes)) {
+            NPK_array_reserve_(NPK_radix_kind_bytes_(t, kind), pool, NPK_array_length(pool) + 1);
+            ref = NPK_radix_ref_(kind, pool->len++);
+        } else {
+            ref = NPK_array_data(uint32_t, free_nodes)[--free_nodes->len];
+        }
+
+        memset(NPK_radix_node_(t, ref), 0, NPK_radix_kind_bytes_(t, kind));
+
+        return ref;
+    }
+
+    void NPK_radix_free_(NPK_radix *t, uint32_t ref) {
+        NPK_array_add(uint32_t, t->free + NPK_radix_kind_(ref) - 1, ref);
+    }
+
+    // The key is copied with its nul byte and never straddles two blocks, the blocks double up to 16 MiB
+    uint32_t NPK_radix_leaf_new_(NPK_radix *t, const char *key, int len, const void *val) {
+        NPK_array *block = NPK_array_data(NPK_array, &t->blocks) + NPK_array_length(&t->blocks) - 1;
+
+        if (NPK_array_is_empty(&t->blocks) || block->maxlen - NPK_array_length(block) < len + 1) {
+            int maxlen = NPK_array_is_empty(&t->blocks) ? 256 : block->maxlen < (1 << 24) ? block->maxlen * 2 : block->maxlen;
+
+            NPK_array_add(NPK_array, &t->blocks, NPK_array_sized_new(uint8_t, maxlen > len + 1 ? maxlen : len + 1));
+            block = NPK_array_data(NPK_array, &t->blocks) + NPK_array_length(&t->blocks) - 1;
+        }
+
+        uint32_t ref = NPK_radix_alloc_(t, NPK_radix_leaf_kind_);
+        NPK_radix_leaf_ *leaf = NPK_radix_leaf_at_(t, ref);
+
+        leaf->key = NPK_cast(int64_t, NPK_array_length(&t->blocks) - 1) << 32 | NPK_array_length(block);
+        leaf->len = len;
+        memcpy(NPK_array_data(uint8_t, block) + NPK_array_length(block), key, len);
+        NPK_array_data(uint8_t, block)[NPK_array_length(block) + len] = '\0';
+        block->len += len + 1;
+        memcpy(NPK_radix_value_(t, ref), val, t->size);
+
+        return ref;
+    }
+
+    bool NPK_radix_leaf_matches_(const NPK_radix *t, uint32_t ref, const char *key, int len) {
+        NPK_radix_leaf_ *leaf = NPK_radix_leaf_at_(t, ref);
+
+        return leaf->len == len && memcmp(NPK_radix_key_(t, leaf->key), key, len) == 0;
+    }
+
+    uint32_t NPK_radix_any_leaf_(const NPK_radix *t, uint32_t ref) {
+        while (NPK_radix_kind_(ref) != NPK_radix_leaf_kind_) {
+            uint8_t *node = NPK_radix_node_(t, ref);
+
+            switch (NPK_radix_kind_(ref)) {
+                case NPK_radix_node4_kind_:
+                    ref = NPK_cast(NPK_radix_node4_ *, node)->children[0];
+                    break;
+                case NPK_radix_node16_kind_:
+                    ref = NPK_cast(NPK_radix_node16_ *, node)->children[0];
+                    break;
+                case NPK_radix_node48_kind_: {
+                    NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, node);
+                    int pos = 0;
+
+                    // Removed children leave holes behind in a node48
+                    while (n->children[pos] == 0) {
+                        pos++;
+                    }
+
+                    ref = n->children[pos];
+                    break;
+                }
+                default: {
+                    NPK_radix_node256_ *n = NPK_cast(NPK_radix_node256_ *, node);
+                    int pos = 0;
+
+                    while (n->children[pos] == 0) {
+                        pos++;
+                    }
+
+                    ref = n->children[pos];
+                    break;
+                }
+            }
+        }
+
+        return ref;
+    }
+
+    // "offset" is only read when the path is too long to live in the node, and then it must locate "bytes" in the blocks
+    void NPK_radix_set_prefix_(NPK_radix_header_ *h, const uint8_t *bytes, int64_t offset, uint32_t len) {
+        if (len <= NPK_radix_inline_) {
+            uint8_t copy[NPK_radix_inline_];
+
+            // "bytes" can point into the node itself
+            memcpy(copy, bytes, len);
+            memcpy(h->prefix.bytes, copy, len);
+        } else {
+            h->prefix.offset = offset;
+        }
+
+        h->prefix_len = len;
+    }
+
+    uint32_t *NPK_radix_child_(const NPK_radix *t, uint32_t ref, uint8_t byte) {
+        uint8_t *node = NPK_radix_node_(t, ref);
+
+        switch (NPK_radix_kind_(ref)) {
+            case NPK_radix_node4_kind_: {
+                NPK_radix_node4_ *n = NPK_cast(NPK_radix_node4_ *, node);
+
+                NPK_count_up (i, 0, n->h.count) {
+                    if (n->keys[i] == byte) {
+                        return n->children + i;
+                    }
+                }
+
+                return NULL;
+            }
+            case NPK_radix_node16_kind_: {
+                NPK_radix_node16_ *n = NPK_cast(NPK_radix_node16_ *, node);
+
+                #if defined NPK_SSE2_
+                    __m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8(byte), _mm_loadu_si128(NPK_cast(const __m128i *, n->keys)));
+                    int mask = _mm_movemask_epi8(eq) & ((1 << n->h.count) - 1);
+
+                    return mask != 0 ? n->children + NPK_ctz64_(mask) : NULL;
+                #else
+                    NPK_count_up (i, 0, n->h.count) {
+                        if (n->keys[i] == byte) {
+                            return n->children + i;
+                        }
+                    }
+
+                    return NULL;
+                #endif
+            }
+            case NPK_radix_node48_kind_: {
+                NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, node);
+
+                return n->index[byte] != 0 ? n->children + n->index[byte] - 1 : NULL;
+            }
+            default: {
+                NPK_radix_node256_ *n = NPK_cast(NPK_radix_node256_ *, node);
+
+                return n->children[byte] != 0 ? n->children + byte : NULL;
+            }
+        }
+    }
+
+    // A full node is replaced in "slot" by a node of the next kind, which then takes the child
+    void NPK_radix_add_child_(NPK_radix *t, uint32_t *slot, uint8_t byte, uint32_t child) {
+        uint32_t ref = *slot;
+        uint8_t *node = NPK_radix_node_(t, ref);
+        uint32_t grown;
+
+        switch (NPK_radix_kind_(ref)) {
+            case NPK_radix_node4_kind_:
+            case NPK_radix_node16_kind_: {
+                bool small = NPK_radix_kind_(ref) == NPK_radix_node4_kind_;
+                NPK_radix_header_ *h = NPK_cast(NPK_radix_header_ *, node);
+                uint8_t *keys = small ? NPK_cast(NPK_radix_node4_ *, node)->keys : NPK_cast(NPK_radix_node16_ *, node)->keys;
+                uint32_t *children = small ? NPK_cast(NPK_radix_node4_ *, node)->children : NPK_cast(NPK_radix_node16_ *, node)->children;
+
+                if (h->count < (small ? 4 : 16)) {
+                    int pos = 0;
+
+                    // The keys stay sorted, so the children are visited in the order of their bytes
+                    while (pos < h->count && keys[pos] < byte) {
+                        pos++;
+                    }
+
+                    memmove(keys + pos + 1, keys + pos, h->count - pos);
+                    memmove(children + pos + 1, children + pos, (h->count - pos) * sizeof *children);
+                    keys[pos] = byte;
+                    children[pos] = child;
+                    h->count++;
+
+                    return;
+                }
+
+                if (small) {
+                    grown = NPK_radix_alloc_(t, NPK_radix_node16_kind_);
+
+                    NPK_radix_node16_ *n = NPK_cast(NPK_radix_node16_ *, NPK_radix_node_(t, grown));
+
+                    n->h = *h;
+                    memcpy(n->keys, keys, 4);
+                    memcpy(n->children, children, 4 * sizeof *children);
+                } else {
+                    grown = NPK_radix_alloc_(t, NPK_radix_node48_kind_);
+
+                    NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, NPK_radix_node_(t, grown));
+
+                    n->h = *h;
+                    memcpy(n->children, children, 16 * sizeof *children);
+
+                    NPK_count_up (i, 0, 16) {
+                        n->index[keys[i]] = i + 1;
+                    }
+                }
+
+                break;
+            }
+            case NPK_radix_node48_kind_: {
+                NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, node);
+
+                if (n->h.count < 48) {
+                    int pos = 0;
+
+                    while (n->children[pos] != 0) {
+                        pos++;
+                    }
+
+                    n->children[pos] = child;
+                    n->index[byte] = pos + 1;
+                    n->h.count++;
+
+                    return;
+                }
+
+                grown = NPK_radix_alloc_(t, NPK_radix_node256_kind_);
+
+                NPK_radix_node256_ *n256 = NPK_cast(NPK_radix_node256_ *, NPK_radix_node_(t, grown));
+
+                n256->h = n->h;
+
+                NPK_count_up (b, 0, 256) {
+                    if (n->index[b] != 0) {
+                        n256->children[b] = n->children[n->index[b] - 1];
+                    }
+                }
+
+                break;
+            }
+            default: {
+                NPK_radix_node256_ *n = NPK_cast(NPK_radix_node256_ *, node);
+
+                n->children[byte] = child;
+                n->h.count++;
+
+                return;
+            }
+        }
+
+        NPK_radix_free_(t, ref);
+        *slot = grown;
+        NPK_radix_add_child_(t, slot, byte, child);
+    }
+
+    // A node that gets too sparse is replaced in "slot" by a node of the previous kind, whose thresholds are lower than
+    // those for growing so that alternating adds and removes don't keep converting a node
+    // A node4 left with a single child is replaced by that child, which takes over the path of the node at "depth"
+    void NPK_radix_remove_child_(NPK_radix *t, uint32_t *slot, uint8_t byte, int depth) {
+        uint32_t ref = *slot;
+        uint8_t *node = NPK_radix_node_(t, ref);
+        NPK_radix_header_ *h = NPK_cast(NPK_radix_header_ *, node);
+        uint32_t shrunk;
+
+        switch (NPK_radix_kind_(ref)) {
+            case NPK_radix_node4_kind_:
+            case NPK_radix_node16_kind_: {
+                bool small = NPK_radix_kind_(ref) == NPK_radix_node4_kind_;
+                uint8_t *keys = small ? NPK_cast(NPK_radix_node4_ *, node)->keys : NPK_cast(NPK_radix_node16_ *, node)->keys;
+                uint32_t *children = small ? NPK_cast(NPK_radix_node4_ *, node)->children : NPK_cast(NPK_radix_node16_ *, node)->children;
+                int pos = NPK_radix_child_(t, ref, byte) - children;
+
+                memmove(keys + pos, keys + pos + 1, h->count - pos - 1);
+                memmove(children + pos, children + pos + 1, (h->count - pos - 1) * sizeof *children);
+                h->count--;
+
+                if (small && h->count == 1) {
+                    uint32_t only = children[0];
+
+                    if (NPK_radix_kind_(only) != NPK_radix_leaf_kind_) {
+                        NPK_radix_header_ *ch = NPK_radix_header_at_(t, only);
+                        uint32_t len = h->prefix_len + 1 + ch->prefix_len;
+                        uint8_t bytes[NPK_radix_inline_];
+                        int64_t offset = 0;
+
+                        if (len <= NPK_radix_inline_) {
+                            memcpy(bytes, NPK_radix_prefix_(t, h), h->prefix_len);
+                            bytes[h->prefix_len] = keys[0];
+                            memcpy(bytes + h->prefix_len + 1, NPK_radix_prefix_(t, ch), ch->prefix_len);
+                        } else {
+                            // From "depth" on, any key below the child spells out both paths and the byte between them
+                            offset = NPK_radix_leaf_at_(t, NPK_radix_any_leaf_(t, only))->key + depth;
+                        }
+
+                        NPK_radix_set_prefix_(ch, bytes, offset, len);
+                    }
+
+                    NPK_radix_free_(t, ref);
+                    *slot = only;
+
+                    return;
+                }
+
+                if (small || h->count > 3) {
+                    return;
+                }
+
+                shrunk = NPK_radix_alloc_(t, NPK_radix_node4_kind_);
+
+                NPK_radix_node4_ *n = NPK_cast(NPK_radix_node4_ *, NPK_radix_node_(t, shrunk));
+
+                n->h = *h;
+                memcpy(n->keys, keys, 3);
+                memcpy(n->children, children, 3 * sizeof *children);
+
+                break;
+            }
+            case NPK_radix_node48_kind_: {
+                NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, node);
+                int pos = 0;
+
+                n->children[n->index[byte] - 1] = 0;
+                n->index[byte] = 0;
+                n->h.count--;
+
+                if (n->h.count > 12) {
+                    return;
+                }
+
+                shrunk = NPK_radix_alloc_(t, NPK_radix_node16_kind_);
+
+                NPK_radix_node16_ *n16 = NPK_cast(NPK_radix_node16_ *, NPK_radix_node_(t, shrunk));
+
+                n16->h = n->h;
+
+                NPK_count_up (b, 0, 256) {
+                    if (n->index[b] != 0) {
+                        n16->keys[pos] = b;
+                        n16->children[pos++] = n->children[n->index[b] - 1];
+                    }
+                }
+
+                break;
+            }
+            default: {
+                NPK_radix_node256_ *n = NPK_cast(NPK_radix_node256_ *, node);
+                int pos = 0;
+
+                n->children[byte] = 0;
+                n->h.count--;
+
+                if (n->h.count > 37) {
+                    return;
+                }
+
+                shrunk = NPK_radix_alloc_(t, NPK_radix_node48_kind_);
+
+                NPK_radix_node48_ *n48 = NPK_cast(NPK_radix_node48_ *, NPK_radix_node_(t, shrunk));
+
+                n48->h = n->h;
+
+                NPK_count_up (b, 0, 256) {
+                    if (n->children[b] != 0) {
+                        n48->children[pos] = n->children[b];
+                        n48->index[b] = ++pos;
+                    }
+                }
+
+                break;
+            }
+        }
+
+        NPK_radix_free_(t, ref);
+        *slot = shrunk;
+    }
+
+    // The paths are skipped without reading them, since the leaf at the end has the whole key to compare with
+    void *NPK_radix_get_(const NPK_radix *t, const char *key, int len) {
+        uint32_t ref = t->root;
+        int depth = 0;
+
+        while (ref != 0) {
+            if (NPK_radix_kind_(ref) == NPK_radix_leaf_kind_) {
+                return NPK_radix_leaf_matches_(t, ref, key, len) ? NPK_radix_value_(t, ref) : NULL;
+            }
+
+            depth += NPK_radix_header_at_(t, ref)->prefix_len;
+
+            if (depth > len) {
+                return NULL;
+            }
+
+            uint32_t *child = NPK_radix_child_(t, ref, key[depth]);
+
+            ref = child != NULL ? *child : 0;
+            depth++;
+        }
+
+        return NULL;
+    }
+
+    // Every key ends in its nul byte, so no key is a prefix of another and the keys only ever end at leaves
+    void NPK_radix_add_(NPK_radix *t, const char *key, int len, const void *val) {
+        const uint8_t *bytes = NPK_cast(const uint8_t *, key);
+        uint32_t *slot = &t->root;
+        int depth = 0;
+
+        NPK_radix_reserve_(t);
+
+        while (*slot != 0) {
+            uint32_t ref = *slot;
+
+            if (NPK_radix_kind_(ref) == NPK_radix_leaf_kind_) {
+                if (NPK_radix_leaf_matches_(t, ref, key, len)) {
+                    memcpy(NPK_radix_value_(t, ref), val, t->size);
+
+                    return;
+                }
+
+                // The new node4 holds the bytes both keys share past "depth", and the first one they differ in leads to each
+                NPK_radix_leaf_ *old = NPK_radix_leaf_at_(t, ref);
+                const uint8_t *old_bytes = NPK_radix_key_(t, old->key);
+                int end = old->len < len ? old->len : len;
+                int i = depth;
+
+                while (i < end && old_bytes[i] == bytes[i]) {
+                    i++;
+                }
+
+                uint32_t leaf = NPK_radix_leaf_new_(t, key, len, val);
+                uint32_t split = NPK_radix_alloc_(t, NPK_radix_node4_kind_);
+                int64_t offset = NPK_radix_leaf_at_(t, leaf)->key + depth;
+
+                NPK_radix_set_prefix_(NPK_radix_header_at_(t, split), NPK_radix_key_(t, offset), offset, i - depth);
+                NPK_radix_add_child_(t, &split, old_bytes[i], ref);
+                NPK_radix_add_child_(t, &split, bytes[i], leaf);
+                *slot = split;
+                t->len++;
+
+                return;
+            }
+
+            NPK_radix_header_ *h = NPK_radix_header_at_(t, ref);
+            const uint8_t *prefix = NPK_radix_prefix_(t, h);
+            uint32_t i = 0;
+
+            while (i < h->prefix_len && depth + NPK_cast(int, i) <= len && prefix[i] == bytes[depth + i]) {
+                i++;
+            }
+
+            // The key leaves the path of the node, so a node4 takes over the part they share
+            if (i < h->prefix_len) {
+                uint32_t leaf = NPK_radix_leaf_new_(t, key, len, val);
+                uint32_t split = NPK_radix_alloc_(t, NPK_radix_node4_kind_);
+                uint8_t byte = prefix[i];
+
+                NPK_radix_set_prefix_(NPK_radix_header_at_(t, split), prefix, h->prefix.offset, i);
+                NPK_radix_set_prefix_(h, prefix + i + 1, h->prefix.offset + i + 1, h->prefix_len - i - 1);
+                NPK_radix_add_child_(t, &split, byte, ref);
+                NPK_radix_add_child_(t, &split, bytes[depth + i], leaf);
+                *slot = split;
+                t->len++;
+
+                return;
+            }
+
+            depth += h->prefix_len;
+
+            uint32_t *child = NPK_radix_child_(t, ref, bytes[depth]);
+
+            if (child == NULL) {
+                NPK_radix_add_child_(t, slot, bytes[depth], NPK_radix_leaf_new_(t, key, len, val));
+                t->len++;
+
+                return;
+            }
+
+            slot = child;
+            depth++;
+        }
+
+        *slot = NPK_radix_leaf_new_(t, key, len, val);
+        t->len++;
+    }
+
+    bool NPK_radix_remove_(NPK_radix *t, const char *key, int len) {
+        uint32_t *slot = &t->root;
+        uint32_t *parent = NULL;
+        int depth = 0;
+        int parent_depth = 0;
+        uint8_t byte = 0;
+
+        NPK_radix_reserve_(t);
+
+        while (*slot != 0) {
+            uint32_t ref = *slot;
+
+            if (NPK_radix_kind_(ref) == NPK_radix_leaf_kind_) {
+                if (NPK_radix_leaf_matches_(t, ref, key, len) == false) {
+                    return false;
+                }
+
+                NPK_radix_free_(t, ref);
+
+                if (parent == NULL) {
+                    t->root = 0;
+                } else {
+                    NPK_radix_remove_child_(t, parent, byte, parent_depth);
+                }
+
+                t->len--;
+
+                return true;
+            }
+
+            parent_depth = depth;
+            depth += NPK_radix_header_at_(t, ref)->prefix_len;
+
+            if (depth > len) {
+                return false;
+            }
+
+            byte = key[depth];
+            parent = slot;
+            slot = NPK_radix_child_(t, ref, byte);
+            depth++;
+
+            if (slot == NULL) {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    void NPK_radix_entry_(const NPK_radix *t, uint32_t ref, NPK_radix_entry *out) {
+        NPK_radix_leaf_ *leaf = NPK_radix_leaf_at_(t, ref);
+
+        out->key.len = leaf->len + 1;
+        out->key.maxlen = leaf->len + 1;
+        out->key.data = NPK_radix_key_(t, leaf->key);
+        out->value = NPK_radix_value_(t, ref);
+    }
+
+    // Unlike a lookup this compares every path, so a key that hangs off the nul byte of a node always is a prefix of "str"
+    bool NPK_radix_longest_prefix(const NPK_radix *t, const NPK_string *str, NPK_radix_entry *out) {
+        const uint8_t *bytes = str->data;
+        int len = NPK_string_length(str);
+        uint32_t ref = t->root;
+        uint32_t found = 0;
+        int depth = 0;
+
+        while (ref != 0) {
+            if (NPK_radix_kind_(ref) == NPK_radix_leaf_kind_) {
+                NPK_radix_leaf_ *leaf = NPK_radix_leaf_at_(t, ref);
+
+                if (leaf->len <= len && memcmp(NPK_radix_key_(t, leaf->key), bytes, leaf->len) == 0) {
+                    found = ref;
+                }
+
+                break;
+            }
+
+            NPK_radix_header_ *h = NPK_radix_header_at_(t, ref);
+
+            if (NPK_cast(uint32_t, len - depth) < h->prefix_len || memcmp(NPK_radix_prefix_(t, h), bytes + depth, h->prefix_len) != 0) {
+                break;
+            }
+
+            depth += h->prefix_len;
+
+            uint32_t *end = NPK_radix_child_(t, ref, '\0');
+
+            if (end != NULL && NPK_radix_kind_(*end) == NPK_radix_leaf_kind_) {
+                found = *end;
+            }
+
+            uint32_t *child = depth < len ? NPK_radix_child_(t, ref, bytes[depth]) : NULL;
+
+            ref = child != NULL ? *child : 0;
+            depth++;
+        }
+
+        if (found != 0) {
+            NPK_radix_entry_(t, found, out);
+        }
+
+        return found != 0;
+    }
+
+    NPK_iter NPK_radix_iter_prefix_new(const NPK_radix *t, const NPK_string *prefix) {
+        NPK_iter it = NPK_iter_stage_(NPK_sizeof_type(NPK_radix_entry), NPK_radix_iter_next_, NULL);
+        const uint8_t *bytes = prefix->data;
+        int len = NPK_string_length(prefix);
+        uint32_t ref = t->root;
+        int depth = 0;
+
+        it.ctx = NPK_cast(void *, t);
+        it.buf = NPK_array_new(uint32_t);
+
+        // Finds the subtree of the keys that start with the prefix, comparing every path since the prefix can end inside one
+        while (ref != 0 && depth < len) {
+            if (NPK_radix_kind_(ref) == NPK_radix_leaf_kind_) {
+                NPK_radix_leaf_ *leaf = NPK_radix_leaf_at_(t, ref);
+
+                ref = leaf->len >= len && memcmp(NPK_radix_key_(t, leaf->key), bytes, len) == 0 ? ref : 0;
+
+                break;
+            }
+
+            NPK_radix_header_ *h = NPK_radix_header_at_(t, ref);
+            int shared = NPK_cast(int, h->prefix_len) < len - depth ? NPK_cast(int, h->prefix_len) : len - depth;
+
+            if (memcmp(NPK_radix_prefix_(t, h), bytes + depth, shared) != 0) {
+                ref = 0;
+
+                break;
+            }
+
+            depth += h->prefix_len;
+
+            if (depth >= len) {
+                break;
+            }
+
+            uint32_t *child = NPK_radix_child_(t, ref, bytes[depth]);
+
+            ref = child != NULL ? *child : 0;
+            depth++;
+        }
+
+        if (ref != 0) {
+            NPK_array_add(uint32_t, &it.buf, ref);
+        }
+
+        return it;
+    }
+
+    // A depth first walk whose stack is the buffer of the stage, the children are pushed last first so they come out in order
+    bool NPK_radix_iter_next_(NPK_iter *it, void *out) {
+        const NPK_radix *t = it->ctx;
+        NPK_array *stack = &it->buf;
+
+        while (NPK_array_is_empty(stack) == false) {
+            uint32_t ref = NPK_array_data(uint32_t, stack)[--stack->len];
+            uint8_t *node = NPK_radix_node_(t, ref);
+
+            switch (NPK_radix_kind_(ref)) {
+                case NPK_radix_leaf_kind_:
+                    NPK_radix_entry_(t, ref, out);
+
+                    return true;
+                case NPK_radix_node4_kind_: {
+                    NPK_radix_node4_ *n = NPK_cast(NPK_radix_node4_ *, node);
+
+                    NPK_count_down (i, n->h.count, 0) {
+                        NPK_array_add(uint32_t, stack, n->children[i]);
+                    }
+
+                    break;
+                }
+                case NPK_radix_node16_kind_: {
+                    NPK_radix_node16_ *n = NPK_cast(NPK_radix_node16_ *, node);
+
+                    NPK_count_down (i, n->h.count, 0) {
+                        NPK_array_add(uint32_t, stack, n->children[i]);
+                    }
+
+                    break;
+                }
+                case NPK_radix_node48_kind_: {
+                    NPK_radix_node48_ *n = NPK_cast(NPK_radix_node48_ *, node);
+
+                    NPK_count_down (b, 256, 0) {
+                        if (n->index[b] != 0) {
+                            NPK_array_add(uint32_t, stack, n->children[n->index[b] - 1]);
+                        }
+                    }
+
+                    break;
+                }
+                default: {
+                    NPK_radix_node256_ *n = NPK_cast(NPK_radix_node256_ *, node);
+
+                    NPK_count_down (b, 256, 0) {
+                        if (n->children[b] != 0) {
+                            NPK_array_add(uint32_t, stack, n->children[b]);
+                        }
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void NPK_radix_del(NPK_radix *t) {
+        NPK_count_up (i, 0, 5) {
+            NPK_array_del(t->pools + i);
+            NPK_array_del(t->free + i);
+        }
+
+        NPK_array_dim_del(&t->blocks, 2);
+    }
+
+    NPK_csv NPK_csv_empty_(const NPK_cstring *types) {
+        NPK_csv csv;
+
+        csv.rows = 0;
+        csv.cols = strlen(types);
+        csv.errors = 0;
+        csv.types = NPK_string_new(types);
+        csv.columns = NPK_array_sized_new(NPK_array, csv.cols > 0 ? csv.cols : 1);
+        csv.names = NPK_array_new(NPK_string);
+        csv.arena = NPK_array_new(char);
+
+        NPK_count_up (i, 0, csv.cols) {
+            switch (types[i]) {
+                case 'i': NPK_array_add(NPK_array, &csv.columns, NPK_array_new(int64_t)); break;
+                case 'd': NPK_array_add(NPK_array, &csv.columns, NPK_array_new(double)); break;
+                case 's': NPK_array_add(NPK_array, &csv.columns, NPK_array_new(NPK_string)); break;
+                default: NPK_array_add(NPK_array, &csv.columns, NPK_array_new(char)); break;
+            }
+        }
+
+        return csv;
+    }
+
+    // Finds the first delimiter or newline at or after "pos", or returns "end"
+    int64_t NPK_csv_next_(const char *data, int64_t pos, int64_t end, char delim) {
+        #if defined NPK_AVX2_
+            __m256i delims = _mm256_set1_epi8(delim);
+            __m256i newlines = _mm256_set1_epi8('\n');
+
+            for (; pos + 32 <= end; pos += 32) {
+                __m256i v = _mm256_loadu_si256(NPK_cast(const __m256i *, data + pos));
+                uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, delims), _mm256_cmpeq_epi8(v, newlines)));
+
+                if (mask != 0) {
+                    return pos + NPK_ctz64_(mask);
+                }
+            }
+        #elif defined NPK_SSE2_
+            __m128i delims = _mm_set1_epi8(delim);
+            __m128i newlines = _mm_set1_epi8('\n');
+
+            for (; pos + 16 <= end; pos += 16) {
+                __m128i v = _mm_loadu_si128(NPK_cast(const __m128i *, data + pos));
+                int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, delims), _mm_cmpeq_epi8(v, newlines)));
+
+                if (mask != 0) {
+                    return pos + NPK_ctz64_(mask);
+                }
+            }
+        #endif
+
+        while (pos < end && data[pos] != delim && data[pos] != '\n') {
+            pos++;
+        }
+
+        return pos;
+    }
+
+    // Returns the index right after the first newline at or after "pos" that isn't quoted, or "end"
+    // "quoted" tells if "pos" is inside a quoted field, which counting the quotes before it gives
+    int64_t NPK_csv_record_end_(const char *data, int64_t pos, int64_t end, bool quoted) {
+        while (pos < end) {
+            const char *newline = memchr(data + pos, '\n', end - pos);
+            int64_t stop = newline != NULL ? newline - data : end;
+            const char *quote = memchr(data + pos, '"', stop - pos);
+
+            // Every quote before the newline flips whether it is quoted
+            while (quote != NULL) {
+                quoted = !quoted;
+                quote = memchr(quote + 1, '"', data + stop - quote - 1);
+            }
+
+            if (quoted == false || stop == end) {
+                return stop < end ? stop + 1 : end;
+            }
+
+            pos = stop + 1;
+        }
+
+        return end;
+    }
+
+    // Until the arena stops growing, the data of every string view is its offset in the arena
+    void NPK_csv_field_(NPK_csv *csv, int col, const char *s, int len) {
+        NPK_array *column = NPK_array_data(NPK_array, &csv->columns) + col;
+
+        switch (NPK_string_data(&csv->types)[col]) {
+            case 'i': {
+                int64_t val = 0;
+                NPK_parse_result res = NPK_parse_int64_(s, len, &val);
+
+                if (res.error != NPK_parse_ok || res.end != len) {
+                    val = 0;
+                    csv->errors++;
+                }
+
+                NPK_array_add(int64_t, column, val);
+                break;
+            }
+            case 'd': {
+                double val = 0;
+                NPK_parse_result res = NPK_parse_real_(s, len, &val, false);
+
+                if (res.error != NPK_parse_ok || res.end != len) {
+                    val = 0;
+                    csv->errors++;
+                }
+
+                NPK_array_add(double, column, val);
+                break;
+            }
+            case 's': {
+                NPK_string view;
+
+                NPK_array_reserve_(1, &csv->arena, NPK_array_length(&csv->arena) + len + 1);
+                view.len = len + 1;
+                view.maxlen = len + 1;
+                view.data = NPK_cast(void *, NPK_cast(uintptr_t, NPK_array_length(&csv->arena)));
+                memcpy(NPK_array_data(char, &csv->arena) + NPK_array_length(&csv->arena), s, len);
+                NPK_array_data(char, &csv->arena)[NPK_array_length(&csv->arena) + len] = '\0';
+                csv->arena.len += len + 1;
+                NPK_array_add(NPK_string, column, view);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Parses the records in [begin, end), "begin" must be the start of a record
+    // Unquoted fields are read straight from "data", quoted ones only go through "scratch" when they contain a ""
+    void NPK_csv_parse_chunk_(NPK_csv *csv, const char *data, int64_t begin, int64_t end, char delim, NPK_string *scratch) {
+        int64_t pos = begin;
+        int col = 0;
+
+        while (pos < end) {
+            const char *field = data + pos;
+            int64_t stop;
+            int len;
+
+            if (col == 0 && (data[pos] == '\n' || (data[pos] == '\r' && pos + 1 < end && data[pos + 1] == '\n'))) {
+                pos += data[pos] == '\n' ? 1 : 2;
+
+                continue;
+            }
+
+            if (data[pos] == '"') {
+                int64_t from = pos + 1;
+                int64_t close = end;
+                bool escaped = false;
+
+                while (from < end) {
+                    const char *quote = memchr(data + from, '"', end - from);
+
+                    if (quote == NULL) {
+                        break;
+                    }
+
+                    if (quote + 1 < data + end && quote[1] == '"') {
+                        escaped = true;
+                        from = quote - data + 2;
+                    } else {
+                        close = quote - data;
+                        break;
+                    }
+                }
+
+                field = data + pos + 1;
+                len = close - pos - 1;
+
+                if (escaped) {
+                    scratch->len = 1;
+                    NPK_string_data(scratch)[0] = '\0';
+
+                    NPK_count_up (i, 0, len) {
+                        NPK_string_add(scratch, field[i]);
+                        i += field[i] == '"';
+                    }
+
+                    field = NPK_string_data(scratch);
+                    len = NPK_string_length(scratch);
+                }
+
+                // Anything between the closing quote and the delimiter is dropped
+                stop = NPK_csv_next_(data, close < end ? close + 1 : end, end, delim);
+            } else {
+                stop = NPK_csv_next_(data, pos, end, delim);
+                len = stop - pos;
+
+                if (len > 0 && field[len - 1] == '\r' && (stop == end || data[stop] == '\n')) {
+                    len--;
+                }
+            }
+
+            if (col < csv->cols) {
+                NPK_csv_field_(csv, col, field, len);
+            }
+
+            col++;
+            pos = stop + 1;
+
+            if (stop < end && data[stop] == delim) {
+                continue;
+            }
+
+            for (; col < csv->cols; col++) {
+                NPK_csv_field_(csv, col, "", 0);
+            }
+
+            csv->rows++;
+            col = 0;
+        }
+
+        // A delimiter right at the end still starts an empty last field, so the record is completed like a newline would
+        if (col > 0) {
+            for (; col < csv->cols; col++) {
+                NPK_csv_field_(csv, col, "", 0);
+            }
+
+            csv->rows++;
+        }
+    }
+
+    void NPK_csv_count_quotes_(void *ctx, int begin, int end) {
+        NPK_csv_task_ *task = ctx;
+
+        NPK_count_up (c, begin, end) {
+            const char *from = task->data + task->bounds[c];
+            const char *to = task->data + task->bounds[c + 1];
+            int count = 0;
+
+            for (const char *quote = memchr(from, '"', to - from); quote != NULL; quote = memchr(quote + 1, '"', to - quote - 1)) {
+                count++;
+            }
+
+            task->quotes[c] = count;
+        }
+    }
+
+    void NPK_csv_parse_part_(void *ctx, int begin, int end) {
+        NPK_csv_task_ *task = ctx;
+        NPK_string scratch = NPK_string_new("");
+
+        NPK_count_up (c, begin, end) {
+            task->parts[c] = NPK_csv_empty_(task->types);
+            NPK_csv_parse_chunk_(task->parts + c, task->data, task->bounds[c], task->bounds[c + 1], task->delim, &scratch);
+        }
+
+        NPK_string_del(&scratch);
+    }
+
+    // Appends the rows of "part", whose string views still hold offsets into its own arena
+    void NPK_csv_append_(NPK_csv *csv, const NPK_csv *part) {
+        int64_t base = NPK_array_length(&csv->arena);
+
+        NPK_count_up (col, 0, csv->cols) {
+            NPK_array *column = NPK_array_data(NPK_array, &csv->columns) + col;
+            const NPK_array *from = NPK_array_data(NPK_array, &part->columns) + col;
+            int size = NPK_string_data(&csv->types)[col] == 's' ? NPK_sizeof_type(NPK_string) : 8;
+            int len = NPK_array_length(column);
+
+            if (NPK_array_is_empty(from)) {
+                continue;
+            }
+
+            NPK_array_reserve_(size, column, len + NPK_array_length(from));
+            memcpy(NPK_array_data(uint8_t, column) + NPK_cast(size_t, len) * size, from->data, NPK_cast(size_t, NPK_array_length(from)) * size);
+            column->len += NPK_array_length(from);
+
+            if (NPK_string_data(&csv->types)[col] == 's') {
+                NPK_count_up (i, len, NPK_array_length(column)) {
+                    NPK_string *view = NPK_array_data(NPK_string, column) + i;
+
+                    view->data = NPK_cast(void *, NPK_cast(uintptr_t, view->data) + base);
+                }
+            }
+        }
+
+        NPK_array_reserve_(1, &csv->arena, NPK_array_length(&csv->arena) + NPK_array_length(&part->arena));
+        memcpy(NPK_array_data(char, &csv->arena) + NPK_array_length(&csv->arena), part->arena.data, NPK_array_length(&part->arena));
+        csv->arena.len += NPK_array_length(&part->arena);
+        csv->rows += part->rows;
+        csv->errors += part->errors;
+    }
+
+    NPK_csv NPK_csv_parse_new(const char *data, int64_t len, const NPK_cstring *types, char delim, bool header, NPK_pool *pool) {
+        NPK_csv csv = NPK_csv_empty_(types);
+        NPK_string scratch = NPK_string_new("");
+        int64_t begin = 0;
+
+        if (header) {
+            NPK_string all = NPK_string_sized_new(csv.cols + 1);
+            NPK_csv names;
+
+            NPK_count_up (i, 0, csv.cols) {
+                NPK_string_add(&all, 's');
+            }
+
+            names = NPK_csv_empty_(NPK_string_data(&all));
+            begin = NPK_csv_record_end_(data, 0, len, false);
+            NPK_csv_parse_chunk_(&names, data, 0, begin, delim, &scratch);
+
+            NPK_count_up (i, 0, csv.cols) {
+                NPK_string *view = NPK_csv_column(NPK_string, &names, i);
+                NPK_string name = NPK_string_new("");
+
+                if (names.rows > 0) {
+                    NPK_string_append_n_(&name, NPK_array_data(char, &names.arena) + NPK_cast(uintptr_t, view->data), NPK_string_length(view));
+                }
+
+                NPK_array_add(NPK_string, &csv.names, name);
+            }
+
+            NPK_csv_del(&names);
+            NPK_string_del(&all);
+        }
+
+        int chunks = (len - begin) / NPK_csv_chunk_;
+
+        chunks = pool != NULL && pool->threads > 1 ? (chunks < 8 * pool->threads ? chunks : 8 * pool->threads) : 1;
+
+        if (chunks <= 1) {
+            NPK_csv_parse_chunk_(&csv, data, begin, len, delim, &scratch);
+        } else {
+            // The quotes before a chunk tell if it starts inside a quoted field, so every chunk can find its first record
+            NPK_csv_task_ task = {data, len, types, delim, malloc((chunks + 1) * sizeof(int64_t)), malloc(chunks * sizeof(int)), malloc(chunks * sizeof(NPK_csv))};
+            int quotes = 0;
+
+            NPK_count_up (c, 0, chunks + 1) {
+                task.bounds[c] = begin + (len - begin) * c / chunks;
+            }
+
+            NPK_pool_run(pool, chunks, 1, NPK_csv_count_quotes_, &task);
+
+            NPK_count_up (c, 1, chunks) {
+                int64_t start = task.bounds[c];
+
+                quotes += task.quotes[c - 1];
+                task.bounds[c] = NPK_csv_record_end_(data, start, len, quotes % 2 == 1);
+            }
+
+            // A chunk that sits inside one long record ends up empty
+            NPK_count_up (c, 1, chunks) {
+                task.bounds[c] = task.bounds[c] > task.bounds[c - 1] ? task.bounds[c] : task.bounds[c - 1];
+            }
+
+            NPK_pool_run(pool, chunks, 1, NPK_csv_parse_part_, &task);
+
+            NPK_count_up (c, 0, chunks) {
+                NPK_csv_append_(&csv, task.parts + c);
+                NPK_csv_del(task.parts + c);
+            }
+
+            free(task.bounds);
+            free(task.quotes);
+            free(task.parts);
+        }
+
+        // The arena is complete, so the offsets of the string views become pointers
+        NPK_count_up (col, 0, csv.cols) {
+            if (types[col] == 's') {
+                NPK_for_each (NPK_string, view, NPK_array_data(NPK_array, &csv.columns) + col) {
+                    view->data = NPK_array_data(char, &csv.arena) + NPK_cast(uintptr_t, view->data);
+                }
+            }
+        }
+
+        NPK_string_del(&scratch);
+
+        return csv;
+    }
+
+    NPK_csv NPK_csv_read_new(const NPK_cstring *path, const NPK_cstring *types, char delim, bool header, NPK_pool *pool) {
+        #if defined NPK_POSIX_
+            struct stat st;
+            int fd = open(path, O_RDONLY);
+
+            if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+
+                return NPK_csv_empty_(types);
+            }
+
+            // The parse reads every page once, in order within each chunk
+            void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            close(fd);
+
+            if (data == MAP_FAILED) {
+                return NPK_csv_empty_(types);
+            }
+
+            NPK_csv csv = NPK_csv_parse_new(data, st.st_size, types, delim, header, pool);
+
+            munmap(data, st.st_size);
+
+            return csv;
+        #else
+            FILE *f = fopen(path, "rb");
+            long bytes;
+
+            if (f == NULL) {
+                return NPK_csv_empty_(types);
+            }
+
+            if (fseek(f, 0, SEEK_END) != 0 || (bytes = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET) != 0) {
+                fclose(f);
+
+                return NPK_csv_empty_(types);
+            }
+
+            char *data = malloc(bytes);
+            NPK_csv csv = fread(data, 1, bytes, f) == NPK_cast(size_t, bytes) ? NPK_csv_parse_new(data, bytes, types, delim, header, pool) : NPK_csv_empty_(types);
+
+            free(data);
+            fclose(f);
+
+            return csv;
+        #endif
+    }
+
+    void NPK_csv_del(NPK_csv *csv) {
+        NPK_array_dim_del(&csv->columns, 2);
+        NPK_array_dim_del(&csv->names, 2);
+        NPK_array_del(&csv->arena);
+        NPK_string_del(&csv->types);
+    }
+
+    bool NPK_uchar_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned char *, p1) == *NPK_cast(const unsigned char *, p2); }
+    bool NPK_ushrt_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned short *, p1) == *NPK_cast(const unsigned short *, p2); }
+    bool NPK_uint_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned int *, p1) == *NPK_cast(const unsigned int *, p2); }
+    bool NPK_ulong_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned long *, p1) == *NPK_cast(const unsigned long *, p2); }
+    bool NPK_ullong_equals(const void *p1, const void *p2) { return *NPK_cast(const unsigned long long *, p1) == *NPK_cast(const unsigned long long *, p2); }
+
+    bool NPK_schar_equals(const void *p1, const void *p2) { return *NPK_cast(const signed char *, p1) == *NPK_cast(const signed char *, p2); }
+    bool NPK_shrt_equals(const void *p1, const void *p2) { return *NPK_cast(const short *, p1) == *NPK_cast(const short *, p2); }
+    bool NPK_int_equals(const void *p1, const void *p2) { return *NPK_cast(const int *, p1) == *NPK_cast(const int *, p2); }
+    bool NPK_long_equals(const void *p1, const void *p2) { return *NPK_cast(const long *, p1) == *NPK_cast(const long *, p2); }
+    bool NPK_llong_equals(const void *p1, const void *p2) { return *NPK_cast(const long long *, p1) == *NPK_cast(const long long *, p2); }
+
+    bool NPK_bool_equals(const void *p1, const void *p2) { return *NPK_cast(const bool *, p1) == *NPK_cast(const bool *, p2); }
+    bool NPK_char_equals(const void *p1, const void *p2) { return *NPK_cast(const char *, p1) == *NPK_cast(const char *, p2); }
+    bool NPK_flt_equals(const void *p1, const void *p2) { return fabsf(*NPK_cast(const float *, p1) - *NPK_cast(const float *, p2)) < FLT_EPSILON; }
+    bool NPK_dbl_equals(const void *p1, const void *p2) { return fabs(*NPK_cast(const double *, p1) - *NPK_cast(const double *, p2)) < DBL_EPSILON; }
+    bool NPK_ldbl_equals(const void *p1, const void *p2) { return fabsl(*NPK_cast(const long double *, p1) - *NPK_cast(const long double *, p2)) < LDBL_EPSILON; }
+
+    bool NPK_uint8_equals(const void *p1, const void *p2) { return *NPK_cast(const uint8_t *, p1) == *NPK_cast(const uint8_t *, p2); }
+    bool NPK_uint16_equals(const void *p1, const void *p2) { return *NPK_cast(const uint16_t *, p1) == *NPK_cast(const uint16_t *, p2); }
+    bool NPK_uint32_equals(const void *p1, const void *p2) { return *NPK_cast(const uint32_t *, p1) == *NPK_cast(const uint32_t *, p2); }
+    bool NPK_uint64_equals(const void *p1, const void *p2) { return *NPK_cast(const uint64_t *, p1) == *NPK_cast(const uint64_t *, p2); }
+
+    bool NPK_int8_equals(const void *p1, const void *p2) { return *NPK_cast(const int8_t *, p1) == *NPK_cast(const int8_t *, p2); }
+    bool NPK_int16_equals(const void *p1, const void *p2) { return *NPK_cast(const int16_t *, p1) == *NPK_cast(const int16_t *, p2); }
+    bool NPK_int32_equals(const void *p1, const void *p2) { return *NPK_cast(const int32_t *, p1) == *NPK_cast(const int32_t *, p2); }
+    bool NPK_int64_equals(const void *p1, const void *p2) { return *NPK_cast(const int64_t *, p1) == *NPK_cast(const int64_t *, p2); }
+
+    #define compare(type, name, order, val)                     \
+    int NPK_##name##_##order(const void *p1, const void *p2) {  \
+        const type *elem1 = p1;                                 \
+        const type *elem2 = p2;                                 \
+                                                                \
+        if (NPK_##name##_equals(elem1, elem2)) {                \
+            return 0;                                           \
+        } else if (*elem1 > *elem2) {                           \
+            return val;                                         \
+        } else {                                                \
+            return -val;                                        \
+        }                                                       \
+    }
+
+    compare(unsigned char, uchar, asc, 1)
+    compare(unsigned short, ushrt, asc, 1)
+    compare(unsigned int, uint, asc, 1)
+    compare(unsigned long, ulong, asc, 1)
+    compare(unsigned long long, ullong, asc, 1)
+
+    compare(signed char, schar, asc, 1)
+    compare(short, shrt, asc, 1)
+    compare(int, int, asc, 1)
+    compare(long, long, asc, 1)
+    compare(long long, llong, asc, 1)
+
+    compare(bool, bool, asc, 1)
+    compare(char, char, asc, 1)
+    compare(float, flt, asc, 1)
+    compare(double, dbl, asc, 1)
+    compare(long double, ldbl, asc, 1)
+
+    compare(uint8_t, uint8, asc, 1)
+    compare(uint16_t, uint16, asc, 1)
+    compare(uint32_t, uint32, asc, 1)
+    compare(uint64_t, uint64, asc, 1)
+
+    compare(int8_t, int8, asc, 1)
+    compare(int16_t, int16, asc, 1)
+    compare(int32_t, int32, asc, 1)
+    compare(int64_t, int64, asc, 1)
+
+    compare(unsigned char, uchar, desc, -1)
+    compare(unsigned short, ushrt, desc, -1)
+    compare(unsigned int, uint, desc, -1)
+    compare(unsigned long, ulong, desc, -1)
+    compare(unsigned long long, ullong, desc, -1)
+
+    compare(signed char, schar, desc, -1)
+    compare(short, shrt, desc, -1)
+    compare(int, int, desc, -1)
+    compare(long, long, desc, -1)
+    compare(long long, llong, desc, -1)
+
+    compare(bool, bool, desc, -1)
+    compare(char, char, desc, -1)
+    compare(float, flt, desc, -1)
+    compare(double, dbl, desc, -1)
+    compare(long double, ldbl, desc, -1)
+
+    compare(uint8_t, uint8, desc, -1)
+    compare(uint16_t, uint16, desc, -1)
+    compare(uint32_t, uint32, desc, -1)
+    compare(uint64_t, uint64, desc, -1)
+
+    compare(int8_t, int8, desc, -1)
+    compare(int16_t, int16, desc, -1)
+    compare(int32_t, int32, desc, -1)
+    compare(int64_t, int64, desc, -1)
+
+    #undef compare
+
+    int NPK_format_uint64_(char *buf, uint64_t val) {
+        const char *pairs = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                            "8081828384858687888990919293949596979899";
+        char tmp[20];
+        int i = NPK_cast(int, sizeof tmp);
+
+        // Two digits per division halves the number of divisions
+        while (val >= 100) {
+            i -= 2;
+            memcpy(tmp + i, pairs + (val % 100) * 2, 2);
+            val /= 100;
+        }
+
+        if (val >= 10) {
+            i -= 2;
+            memcpy(tmp + i, pairs + val * 2, 2);
+        } else {
+            tmp[--i] = '0' + val;
+        }
+
+        memcpy(buf, tmp + i, sizeof tmp - i);
+
+        return sizeof tmp - i;
+    }
+
+    int NPK_format_int64_(char *buf, int64_t val) {
+        if (val < 0) {
+            *buf = '-';
+
+            return NPK_format_uint64_(buf + 1, 0 - NPK_cast(uint64_t, val)) + 1;
+        } else {
+            return NPK_format_uint64_(buf, val);
+        }
+    }
+
+    void NPK_bignum_set_(NPK_bignum_ *b, uint64_t val) {
+        b->words[0] = NPK_cast(uint32_t, val);
+        b->words[1] = NPK_cast(uint32_t, val >> 32);
+        b->len = b->words[1] != 0 ? 2 : 1;
+    }
+
+    void NPK_bignum_mul_(NPK_bignum_ *b, uint32_t val) {
+        uint64_t carry = 0;
+
+        NPK_count_up (i, 0, b->len) {
+            carry += NPK_cast(uint64_t, b->words[i]) * val;
+            b->words[i] = NPK_cast(uint32_t, carry);
+            carry >>= 32;
+        }
+
+        if (carry != 0) {
+            b->words[b->len++] = NPK_cast(uint32_t, carry);
+        }
+    }
+
+    void NPK_bignum_mul_pow10_(NPK_bignum_ *b, int exp) {
+        for (; exp >= 9; exp -= 9) {
+            NPK_bignum_mul_(b, 1000000000);
+        }
+
+        for (; exp > 0; exp--) {
+            NPK_bignum_mul_(b, 10);
+        }
+    }
+
+    void NPK_bignum_shl_(NPK_bignum_ *b, int bits) {
+        int words = bits / 32;
+        int shift = bits % 32;
+
+        if (shift != 0) {
+            b->words[b->len] = 0;
+
+            NPK_count_down (i, b->len + 1, 1) {
+                b->words[i] = (b->words[i] << shift) | (b->words[i - 1] >> (32 - shift));
+            }
+
+            b->words[0] <<= shift;
+            b->len += b->words[b->len] != 0;
+        }
+
+        if (words != 0) {
+            memmove(b->words + words, b->words, b->len * NPK_sizeof_type(uint32_t));
+            memset(b->words, 0, words * NPK_sizeof_type(uint32_t));
+            b->len += words;
+        }
+    }
+
+    void NPK_bignum_add_(NPK_bignum_ *b1, const NPK_bignum_ *b2) {
+        uint64_t carry = 0;
+        int len = b1->len > b2->len ? b1->len : b2->len;
+
+        NPK_count_up (i, 0, len) {
+            carry += NPK_cast(uint64_t, i < b1->len ? b1->words[i] : 0) + (i < b2->len ? b2->words[i] : 0);
+            b1->words[i] = NPK_cast(uint32_t, carry);
+            carry >>= 32;
+        }
+
+        b1->len = len;
+
+        if (carry != 0) {
+            b1->words[b1->len++] = NPK_cast(uint32_t, carry);
+        }
+    }
+
+    // Expects "b1" to be bigger or equal to "b2"
+    void NPK_bignum_sub_(NPK_bignum_ *b1, const NPK_bignum_ *b2) {
+        int64_t borrow = 0;
+
+        NPK_count_up (i, 0, b1->len) {
+            borrow += NPK_cast(int64_t, b1->words[i]) - (i < b2->len ? b2->words[i] : 0);
+            b1->words[i] = NPK_cast(uint32_t, borrow);
+            borrow = borrow < 0 ? -1 : 0;
+        }
+
+        while (b1->len > 1 && b1->words[b1->len - 1] == 0) {
+            b1->len--;
+        }
+    }
+
+    int NPK_bignum_compare_(const NPK_bignum_ *b1, const NPK_bignum_ *b2) {
+        if (b1->len != b2->len) {
+            return b1->len > b2->len ? 1 : -1;
+        }
+
+        NPK_count_down (i, b1->len, 0) {
+            if (b1->words[i] != b2->words[i]) {
+                return b1->words[i] > b2->words[i] ? 1 : -1;
+            }
+        }
+
+        return 0;
+    }
+
+    // Writes the shortest digits that read back as "val" (which must be positive and finite)
+    // The value equals 0.digits times 10 to the power of "point", the number of digits is returned
+    int NPK_format_dbl_digits_(char *digits, double val, int *point) {
+        const double max_exact = 9007199254740992.0;
+        int len;
+
+        // Fast path, "m / p" and parsing the digits of "m" followed by the point are both correctly rounded divisions
+        // So the first power of ten that gives an exact quotient provides the fewest fractional digits
+        if (val < max_exact) {
+            double p = 1;
+
+            NPK_count_up (k, 0, 23) {
+                double hi = val * p;
+                double m = floor(hi + 0.5);
+                double best = 0;
+
+                if (m > max_exact) {
+                    break;
+                }
+
+                // Two neighbouring candidates can both read back as "val", then the one nearest to the exact product wins
+                // and ties go to even, fma gives the rounding error of "hi" so the sign of "past_half" is exact
+                NPK_count_up (j, -1, 2) {
+                    double c = m + j;
+
+                    if (c > 0 && c <= max_exact && c / p == val) {
+                        double past_half = best > 0 ? (hi - best - 0.5) + fma(val, p, -hi) : 1;
+
+                        if (past_half > 0 || (past_half == 0 && fmod(c, 2) == 0)) {
+                            best = c;
+                        }
+                    }
+                }
+
+                if (best > 0) {
+                    len = NPK_format_uint64_(digits, NPK_cast(uint64_t, best));
+                    *point = len - k;
+
+                    while (digits[len - 1] == '0') {
+                        len--;
+                    }
+
+                    return len;
+                }
+
+                p *= 10;
+            }
+        }
+
+        // Otherwise the free-format algorithm of Steele & White, Burger & Dybvig is run on exact integers
+        // The value is "r / s", while "mminus / s" and "mplus / s" are the distances to its neighbours
+        NPK_bignum_ r;
+        NPK_bignum_ s;
+        NPK_bignum_ mminus;
+        NPK_bignum_ mplus_uneven;
+        NPK_bignum_ tmp;
+        int exp;
+        uint64_t f = NPK_cast(uint64_t, frexp(val, &exp) * max_exact);
+
+        exp -= 53;
+
+        // Subnormal numbers have fewer significant bits, their gap is always the smallest one
+        if (exp < -1074) {
+            f >>= -1074 - exp;
+            exp = -1074;
+        }
+
+        bool even = f % 2 == 0;
+        bool uneven = f == (UINT64_C(1) << 52) && exp > -1074;
+
+        NPK_bignum_set_(&r, f);
+        NPK_bignum_set_(&s, 1);
+        NPK_bignum_set_(&mminus, 1);
+
+        if (exp >= 0) {
+            NPK_bignum_shl_(&r, exp + 1 + uneven);
+            NPK_bignum_shl_(&s, 1 + uneven);
+            NPK_bignum_shl_(&mminus, exp);
+        } else {
+            NPK_bignum_shl_(&r, 1 + uneven);
+            NPK_bignum_shl_(&s, 1 - exp + uneven);
+        }
+
+        // Both distances are the same, unless "val" is a power of two
+        NPK_bignum_ *mplus = uneven ? &mplus_uneven : &mminus;
+
+        if (uneven) {
+            mplus_uneven = mminus;
+            NPK_bignum_shl_(&mplus_uneven, 1);
+        }
+
+        // The estimate is never too big, and the fixup below catches when it is too small by one
+        int k = ceil(log10(val) - 1e-10);
+
+        if (k >= 0) {
+            NPK_bignum_mul_pow10_(&s, k);
+        } else {
+            NPK_bignum_mul_pow10_(&r, -k);
+            NPK_bignum_mul_pow10_(&mminus, -k);
+
+            if (uneven) {
+                NPK_bignum_mul_pow10_(mplus, -k);
+            }
+        }
+
+        tmp = r;
+        NPK_bignum_add_(&tmp, mplus);
+
+        if (NPK_bignum_compare_(&tmp, &s) >= !even) {
+            NPK_bignum_mul_(&s, 10);
+            k++;
+        }
+
+        *point = k;
+        len = 0;
+
+        while (true) {
+            int d = 0;
+
+            NPK_bignum_mul_(&r, 10);
+            NPK_bignum_mul_(&mminus, 10);
+
+            if (uneven) {
+                NPK_bignum_mul_(mplus, 10);
+            }
+
+            while (NPK_bignum_compare_(&r, &s) >= 0) {
+                NPK_bignum_sub_(&r, &s);
+                d++;
+            }
+
+            tmp = r;
+            NPK_bignum_add_(&tmp, mplus);
+
+            bool low = NPK_bignum_compare_(&r, &mminus) < even;
+            bool high = NPK_bignum_compare_(&tmp, &s) >= !even;
+
+            if (low == false && high == false) {
+                digits[len++] = '0' + d;
+            } else {
+                // Both last digits read back as "val", so the nearer one is taken and ties go to even
+                if (low && high) {
+                    tmp = r;
+                    NPK_bignum_shl_(&tmp, 1);
+
+                    int cmp = NPK_bignum_compare_(&tmp, &s);
+
+                    high = cmp > 0 || (cmp == 0 && d % 2 == 1);
+                }
+
+                digits[len++] = '0' + d + high;
+
+                return len;
+            }
+        }
+    }
+
+    int NPK_format_dbl_(char *buf, double val) {
+        char digits[24];
+        int point;
+        int len = 0;
+
+        if (isnan(val)) {
+            memcpy(buf, "nan", 3);
+
+            return 3;
+        }
+
+        if (signbit(val)) {
+            buf[len++] = '-';
+            val = -val;
+        }
+
+        if (isinf(val)) {
+            memcpy(buf + len, "inf", 3);
+
+            return len + 3;
+        } else if (val == 0) {
+            buf[len++] = '0';
+
+            return len;
+        }
+
+        int n = NPK_format_dbl_digits_(digits, val, &point);
+        int exp = point - 1;
+
+        // Plain notation is used for a reasonable range, the same range JavaScript uses
+        if (exp >= -6 && exp < 21) {
+            if (point <= 0) {
+                memcpy(buf + len, "0.", 2);
+                memset(buf + len + 2, '0', -point);
+                memcpy(buf + len + 2 - point, digits, n);
+                len += 2 - point + n;
+            } else if (point >= n) {
+                memcpy(buf + len, digits, n);
+                memset(buf + len + n, '0', point - n);
+                len += point;
+            } else {
+                memcpy(buf + len, digits, point);
+                buf[len + point] = '.';
+                memcpy(buf + len + point + 1, digits + point, n - point);
+                len += n + 1;
+            }
+        } else {
+            buf[len++] = digits[0];
+
+            if (n > 1) {
+                buf[len++] = '.';
+                memcpy(buf + len, digits + 1, n - 1);
+                len += n - 1;
+            }
+
+            buf[len++] = 'e';
+            buf[len++] = exp < 0 ? '-' : '+';
+            len += NPK_format_uint64_(buf + len, exp < 0 ? -exp : exp);
+        }
+
+        return len;
+    }
+
+    void NPK_string_append_int64(NPK_string *str, int64_t val) {
+        char buf[20];
+
+        NPK_string_append_n_(str, buf, NPK_format_int64_(buf, val));
+    }
+
+    void NPK_string_append_uint64(NPK_string *str, uint64_t val) {
+        char buf[20];
+
+        NPK_string_append_n_(str, buf, NPK_format_uint64_(buf, val));
+    }
+
+    void NPK_string_append_dbl(NPK_string *str, double val) {
+        char buf[NPK_format_dbl_maxlen_];
+
+        NPK_string_append_n_(str, buf, NPK_format_dbl_(buf, val));
+    }
+
+    // The string is allocated exactly once, with the exact length it needs
+    #define to_string(type, name, format)                   \
+    NPK_string NPK_##name##_to_string_new(type val) {       \
+        char buf[NPK_format_dbl_maxlen_];                   \
+        int len = format(buf, val);                         \
+        NPK_array arr = NPK_array_sized_new(char, len +1);  \
+                                                            \
+        memcpy(arr.data, buf, len);                         \
+        NPK_string_data(&arr)[len] = '\0';                  \
+        arr.len = len +1;                                   \
+                                                            \
+        return arr;                                         \
+    }
+
+    to_string(unsigned char, uchar, NPK_format_uint64_)
+    to_string(unsigned short, ushrt, NPK_format_uint64_)
+    to_string(unsigned int, uint, NPK_format_uint64_)
+    to_string(unsigned long, ulong, NPK_format_uint64_)
+    to_string(unsigned long long, ullong, NPK_format_uint64_)
+
+    to_string(signed char, schar, NPK_format_int64_)
+    to_string(short, shrt, NPK_format_int64_)
+    to_string(int, int, NPK_format_int64_)
+    to_string(long, long, NPK_format_int64_)
+    to_string(long long, llong, NPK_format_int64_)
+
+    to_string(double, dbl, NPK_format_dbl_)
+
+    to_string(uint8_t, uint8, NPK_format_uint64_)
+    to_string(uint16_t, uint16, NPK_format_uint64_)
+    to_string(uint32_t, uint32, NPK_format_uint64_)
+    to_string(uint64_t, uint64, NPK_format_uint64_)
+
+    to_string(int8_t, int8, NPK_format_int64_)
+    to_string(int16_t, int16, NPK_format_int64_)
+    to_string(int32_t, int32, NPK_format_int64_)
+    to_string(int64_t, int64, NPK_format_int64_)
+
+    #undef to_string
+
+    // Long doubles are rare enough to leave them to the C library, with enough digits to read back the same value
+    NPK_string NPK_ldbl_to_string_new(long double val) {
+        char buf[64];
+
+        // LDBL_DECIMAL_DIG came with C11, three digits past LDBL_DIG are enough for every long double format
+        #if defined LDBL_DECIMAL_DIG
+            int len = snprintf(buf, sizeof buf, "%.*Lg", LDBL_DECIMAL_DIG, val);
+        #else
+            int len = snprintf(buf, sizeof buf, "%.*Lg", LDBL_DIG + 3, val);
+        #endif
+
+        NPK_array arr = NPK_array_sized_new(char, len +1);
+
+        memcpy(arr.data, buf, len +1);
+        arr.len = len +1;
+
+        return arr;
+    }
+
+    uint32_t NPK_parse_eight_digits_(uint64_t w) {
+        w -= swar_ones * '0';
+        w = (w * 10) + (w >> 8);
+        w = (((w & UINT64_C(0x000000FF000000FF)) * UINT64_C(0x000F424000000064)) + (((w >> 16) & UINT64_C(0x000000FF000000FF)) * UINT64_C(0x0000271000000001))) >> 32;
+
+        return NPK_cast(uint32_t, w);
+    }
+
+    NPK_parse_result NPK_parse_integer_(const char *s, int len, uint64_t *mag, bool *negative) {
+        NPK_parse_result res = {NPK_parse_invalid, 0};
+        uint64_t val = 0;
+        int i = 0;
+
+        while (i < len && NPK_char_is_blank(s[i])) {
+            i++;
+        }
+
+        *negative = false;
+
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            *negative = s[i] == '-';
+            i++;
+        }
+
+        if (i == len || NPK_char_is_digit(s[i]) == false) {
+            return res;
+        }
+
+        while (i < len && s[i] == '0') {
+            i++;
+        }
+
+        res.error = NPK_parse_ok;
+
+        // At most 16 digits go through SWAR, they can never overflow
+        #if defined NPK_LITTLE_ENDIAN_
+            int first = i;
+            uint64_t w;
+
+            while (i + 8 <= len && i - first <= 8) {
+                memcpy(&w, s + i, 8);
+
+                if (swar_in_range(w, '0', '9') != swar_high) {
+                    break;
+                }
+
+                val = val * 100000000 + NPK_parse_eight_digits_(w);
+                i += 8;
+            }
+        #endif
+
+        for (; i < len && NPK_char_is_digit(s[i]); i++) {
+            unsigned int d = s[i] - '0';
+
+            if (val > (UINT64_MAX - d) / 10) {
+                res.error = NPK_parse_overflow;
+            } else if (res.error == NPK_parse_ok) {
+                val = val * 10 + d;
+            }
+        }
+
+        *mag = res.error == NPK_parse_ok ? val : UINT64_MAX;
+        res.end = i;
+
+        return res;
+    }
+
+    NPK_parse_result NPK_parse_int64_(const char *s, int len, int64_t *val) {
+        uint64_t mag;
+        bool negative;
+        NPK_parse_result res = NPK_parse_integer_(s, len, &mag, &negative);
+
+        if (res.error == NPK_parse_invalid) {
+            return res;
+        }
+
+        if (negative) {
+            if (mag > NPK_cast(uint64_t, INT64_MAX) + 1) {
+                res.error = NPK_parse_overflow;
+                *val = INT64_MIN;
+            } else {
+                *val = mag == NPK_cast(uint64_t, INT64_MAX) + 1 ? INT64_MIN : -NPK_cast(int64_t, mag);
+            }
+        } else {
+            if (mag > INT64_MAX) {
+                res.error = NPK_parse_overflow;
+                *val = INT64_MAX;
+            } else {
+                *val = mag;
+            }
+        }
+
+        return res;
+    }
+
+    NPK_parse_result NPK_parse_uint64_(const char *s, int len, uint64_t *val) {
+        uint64_t mag;
+        bool negative;
+        NPK_parse_result res = NPK_parse_integer_(s, len, &mag, &negative);
+
+        if (res.error == NPK_parse_invalid) {
+            return res;
+        }
+
+        if (negative && mag != 0) {
+            res.error = NPK_parse_overflow;
+            *val = 0;
+        } else {
+            *val = mag;
+        }
+
+        return res;
+    }
+
+    // Multiplies the number by 2^bits, or divides it by 2^-bits, at most 60 bits at a time so a digit shifted by
+    // that much plus the carry still fits in 64 bits
+    void NPK_decimal_shift_(NPK_decimal_ *d, int bits) {
+        int maxlen = NPK_cast(int, sizeof d->digits);
+
+        while (bits != 0 && d->len > 0) {
+            int step = bits > 60 ? 60 : bits < -60 ? -60 : bits;
+            uint64_t n = 0;
+
+            bits -= step;
+
+            if (step > 0) {
+                int extra = 0;
+
+                // A first pass measures the carry out of the leading digit, then the digits are written from the back
+                NPK_count_down (r, d->len, 0) {
+                    n = (n + (NPK_cast(uint64_t, d->digits[r]) << step)) / 10;
+                }
+
+                for (; n > 0; n /= 10) {
+                    extra++;
+                }
+
+                int w = d->len + extra;
+
+                NPK_count_down (r, d->len, 0) {
+                    n += NPK_cast(uint64_t, d->digits[r]) << step;
+                    w--;
+
+                    if (w < maxlen) {
+                        d->digits[w] = n % 10;
+                    } else {
+                        d->truncated |= n % 10 != 0;
+                    }
+
+                    n /= 10;
+                }
+
+                for (; n > 0; n /= 10) {
+                    d->digits[--w] = n % 10;
+                }
+
+                d->len = d->len + extra < maxlen ? d->len + extra : maxlen;
+                d->point += extra;
+            } else {
+                uint64_t mask = (UINT64_C(1) << -step) - 1;
+                int r = 0;
+                int w = 0;
+
+                // Enough leading digits are gathered to cover the first quotient digit
+                for (; (n >> -step) == 0; r++) {
+                    if (r >= d->len) {
+                        for (; (n >> -step) == 0; r++) {
+                            n *= 10;
+                        }
+
+                        break;
+                    }
+
+                    n = n * 10 + d->digits[r];
+                }
+
+                d->point -= r - 1;
+
+                for (; r < d->len; r++) {
+                    d->digits[w++] = n >> -step;
+                    n = (n & mask) * 10 + d->digits[r];
+                }
+
+                for (; n > 0; n = (n & mask) * 10) {
+                    if (w < maxlen) {
+                        d->digits[w++] = n >> -step;
+                    } else {
+                        d->truncated |= (n >> -step) != 0;
+                    }
+                }
+
+                d->len = w;
+            }
+
+            while (d->len > 0 && d->digits[d->len - 1] == 0) {
+                d->len--;
+            }
+        }
+    }
+
+    // Checks if the number rounds up to an integer at the "nd"th digit, with ties going to even
+    bool NPK_decimal_round_up_(const NPK_decimal_ *d, int nd) {
+        if (nd < 0 || nd >= d->len) {
+            return false;
+        }
+
+        // A dropped nonzero digit puts an apparent tie just above halfway
+        if (d->digits[nd] == 5 && nd + 1 == d->len) {
+            return d->truncated || (nd > 0 && d->digits[nd - 1] % 2 == 1);
+        }
+
+        return d->digits[nd] >= 5;
+    }
+
+    // Converts the decimal number in "s" to the nearest binary number with "mant_dig" bits of mantissa and the exponent
+    // range of <float.h>, the digits are scaled by powers of two until exactly the bits of the mantissa are left of the
+    // decimal point, which works for any number of digits and never consults the locale
+    long double NPK_parse_decimal_(const char *s, int len, int mant_dig, int min_exp, int max_exp) {
+        static const int shifts[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+        NPK_decimal_ d;
+        bool negative = false;
+        bool dot = false;
+        int exp2 = 0;
+        int i = 0;
+
+        d.len = 0;
+        d.point = 0;
+        d.truncated = false;
+
+        while (i < len && NPK_char_is_blank(s[i])) {
+            i++;
+        }
+
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            negative = s[i] == '-';
+            i++;
+        }
+
+        for (; i < len && (NPK_char_is_digit(s[i]) || (s[i] == '.' && dot == false)); i++) {
+            if (s[i] == '.') {
+                dot = true;
+            } else if (d.len == 0 && s[i] == '0') {
+                d.point -= dot;
+            } else {
+                d.point += !dot;
+
+                if (d.len < NPK_cast(int, sizeof d.digits)) {
+                    d.digits[d.len++] = s[i] - '0';
+                } else {
+                    d.truncated |= s[i] != '0';
+                }
+            }
+        }
+
+        if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+            bool eneg = false;
+            int e = 0;
+
+            i++;
+
+            if (i < len && (s[i] == '+' || s[i] == '-')) {
+                eneg = s[i] == '-';
+                i++;
+            }
+
+            for (; i < len && NPK_char_is_digit(s[i]); i++) {
+                if (e < 100000) {
+                    e = e * 10 + (s[i] - '0');
+                }
+            }
+
+            d.point += eneg ? -e : e;
+        }
+
+        while (d.len > 0 && d.digits[d.len - 1] == 0) {
+            d.len--;
+        }
+
+        // Numbers far below half the smallest subnormal or far above the largest finite number need no scaling
+        if (d.len == 0 || d.point < (min_exp - mant_dig - 1) * 31 / 100 - 1) {
+            return negative ? -0.0L : 0.0L;
+        }
+
+        if (d.point > max_exp * 31 / 100 + 1) {
+            return negative ? -HUGE_VALL : HUGE_VALL;
+        }
+
+        // Scales the number into [0.5, 1), a shift by shifts[n] bits moves the decimal point by at most n digits, far
+        // from it the largest shift moves it by at most 19
+        while (d.point > 0) {
+            int bits = d.point < 9 ? shifts[d.point] : d.point < 19 ? 27 : 60;
+
+            NPK_decimal_shift_(&d, -bits);
+            exp2 += bits;
+        }
+
+        while (d.point < 0 || (d.point == 0 && d.digits[0] < 5)) {
+            int bits = -d.point < 9 ? shifts[-d.point] : -d.point < 19 ? 27 : 60;
+
+            NPK_decimal_shift_(&d, bits);
+            exp2 -= bits;
+        }
+
+        // The mantissa lies in [1, 2), below the smallest normal exponent the number becomes subnormal
+        exp2--;
+
+        if (exp2 < min_exp - 1) {
+            NPK_decimal_shift_(&d, exp2 - (min_exp - 1));
+            exp2 = min_exp - 1;
+        }
+
+        NPK_decimal_shift_(&d, mant_dig);
+
+        long double mant = 0;
+
+        NPK_count_up (k, 0, d.point) {
+            mant = mant * 10 + (k < d.len ? d.digits[k] : 0);
+        }
+
+        mant += NPK_decimal_round_up_(&d, d.point);
+
+        // Rounding can carry into one more bit
+        if (mant == ldexpl(1, mant_dig)) {
+            mant /= 2;
+            exp2++;
+        }
+
+        if (exp2 >= max_exp) {
+            return negative ? -HUGE_VALL : HUGE_VALL;
+        }
+
+        mant = ldexpl(mant, exp2 - (mant_dig - 1));
+
+        return negative ? -mant : mant;
+    }
+
+    // The Eisel-Lemire algorithm, rounds "w" * 10^"q" to a float or double from the 128 bit truncation of the power of
+    // five, which is always precise enough for a "w" that holds every digit of the number
+    double NPK_eisel_lemire_(uint64_t w, int q, bool single) {
+        // The leading 128 bits of 5^q for q in [-342, 308], rounded up for negative q and truncated otherwise
+        static const uint64_t pow5[] = {
+            UINT64_C(0xEEF453D6923BD65A), UINT64_C(0x113FAA2906A13B3F), UINT64_C(0x9558B4661B6565F8), UINT64_C(0x4AC7CA59A424C507),
+            UINT64_C(0xBAAEE17FA23EBF76), UINT64_C(0x5D79BCF00D2DF649), UINT64_C(0xE95A99DF8ACE6F53), UINT64_C(0xF4D82C2C107973DC),
+            UINT64_C(0x91D8A02BB6C10594), UINT64_C(0x79071B9B8A4BE869), UINT64_C(0xB64EC836A47146F9), UINT64_C(0x9748E2826CDEE284),
+            UINT64_C(0xE3E27A444D8D98B7), UINT64_C(0xFD1B1B2308169B25), UINT64_C(0x8E6D8C6AB0787F72), UINT64_C(0xFE30F0F5E50E20F7),
+            UINT64_C(0xB208EF855C969F4F), UINT64_C(0xBDBD2D335E51A935), UINT64_C(0xDE8B2B66B3BC4723), UINT64_C(0xAD2C788035E61382),
+            UINT64_C(0x8B16FB203055AC76), UINT64_C(0x4C3BCB5021AFCC31), UINT64_C(0xADDCB9E83C6B1793), UINT64_C(0xDF4ABE242A1BBF3D),
+            UINT64_C(0xD953E8624B85DD78), UINT64_C(0xD71D6DAD34A2AF0D), UINT64_C(0x87D4713D6F33AA6B), UINT64_C(0x8672648C40E5AD68),
+            UINT64_C(0xA9C98D8CCB009506), UINT64_C(0x680EFDAF511F18C2), UINT64_C(0xD43BF0EFFDC0BA48), UINT64_C(0x0212BD1B2566DEF2),
+            UINT64_C(0x84A57695FE98746D), UINT64_C(0x014BB630F7604B57), UINT64_C(0xA5CED43B7E3E9188), UINT64_C(0x419EA3BD35385E2D),
+            UINT64_C(0xCF42894A5DCE35EA), UINT64_C(0x52064CAC828675B9), UINT64_C(0x818995CE7AA0E1B2), UINT64_C(0x7343EFEBD1940993),
+            UINT64_C(0xA1EBFB4219491A1F), UINT64_C(0x1014EBE6C5F90BF8), UINT64_C(0xCA66FA129F9B60A6), UINT64_C(0xD41A26E077774EF6),
+            UINT64_C(0xFD00B897478238D0), UINT64_C(0x8920B098955522B4), UINT64_C(0x9E20735E8CB16382), UINT64_C(0x55B46E5F5D5535B0),
+            UINT64_C(0xC5A890362FDDBC62), UINT64_C(0xEB2189F734AA831D), UINT64_C(0xF712B443BBD52B7B), UINT64_C(0xA5E9EC7501D523E4),
+            UINT64_C(0x9A6BB0AA55653B2D), UINT64_C(0x47B233C92125366E), UINT64_C(0xC1069CD4EABE89F8), UINT64_C(0x999EC0BB696E840A),
+            UINT64_C(0xF148440A256E2C76), UINT64_C(0xC00670EA43CA250D), UINT64_C(0x96CD2A865764DBCA), UINT64_C(0x380406926A5E5728),
+            UINT64_C(0xBC807527ED3E12BC), UINT64_C(0xC605083704F5ECF2), UINT64_C(0xEBA09271E88D976B), UINT64_C(0xF7864A44C633682E),
+            UINT64_C(0x93445B8731587EA3), UINT64_C(0x7AB3EE6AFBE0211D), UINT64_C(0xB8157268FDAE9E4C), UINT64_C(0x5960EA05BAD82964),
+            UINT64_C(0xE61ACF033D1A45DF), UINT64_C(0x6FB92487298E33BD), UINT64_C(0x8FD0C16206306BAB), UINT64_C(0xA5D3B6D479F8E056),
+            UINT64_C(0xB3C4F1BA87BC8696), UINT64_C(0x8F48A4899877186C), UINT64_C(0xE0B62E2929ABA83C), UINT64_C(0x331ACDABFE94DE87),
+            UINT64_C(0x8C71DCD9BA0B4925), UINT64_C(0x9FF0C08B7F1D0B14), UINT64_C(0xAF8E5410288E1B6F), UINT64_C(0x07ECF0AE5EE44DD9),
+            UINT64_C(0xDB71E91432B1A24A), UINT64_C(0xC9E82CD9F69D6150), UINT64_C(0x892731AC9FAF056E), UINT64_C(0xBE311C083A225CD2),
+            UINT64_C(0xAB70FE17C79AC6CA), UINT64_C(0x6DBD630A48AAF406), UINT64_C(0xD64D3D9DB981787D), UINT64_C(0x092CBBCCDAD5B108),
+            UINT64_C(0x85F0468293F0EB4E), UINT64_C(0x25BBF56008C58EA5), UINT64_C(0xA76C582338ED2621), UINT64_C(0xAF2AF2B80AF6F24E),
+            UINT64_C(0xD1476E2C07286FAA), UINT64_C(0x1AF5AF660DB4AEE1), UINT64_C(0x82CCA4DB847945CA), UINT64_C(0x50D98D9FC890ED4D),
+            UINT64_C(0xA37FCE126597973C), UINT64_C(0xE50FF107BAB528A0), UINT64_C(0xCC5FC196FEFD7D0C), UINT64_C(0x1E53ED49A96272C8),
+            UINT64_C(0xFF77B1FCBEBCDC4F), UINT64_C(0x25E8E89C13BB0F7A), UINT64_C(0x9FAACF3DF73609B1), UINT64_C(0x77B191618C54E9AC),
+            UINT64_C(0xC795830D75038C1D), UINT64_C(0xD59DF5B9EF6A2417), UINT64_C(0xF97AE3D0D2446F25), UINT64_C(0x4B0573286B44AD1D),
+            UINT64_C(0x9BECCE62836AC577), UINT64_C(0x4EE367F9430AEC32), UINT64_C(0xC2E801FB244576D5), UINT64_C(0x229C41F793CDA73F),
+            UINT64_C(0xF3A20279ED56D48A), UINT64_C(0x6B43527578C1110F), UINT64_C(0x9845418C345644D6), UINT64_C(0x830A13896B78AAA9),
+            UINT64_C(0xBE5691EF416BD60C), UINT64_C(0x23CC986BC656D553), UINT64_C(0xEDEC366B11C6CB8F), UINT64_C(0x2CBFBE86B7EC8AA8),
+            UINT64_C(0x94B3A202EB1C3F39), UINT64_C(0x7BF7D71432F3D6A9), UINT64_C(0xB9E08A83A5E34F07), UINT64_C(0xDAF5CCD93FB0CC53),
+            UINT64_C(0xE858AD248F5C22C9), UINT64_C(0xD1B3400F8F9CFF68), UINT64_C(0x91376C36D99995BE), UINT64_C(0x23100809B9C21FA1),
+            UINT64_C(0xB58547448FFFFB2D), UINT64_C(0xABD40A0C2832A78A), UINT64_C(0xE2E69915B3FFF9F9), UINT64_C(0x16C90C8F323F516C),
+            UINT64_C(0x8DD01FAD907FFC3B), UINT64_C(0xAE3DA7D97F6792E3), UINT64_C(0xB1442798F49FFB4A), UINT64_C(0x99CD11CFDF41779C),
+            UINT64_C(0xDD95317F31C7FA1D), UINT64_C(0x40405643D711D583), UINT64_C(0x8A7D3EEF7F1CFC52), UINT64_C(0x482835EA666B2572),
+            UINT64_C(0xAD1C8EAB5EE43B66), UINT64_C(0xDA3243650005EECF), UINT64_C(0xD863B256369D4A40), UINT64_C(0x90BED43E40076A82),
+            UINT64_C(0x873E4F75E2224E68), UINT64_C(0x5A7744A6E804A291), UINT64_C(0xA90DE3535AAAE202), UINT64_C(0x711515D0A205CB36),
+            UINT64_C(0xD3515C2831559A83), UINT64_C(0x0D5A5B44CA873E03), UINT64_C(0x8412D9991ED58091), UINT64_C(0xE858790AFE9486C2),
+            UINT64_C(0xA5178FFF668AE0B6), UINT64_C(0x626E974DBE39A872), UINT64_C(0xCE5D73FF402D98E3), UINT64_C(0xFB0A3D212DC8128F),
+            UINT64_C(0x80FA687F881C7F8E), UINT64_C(0x7CE66634BC9D0B99), UINT64_C(0xA139029F6A239F72), UINT64_C(0x1C1FFFC1EBC44E80),
+            UINT64_C(0xC987434744AC874E), UINT64_C(0xA327FFB266B56220), UINT64_C(0xFBE9141915D7A922), UINT64_C(0x4BF1FF9F0062BAA8),
+            UINT64_C(0x9D71AC8FADA6C9B5), UINT64_C(0x6F773FC3603DB4A9), UINT64_C(0xC4CE17B399107C22), UINT64_C(0xCB550FB4384D21D3),
+            UINT64_C(0xF6019DA07F549B2B), UINT64_C(0x7E2A53A146606A48), UINT64_C(0x99C102844F94E0FB), UINT64_C(0x2EDA7444CBFC426D),
+            UINT64_C(0xC0314325637A1939), UINT64_C(0xFA911155FEFB5308), UINT64_C(0xF03D93EEBC589F88), UINT64_C(0x793555AB7EBA27CA),
+            UINT64_C(0x96267C7535B763B5), UINT64_C(0x4BC1558B2F3458DE), UINT64_C(0xBBB01B9283253CA2), UINT64_C(0x9EB1AAEDFB016F16),
+            UINT64_C(0xEA9C227723EE8BCB), UINT64_C(0x465E15A979C1CADC), UINT64_C(0x92A1958A7675175F), UINT64_C(0x0BFACD89EC191EC9),
+            UINT64_C(0xB749FAED14125D36), UINT64_C(0xCEF980EC671F667B), UINT64_C(0xE51C79A85916F484), UINT64_C(0x82B7E12780E7401A),
+            UINT64_C(0x8F31CC0937AE58D2), UINT64_C(0xD1B2ECB8B0908810), UINT64_C(0xB2FE3F0B8599EF07), UINT64_C(0x861FA7E6DCB4AA15),
+            UINT64_C(0xDFBDCECE67006AC9), UINT64_C(0x67A791E093E1D49A), UINT64_C(0x8BD6A141006042BD), UINT64_C(0xE0C8BB2C5C6D24E0),
+            UINT64_C(0xAECC49914078536D), UINT64_C(0x58FAE9F773886E18), UINT64_C(0xDA7F5BF590966848), UINT64_C(0xAF39A475506A899E),
+            UINT64_C(0x888F99797A5E012D), UINT64_C(0x6D8406C952429603), UINT64_C(0xAAB37FD7D8F58178), UINT64_C(0xC8E5087BA6D33B83),
+            UINT64_C(0xD5605FCDCF32E1D6), UINT64_C(0xFB1E4A9A90880A64), UINT64_C(0x855C3BE0A17FCD26), UINT64_C(0x5CF2EEA09A55067F),
+            UINT64_C(0xA6B34AD8C9DFC06F), UINT64_C(0xF42FAA48C0EA481E), UINT64_C(0xD0601D8EFC57B08B), UINT64_C(0xF13B94DAF124DA26),
+            UINT64_C(0x823C12795DB6CE57), UINT64_C(0x76C53D08D6B70858), UINT64_C(0xA2CB1717B52481ED), UINT64_C(0x54768C4B0C64CA6E),
+            UINT64_C(0xCB7DDCDDA26DA268), UINT64_C(0xA9942F5DCF7DFD09), UINT64_C(0xFE5D54150B090B02), UINT64_C(0xD3F93B35435D7C4C),
+            UINT64_C(0x9EFA548D26E5A6E1), UINT64_C(0xC47BC5014A1A6DAF), UINT64_C(0xC6B8E9B0709F109A), UINT64_C(0x359AB6419CA1091B),
+            UINT64_C(0xF867241C8CC6D4C0), UINT64_C(0xC30163D203C94B62), UINT64_C(0x9B407691D7FC44F8), UINT64_C(0x79E0DE63425DCF1D),
+            UINT64_C(0xC21094364DFB5636), UINT64_C(0x985915FC12F542E4), UINT64_C(0xF294B943E17A2BC4), UINT64_C(0x3E6F5B7B17B2939D),
+            UINT64_C(0x979CF3CA6CEC5B5A), UINT64_C(0xA705992CEECF9C42), UINT64_C(0xBD8430BD08277231), UINT64_C(0x50C6FF782A838353),
+            UINT64_C(0xECE53CEC4A314EBD), UINT64_C(0xA4F8BF5635246428), UINT64_C(0x940F4613AE5ED136), UINT64_C(0x871B7795E136BE99),
+            UINT64_C(0xB913179899F68584), UINT64_C(0x28E2557B59846E3F), UINT64_C(0xE757DD7EC07426E5), UINT64_C(0x331AEADA2FE589CF),
+            UINT64_C(0x9096EA6F3848984F), UINT64_C(0x3FF0D2C85DEF7621), UINT64_C(0xB4BCA50B065ABE63), UINT64_C(0x0FED077A756B53A9),
+            UINT64_C(0xE1EBCE4DC7F16DFB), UINT64_C(0xD3E8495912C62894), UINT64_C(0x8D3360F09CF6E4BD), UINT64_C(0x64712DD7ABBBD95C),
+            UINT64_C(0xB080392CC4349DEC), UINT64_C(0xBD8D794D96AACFB3), UINT64_C(0xDCA04777F541C567), UINT64_C(0xECF0D7A0FC5583A0),
+            UINT64_C(0x89E42CAAF9491B60), UINT64_C(0xF41686C49DB57244), UINT64_C(0xAC5D37D5B79B6239), UINT64_C(0x311C2875C522CED5),
+            UINT64_C(0xD77485CB25823AC7), UINT64_C(0x7D633293366B828B), UINT64_C(0x86A8D39EF77164BC), UINT64_C(0xAE5DFF9C02033197),
+            UINT64_C(0xA8530886B54DBDEB), UINT64_C(0xD9F57F830283FDFC), UINT64_C(0xD267CAA862A12D66), UINT64_C(0xD072DF63C324FD7B),
+            UINT64_C(0x8380DEA93DA4BC60), UINT64_C(0x4247CB9E59F71E6D), UINT64_C(0xA46116538D0DEB78), UINT64_C(0x52D9BE85F074E608),
+            UINT64_C(0xCD795BE870516656), UINT64_C(0x67902E276C921F8B), UINT64_C(0x806BD9714632DFF6), UINT64_C(0x00BA1CD8A3DB53B6),
+            UINT64_C(0xA086CFCD97BF97F3), UINT64_C(0x80E8A40ECCD228A4), UINT64_C(0xC8A883C0FDAF7DF0), UINT64_C(0x6122CD128006B2CD),
+            UINT64_C(0xFAD2A4B13D1B5D6C), UINT64_C(0x796B805720085F81), UINT64_C(0x9CC3A6EEC6311A63), UINT64_C(0xCBE3303674053BB0),
+            UINT64_C(0xC3F490AA77BD60FC), UINT64_C(0xBEDBFC4411068A9C), UINT64_C(0xF4F1B4D515ACB93B), UINT64_C(0xEE92FB5515482D44),
+            UINT64_C(0x991711052D8BF3C5), UINT64_C(0x751BDD152D4D1C4A), UINT64_C(0xBF5CD54678EEF0B6), UINT64_C(0xD262D45A78A0635D),
+            UINT64_C(0xEF340A98172AACE4), UINT64_C(0x86FB897116C87C34), UINT64_C(0x9580869F0E7AAC0E), UINT64_C(0xD45D35E6AE3D4DA0),
+            UINT64_C(0xBAE0A846D2195712), UINT64_C(0x8974836059CCA109), UINT64_C(0xE998D258869FACD7), UINT64_C(0x2BD1A438703FC94B),
+            UINT64_C(0x91FF83775423CC06), UINT64_C(0x7B6306A34627DDCF), UINT64_C(0xB67F6455292CBF08), UINT64_C(0x1A3BC84C17B1D542),
+            UINT64_C(0xE41F3D6A7377EECA), UINT64_C(0x20CABA5F1D9E4A93), UINT64_C(0x8E938662882AF53E), UINT64_C(0x547EB47B7282EE9C),
+            UINT64_C(0xB23867FB2A35B28D), UINT64_C(0xE99E619A4F23AA43), UINT64_C(0xDEC681F9F4C31F31), UINT64_C(0x6405FA00E2EC94D4),
+            UINT64_C(0x8B3C113C38F9F37E), UINT64_C(0xDE83BC408DD3DD04), UINT64_C(0xAE0B158B4738705E), UINT64_C(0x9624AB50B148D445),
+            UINT64_C(0xD98DDAEE19068C76), UINT64_C(0x3BADD624DD9B0957), UINT64_C(0x87F8A8D4CFA417C9), UINT64_C(0xE54CA5D70A80E5D6),
+            UINT64_C(0xA9F6D30A038D1DBC), UINT64_C(0x5E9FCF4CCD211F4C), UINT64_C(0xD47487CC8470652B), UINT64_C(0x7647C3200069671F),
+            UINT64_C(0x84C8D4DFD2C63F3B), UINT64_C(0x29ECD9F40041E073), UINT64_C(0xA5FB0A17C777CF09), UINT64_C(0xF468107100525890),
+            UINT64_C(0xCF79CC9DB955C2CC), UINT64_C(0x7182148D4066EEB4), UINT64_C(0x81AC1FE293D599BF), UINT64_C(0xC6F14CD848405530),
+            UINT64_C(0xA21727DB38CB002F), UINT64_C(0xB8ADA00E5A506A7C), UINT64_C(0xCA9CF1D206FDC03B), UINT64_C(0xA6D90811F0E4851C),
+            UINT64_C(0xFD442E4688BD304A), UINT64_C(0x908F4A166D1DA663), UINT64_C(0x9E4A9CEC15763E2E), UINT64_C(0x9A598E4E043287FE),
+            UINT64_C(0xC5DD44271AD3CDBA), UINT64_C(0x40EFF1E1853F29FD), UINT64_C(0xF7549530E188C128), UINT64_C(0xD12BEE59E68EF47C),
+            UINT64_C(0x9A94DD3E8CF578B9), UINT64_C(0x82BB74F8301958CE), UINT64_C(0xC13A148E3032D6E7), UINT64_C(0xE36A52363C1FAF01),
+            UINT64_C(0xF18899B1BC3F8CA1), UINT64_C(0xDC44E6C3CB279AC1), UINT64_C(0x96F5600F15A7B7E5), UINT64_C(0x29AB103A5EF8C0B9),
+            UINT64_C(0xBCB2B812DB11A5DE), UINT64_C(0x7415D448F6B6F0E7), UINT64_C(0xEBDF661791D60F56), UINT64_C(0x111B495B3464AD21),
+            UINT64_C(0x936B9FCEBB25C995), UINT64_C(0xCAB10DD900BEEC34), UINT64_C(0xB84687C269EF3BFB), UINT64_C(0x3D5D514F40EEA742),
+            UINT64_C(0xE65829B3046B0AFA), UINT64_C(0x0CB4A5A3112A5112), UINT64_C(0x8FF71A0FE2C2E6DC), UINT64_C(0x47F0E785EABA72AB),
+            UINT64_C(0xB3F4E093DB73A093), UINT64_C(0x59ED216765690F56), UINT64_C(0xE0F218B8D25088B8), UINT64_C(0x306869C13EC3532C),
+            UINT64_C(0x8C974F7383725573), UINT64_C(0x1E414218C73A13FB), UINT64_C(0xAFBD2350644EEACF), UINT64_C(0xE5D1929EF90898FA),
+            UINT64_C(0xDBAC6C247D62A583), UINT64_C(0xDF45F746B74ABF39), UINT64_C(0x894BC396CE5DA772), UINT64_C(0x6B8BBA8C328EB783),
+            UINT64_C(0xAB9EB47C81F5114F), UINT64_C(0x066EA92F3F326564), UINT64_C(0xD686619BA27255A2), UINT64_C(0xC80A537B0EFEFEBD),
+            UINT64_C(0x8613FD0145877585), UINT64_C(0xBD06742CE95F5F36), UINT64_C(0xA798FC4196E952E7), UINT64_C(0x2C48113823B73704),
+            UINT64_C(0xD17F3B51FCA3A7A0), UINT64_C(0xF75A15862CA504C5), UINT64_C(0x82EF85133DE648C4), UINT64_C(0x9A984D73DBE722FB),
+            UINT64_C(0xA3AB66580D5FDAF5), UINT64_C(0xC13E60D0D2E0EBBA), UINT64_C(0xCC963FEE10B7D1B3), UINT64_C(0x318DF905079926A8),
+            UINT64_C(0xFFBBCFE994E5C61F), UINT64_C(0xFDF17746497F7052), UINT64_C(0x9FD561F1FD0F9BD3), UINT64_C(0xFEB6EA8BEDEFA633),
+            UINT64_C(0xC7CABA6E7C5382C8), UINT64_C(0xFE64A52EE96B8FC0), UINT64_C(0xF9BD690A1B68637B), UINT64_C(0x3DFDCE7AA3C673B0),
+            UINT64_C(0x9C1661A651213E2D), UINT64_C(0x06BEA10CA65C084E), UINT64_C(0xC31BFA0FE5698DB8), UINT64_C(0x486E494FCFF30A62),
+            UINT64_C(0xF3E2F893DEC3F126), UINT64_C(0x5A89DBA3C3EFCCFA), UINT64_C(0x986DDB5C6B3A76B7), UINT64_C(0xF89629465A75E01C),
+            UINT64_C(0xBE89523386091465), UINT64_C(0xF6BBB397F1135823), UINT64_C(0xEE2BA6C0678B597F), UINT64_C(0x746AA07DED582E2C),
+            UINT64_C(0x94DB483840B717EF), UINT64_C(0xA8C2A44EB4571CDC), UINT64_C(0xBA121A4650E4DDEB), UINT64_C(0x92F34D62616CE413),
+            UINT64_C(0xE896A0D7E51E1566), UINT64_C(0x77B020BAF9C81D17), UINT64_C(0x915E2486EF32CD60), UINT64_C(0x0ACE1474DC1D122E),
+            UINT64_C(0xB5B5ADA8AAFF80B8), UINT64_C(0x0D819992132456BA), UINT64_C(0xE3231912D5BF60E6), UINT64_C(0x10E1FFF697ED6C69),
+            UINT64_C(0x8DF5EFABC5979C8F), UINT64_C(0xCA8D3FFA1EF463C1), UINT64_C(0xB1736B96B6FD83B3), UINT64_C(0xBD308FF8A6B17CB2),
+            UINT64_C(0xDDD0467C64BCE4A0), UINT64_C(0xAC7CB3F6D05DDBDE), UINT64_C(0x8AA22C0DBEF60EE4), UINT64_C(0x6BCDF07A423AA96B),
+            UINT64_C(0xAD4AB7112EB3929D), UINT64_C(0x86C16C98D2C953C6), UINT64_C(0xD89D64D57A607744), UINT64_C(0xE871C7BF077BA8B7),
+            UINT64_C(0x87625F056C7C4A8B), UINT64_C(0x11471CD764AD4972), UINT64_C(0xA93AF6C6C79B5D2D), UINT64_C(0xD598E40D3DD89BCF),
+            UINT64_C(0xD389B47879823479), UINT64_C(0x4AFF1D108D4EC2C3), UINT64_C(0x843610CB4BF160CB), UINT64_C(0xCEDF722A585139BA),
+            UINT64_C(0xA54394FE1EEDB8FE), UINT64_C(0xC2974EB4EE658828), UINT64_C(0xCE947A3DA6A9273E), UINT64_C(0x733D226229FEEA32),
+            UINT64_C(0x811CCC668829B887), UINT64_C(0x0806357D5A3F525F), UINT64_C(0xA163FF802A3426A8), UINT64_C(0xCA07C2DCB0CF26F7),
+            UINT64_C(0xC9BCFF6034C13052), UINT64_C(0xFC89B393DD02F0B5), UINT64_C(0xFC2C3F3841F17C67), UINT64_C(0xBBAC2078D443ACE2),
+            UINT64_C(0x9D9BA7832936EDC0), UINT64_C(0xD54B944B84AA4C0D), UINT64_C(0xC5029163F384A931), UINT64_C(0x0A9E795E65D4DF11),
+            UINT64_C(0xF64335BCF065D37D), UINT64_C(0x4D4617B5FF4A16D5), UINT64_C(0x99EA0196163FA42E), UINT64_C(0x504BCED1BF8E4E45),
+            UINT64_C(0xC06481FB9BCF8D39), UINT64_C(0xE45EC2862F71E1D6), UINT64_C(0xF07DA27A82C37088), UINT64_C(0x5D767327BB4E5A4C),
+            UINT64_C(0x964E858C91BA2655), UINT64_C(0x3A6A07F8D510F86F), UINT64_C(0xBBE226EFB628AFEA), UINT64_C(0x890489F70A55368B),
+            UINT64_C(0xEADAB0ABA3B2DBE5), UINT64_C(0x2B45AC74CCEA842E), UINT64_C(0x92C8AE6B464FC96F), UINT64_C(0x3B0B8BC90012929D),
+            UINT64_C(0xB77ADA0617E3BBCB), UINT64_C(0x09CE6EBB40173744), UINT64_C(0xE55990879DDCAABD), UINT64_C(0xCC420A6A101D0515),
+            UINT64_C(0x8F57FA54C2A9EAB6), UINT64_C(0x9FA946824A12232D), UINT64_C(0xB32DF8E9F3546564), UINT64_C(0x47939822DC96ABF9),
+            UINT64_C(0xDFF9772470297EBD), UINT64_C(0x59787E2B93BC56F7), UINT64_C(0x8BFBEA76C619EF36), UINT64_C(0x57EB4EDB3C55B65A),
+            UINT64_C(0xAEFAE51477A06B03), UINT64_C(0xEDE622920B6B23F1), UINT64_C(0xDAB99E59958885C4), UINT64_C(0xE95FAB368E45ECED),
+            UINT64_C(0x88B402F7FD75539B), UINT64_C(0x11DBCB0218EBB414), UINT64_C(0xAAE103B5FCD2A881), UINT64_C(0xD652BDC29F26A119),
+            UINT64_C(0xD59944A37C0752A2), UINT64_C(0x4BE76D3346F0495F), UINT64_C(0x857FCAE62D8493A5), UINT64_C(0x6F70A4400C562DDB),
+            UINT64_C(0xA6DFBD9FB8E5B88E), UINT64_C(0xCB4CCD500F6BB952), UINT64_C(0xD097AD07A71F26B2), UINT64_C(0x7E2000A41346A7A7),
+            UINT64_C(0x825ECC24C873782F), UINT64_C(0x8ED400668C0C28C8), UINT64_C(0xA2F67F2DFA90563B), UINT64_C(0x728900802F0F32FA),
+            UINT64_C(0xCBB41EF979346BCA), UINT64_C(0x4F2B40A03AD2FFB9), UINT64_C(0xFEA126B7D78186BC), UINT64_C(0xE2F610C84987BFA8),
+            UINT64_C(0x9F24B832E6B0F436), UINT64_C(0x0DD9CA7D2DF4D7C9), UINT64_C(0xC6EDE63FA05D3143), UINT64_C(0x91503D1C79720DBB),
+            UINT64_C(0xF8A95FCF88747D94), UINT64_C(0x75A44C6397CE912A), UINT64_C(0x9B69DBE1B548CE7C), UINT64_C(0xC986AFBE3EE11ABA),
+            UINT64_C(0xC24452DA229B021B), UINT64_C(0xFBE85BADCE996168), UINT64_C(0xF2D56790AB41C2A2), UINT64_C(0xFAE27299423FB9C3),
+            UINT64_C(0x97C560BA6B0919A5), UINT64_C(0xDCCD879FC967D41A), UINT64_C(0xBDB6B8E905CB600F), UINT64_C(0x5400E987BBC1C920),
+            UINT64_C(0xED246723473E3813), UINT64_C(0x290123E9AAB23B68), UINT64_C(0x9436C0760C86E30B), UINT64_C(0xF9A0B6720AAF6521),
+            UINT64_C(0xB94470938FA89BCE), UINT64_C(0xF808E40E8D5B3E69), UINT64_C(0xE7958CB87392C2C2), UINT64_C(0xB60B1D1230B20E04),
+            UINT64_C(0x90BD77F3483BB9B9), UINT64_C(0xB1C6F22B5E6F48C2), UINT64_C(0xB4ECD5F01A4AA828), UINT64_C(0x1E38AEB6360B1AF3),
+            UINT64_C(0xE2280B6C20DD5232), UINT64_C(0x25C6DA63C38DE1B0), UINT64_C(0x8D590723948A535F), UINT64_C(0x579C487E5A38AD0E),
+            UINT64_C(0xB0AF48EC79ACE837), UINT64_C(0x2D835A9DF0C6D851), UINT64_C(0xDCDB1B2798182244), UINT64_C(0xF8E431456CF88E65),
+            UINT64_C(0x8A08F0F8BF0F156B), UINT64_C(0x1B8E9ECB641B58FF), UINT64_C(0xAC8B2D36EED2DAC5), UINT64_C(0xE272467E3D222F3F),
+            UINT64_C(0xD7ADF884AA879177), UINT64_C(0x5B0ED81DCC6ABB0F), UINT64_C(0x86CCBB52EA94BAEA), UINT64_C(0x98E947129FC2B4E9),
+            UINT64_C(0xA87FEA27A539E9A5), UINT64_C(0x3F2398D747B36224), UINT64_C(0xD29FE4B18E88640E), UINT64_C(0x8EEC7F0D19A03AAD),
+            UINT64_C(0x83A3EEEEF9153E89), UINT64_C(0x1953CF68300424AC), UINT64_C(0xA48CEAAAB75A8E2B), UINT64_C(0x5FA8C3423C052DD7),
+            UINT64_C(0xCDB02555653131B6), UINT64_C(0x3792F412CB06794D), UINT64_C(0x808E17555F3EBF11), UINT64_C(0xE2BBD88BBEE40BD0),
+            UINT64_C(0xA0B19D2AB70E6ED6), UINT64_C(0x5B6ACEAEAE9D0EC4), UINT64_C(0xC8DE047564D20A8B), UINT64_C(0xF245825A5A445275),
+            UINT64_C(0xFB158592BE068D2E), UINT64_C(0xEED6E2F0F0D56712), UINT64_C(0x9CED737BB6C4183D), UINT64_C(0x55464DD69685606B),
+            UINT64_C(0xC428D05AA4751E4C), UINT64_C(0xAA97E14C3C26B886), UINT64_C(0xF53304714D9265DF), UINT64_C(0xD53DD99F4B3066A8),
+            UINT64_C(0x993FE2C6D07B7FAB), UINT64_C(0xE546A8038EFE4029), UINT64_C(0xBF8FDB78849A5F96), UINT64_C(0xDE98520472BDD033),
+            UINT64_C(0xEF73D256A5C0F77C), UINT64_C(0x963E66858F6D4440), UINT64_C(0x95A8637627989AAD), UINT64_C(0xDDE7001379A44AA8),
+            UINT64_C(0xBB127C53B17EC159), UINT64_C(0x5560C018580D5D52), UINT64_C(0xE9D71B689DDE71AF), UINT64_C(0xAAB8F01E6E10B4A6),
+            UINT64_C(0x9226712162AB070D), UINT64_C(0xCAB3961304CA70E8), UINT64_C(0xB6B00D69BB55C8D1), UINT64_C(0x3D607B97C5FD0D22),
+            UINT64_C(0xE45C10C42A2B3B05), UINT64_C(0x8CB89A7DB77C506A), UINT64_C(0x8EB98A7A9A5B04E3), UINT64_C(0x77F3608E92ADB242),
+            UINT64_C(0xB267ED1940F1C61C), UINT64_C(0x55F038B237591ED3), UINT64_C(0xDF01E85F912E37A3), UINT64_C(0x6B6C46DEC52F6688),
+            UINT64_C(0x8B61313BBABCE2C6), UINT64_C(0x2323AC4B3B3DA015), UINT64_C(0xAE397D8AA96C1B77), UINT64_C(0xABEC975E0A0D081A),
+            UINT64_C(0xD9C7DCED53C72255), UINT64_C(0x96E7BD358C904A21), UINT64_C(0x881CEA14545C7575), UINT64_C(0x7E50D64177DA2E54),
+            UINT64_C(0xAA242499697392D2), UINT64_C(0xDDE50BD1D5D0B9E9), UINT64_C(0xD4AD2DBFC3D07787), UINT64_C(0x955E4EC64B44E864),
+            UINT64_C(0x84EC3C97DA624AB4), UINT64_C(0xBD5AF13BEF0B113E), UINT64_C(0xA6274BBDD0FADD61), UINT64_C(0xECB1AD8AEACDD58E),
+            UINT64_C(0xCFB11EAD453994BA), UINT64_C(0x67DE18EDA5814AF2), UINT64_C(0x81CEB32C4B43FCF4), UINT64_C(0x80EACF948770CED7),
+            UINT64_C(0xA2425FF75E14FC31), UINT64_C(0xA1258379A94D028D), UINT64_C(0xCAD2F7F5359A3B3E), UINT64_C(0x096EE45813A04330),
+            UINT64_C(0xFD87B5F28300CA0D), UINT64_C(0x8BCA9D6E188853FC), UINT64_C(0x9E74D1B791E07E48), UINT64_C(0x775EA264CF55347E),
+            UINT64_C(0xC612062576589DDA), UINT64_C(0x95364AFE032A819E), UINT64_C(0xF79687AED3EEC551), UINT64_C(0x3A83DDBD83F52205),
+            UINT64_C(0x9ABE14CD44753B52), UINT64_C(0xC4926A9672793543), UINT64_C(0xC16D9A0095928A27), UINT64_C(0x75B7053C0F178294),
+            UINT64_C(0xF1C90080BAF72CB1), UINT64_C(0x5324C68B12DD6339), UINT64_C(0x971DA05074DA7BEE), UINT64_C(0xD3F6FC16EBCA5E04),
+            UINT64_C(0xBCE5086492111AEA), UINT64_C(0x88F4BB1CA6BCF585), UINT64_C(0xEC1E4A7DB69561A5), UINT64_C(0x2B31E9E3D06C32E6),
+            UINT64_C(0x9392EE8E921D5D07), UINT64_C(0x3AFF322E62439FD0), UINT64_C(0xB877AA3236A4B449), UINT64_C(0x09BEFEB9FAD487C3),
+            UINT64_C(0xE69594BEC44DE15B), UINT64_C(0x4C2EBE687989A9B4), UINT64_C(0x901D7CF73AB0ACD9), UINT64_C(0x0F9D37014BF60A11),
+            UINT64_C(0xB424DC35095CD80F), UINT64_C(0x538484C19EF38C95), UINT64_C(0xE12E13424BB40E13), UINT64_C(0x2865A5F206B06FBA),
+            UINT64_C(0x8CBCCC096F5088CB), UINT64_C(0xF93F87B7442E45D4), UINT64_C(0xAFEBFF0BCB24AAFE), UINT64_C(0xF78F69A51539D749),
+            UINT64_C(0xDBE6FECEBDEDD5BE), UINT64_C(0xB573440E5A884D1C), UINT64_C(0x89705F4136B4A597), UINT64_C(0x31680A88F8953031),
+            UINT64_C(0xABCC77118461CEFC), UINT64_C(0xFDC20D2B36BA7C3E), UINT64_C(0xD6BF94D5E57A42BC), UINT64_C(0x3D32907604691B4D),
+            UINT64_C(0x8637BD05AF6C69B5), UINT64_C(0xA63F9A49C2C1B110), UINT64_C(0xA7C5AC471B478423), UINT64_C(0x0FCF80DC33721D54),
+            UINT64_C(0xD1B71758E219652B), UINT64_C(0xD3C36113404EA4A9), UINT64_C(0x83126E978D4FDF3B), UINT64_C(0x645A1CAC083126EA),
+            UINT64_C(0xA3D70A3D70A3D70A), UINT64_C(0x3D70A3D70A3D70A4), UINT64_C(0xCCCCCCCCCCCCCCCC), UINT64_C(0xCCCCCCCCCCCCCCCD),
+            UINT64_C(0x8000000000000000), UINT64_C(0x0000000000000000), UINT64_C(0xA000000000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xC800000000000000), UINT64_C(0x0000000000000000), UINT64_C(0xFA00000000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0x9C40000000000000), UINT64_C(0x0000000000000000), UINT64_C(0xC350000000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xF424000000000000), UINT64_C(0x0000000000000000), UINT64_C(0x9896800000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xBEBC200000000000), UINT64_C(0x0000000000000000), UINT64_C(0xEE6B280000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0x9502F90000000000), UINT64_C(0x0000000000000000), UINT64_C(0xBA43B74000000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xE8D4A51000000000), UINT64_C(0x0000000000000000), UINT64_C(0x9184E72A00000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xB5E620F480000000), UINT64_C(0x0000000000000000), UINT64_C(0xE35FA931A0000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0x8E1BC9BF04000000), UINT64_C(0x0000000000000000), UINT64_C(0xB1A2BC2EC5000000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xDE0B6B3A76400000), UINT64_C(0x0000000000000000), UINT64_C(0x8AC7230489E80000), UINT64_C(0x0000000000000000),
+            UINT64_C(0xAD78EBC5AC620000), UINT64_C(0x0000000000000000), UINT64_C(0xD8D726B7177A8000), UINT64_C(0x0000000000000000),
+            UINT64_C(0x878678326EAC9000), UINT64_C(0x0000000000000000), UINT64_C(0xA968163F0A57B400), UINT64_C(0x0000000000000000),
+            UINT64_C(0xD3C21BCECCEDA100), UINT64_C(0x0000000000000000), UINT64_C(0x84595161401484A0), UINT64_C(0x0000000000000000),
+            UINT64_C(0xA56FA5B99019A5C8), UINT64_C(0x0000000000000000), UINT64_C(0xCECB8F27F4200F3A), UINT64_C(0x0000000000000000),
+            UINT64_C(0x813F3978F8940984), UINT64_C(0x4000000000000000), UINT64_C(0xA18F07D736B90BE5), UINT64_C(0x5000000000000000),
+            UINT64_C(0xC9F2C9CD04674EDE), UINT64_C(0xA400000000000000), UINT64_C(0xFC6F7C4045812296), UINT64_C(0x4D00000000000000),
+            UINT64_C(0x9DC5ADA82B70B59D), UINT64_C(0xF020000000000000), UINT64_C(0xC5371912364CE305), UINT64_C(0x6C28000000000000),
+            UINT64_C(0xF684DF56C3E01BC6), UINT64_C(0xC732000000000000), UINT64_C(0x9A130B963A6C115C), UINT64_C(0x3C7F400000000000),
+            UINT64_C(0xC097CE7BC90715B3), UINT64_C(0x4B9F100000000000), UINT64_C(0xF0BDC21ABB48DB20), UINT64_C(0x1E86D40000000000),
+            UINT64_C(0x96769950B50D88F4), UINT64_C(0x1314448000000000), UINT64_C(0xBC143FA4E250EB31), UINT64_C(0x17D955A000000000),
+            UINT64_C(0xEB194F8E1AE525FD), UINT64_C(0x5DCFAB0800000000), UINT64_C(0x92EFD1B8D0CF37BE), UINT64_C(0x5AA1CAE500000000),
+            UINT64_C(0xB7ABC627050305AD), UINT64_C(0xF14A3D9E40000000), UINT64_C(0xE596B7B0C643C719), UINT64_C(0x6D9CCD05D0000000),
+            UINT64_C(0x8F7E32CE7BEA5C6F), UINT64_C(0xE4820023A2000000), UINT64_C(0xB35DBF821AE4F38B), UINT64_C(0xDDA2802C8A800000),
+            UINT64_C(0xE0352F62A19E306E), UINT64_C(0xD50B2037AD200000), UINT64_C(0x8C213D9DA502DE45), UINT64_C(0x4526F422CC340000),
+            UINT64_C(0xAF298D050E4395D6), UINT64_C(0x9670B12B7F410000), UINT64_C(0xDAF3F04651D47B4C), UINT64_C(0x3C0CDD765F114000),
+            UINT64_C(0x88D8762BF324CD0F), UINT64_C(0xA5880A69FB6AC800), UINT64_C(0xAB0E93B6EFEE0053), UINT64_C(0x8EEA0D047A457A00),
+            UINT64_C(0xD5D238A4ABE98068), UINT64_C(0x72A4904598D6D880), UINT64_C(0x85A36366EB71F041), UINT64_C(0x47A6DA2B7F864750),
+            UINT64_C(0xA70C3C40A64E6C51), UINT64_C(0x999090B65F67D924), UINT64_C(0xD0CF4B50CFE20765), UINT64_C(0xFFF4B4E3F741CF6D),
+            UINT64_C(0x82818F1281ED449F), UINT64_C(0xBFF8F10E7A8921A4), UINT64_C(0xA321F2D7226895C7), UINT64_C(0xAFF72D52192B6A0D),
+            UINT64_C(0xCBEA6F8CEB02BB39), UINT64_C(0x9BF4F8A69F764490), UINT64_C(0xFEE50B7025C36A08), UINT64_C(0x02F236D04753D5B4),
+            UINT64_C(0x9F4F2726179A2245), UINT64_C(0x01D762422C946590), UINT64_C(0xC722F0EF9D80AAD6), UINT64_C(0x424D3AD2B7B97EF5),
+            UINT64_C(0xF8EBAD2B84E0D58B), UINT64_C(0xD2E0898765A7DEB2), UINT64_C(0x9B934C3B330C8577), UINT64_C(0x63CC55F49F88EB2F),
+            UINT64_C(0xC2781F49FFCFA6D5), UINT64_C(0x3CBF6B71C76B25FB), UINT64_C(0xF316271C7FC3908A), UINT64_C(0x8BEF464E3945EF7A),
+            UINT64_C(0x97EDD871CFDA3A56), UINT64_C(0x97758BF0E3CBB5AC), UINT64_C(0xBDE94E8E43D0C8EC), UINT64_C(0x3D52EEED1CBEA317),
+            UINT64_C(0xED63A231D4C4FB27), UINT64_C(0x4CA7AAA863EE4BDD), UINT64_C(0x945E455F24FB1CF8), UINT64_C(0x8FE8CAA93E74EF6A),
+            UINT64_C(0xB975D6B6EE39E436), UINT64_C(0xB3E2FD538E122B44), UINT64_C(0xE7D34C64A9C85D44), UINT64_C(0x60DBBCA87196B616),
+            UINT64_C(0x90E40FBEEA1D3A4A), UINT64_C(0xBC8955E946FE31CD), UINT64_C(0xB51D13AEA4A488DD), UINT64_C(0x6BABAB6398BDBE41),
+            UINT64_C(0xE264589A4DCDAB14), UINT64_C(0xC696963C7EED2DD1), UINT64_C(0x8D7EB76070A08AEC), UINT64_C(0xFC1E1DE5CF543CA2),
+            UINT64_C(0xB0DE65388CC8ADA8), UINT64_C(0x3B25A55F43294BCB), UINT64_C(0xDD15FE86AFFAD912), UINT64_C(0x49EF0EB713F39EBE),
+            UINT64_C(0x8A2DBF142DFCC7AB), UINT64_C(0x6E3569326C784337), UINT64_C(0xACB92ED9397BF996), UINT64_C(0x49C2C37F07965404),
+            UINT64_C(0xD7E77A8F87DAF7FB), UINT64_C(0xDC33745EC97BE906), UINT64_C(0x86F0AC99B4E8DAFD), UINT64_C(0x69A028BB3DED71A3),
+            UINT64_C(0xA8ACD7C0222311BC), UINT64_C(0xC40832EA0D68CE0C), UINT64_C(0xD2D80DB02AABD62B), UINT64_C(0xF50A3FA490C30190),
+            UINT64_C(0x83C7088E1AAB65DB), UINT64_C(0x792667C6DA79E0FA), UINT64_C(0xA4B8CAB1A1563F52), UINT64_C(0x577001B891185938),
+            UINT64_C(0xCDE6FD5E09ABCF26), UINT64_C(0xED4C0226B55E6F86), UINT64_C(0x80B05E5AC60B6178), UINT64_C(0x544F8158315B05B4),
+            UINT64_C(0xA0DC75F1778E39D6), UINT64_C(0x696361AE3DB1C721), UINT64_C(0xC913936DD571C84C), UINT64_C(0x03BC3A19CD1E38E9),
+            UINT64_C(0xFB5878494ACE3A5F), UINT64_C(0x04AB48A04065C723), UINT64_C(0x9D174B2DCEC0E47B), UINT64_C(0x62EB0D64283F9C76),
+            UINT64_C(0xC45D1DF942711D9A), UINT64_C(0x3BA5D0BD324F8394), UINT64_C(0xF5746577930D6500), UINT64_C(0xCA8F44EC7EE36479),
+            UINT64_C(0x9968BF6ABBE85F20), UINT64_C(0x7E998B13CF4E1ECB), UINT64_C(0xBFC2EF456AE276E8), UINT64_C(0x9E3FEDD8C321A67E),
+            UINT64_C(0xEFB3AB16C59B14A2), UINT64_C(0xC5CFE94EF3EA101E), UINT64_C(0x95D04AEE3B80ECE5), UINT64_C(0xBBA1F1D158724A12),
+            UINT64_C(0xBB445DA9CA61281F), UINT64_C(0x2A8A6E45AE8EDC97), UINT64_C(0xEA1575143CF97226), UINT64_C(0xF52D09D71A3293BD),
+            UINT64_C(0x924D692CA61BE758), UINT64_C(0x593C2626705F9C56), UINT64_C(0xB6E0C377CFA2E12E), UINT64_C(0x6F8B2FB00C77836C),
+            UINT64_C(0xE498F455C38B997A), UINT64_C(0x0B6DFB9C0F956447), UINT64_C(0x8EDF98B59A373FEC), UINT64_C(0x4724BD4189BD5EAC),
+            UINT64_C(0xB2977EE300C50FE7), UINT64_C(0x58EDEC91EC2CB657), UINT64_C(0xDF3D5E9BC0F653E1), UINT64_C(0x2F2967B66737E3ED),
+            UINT64_C(0x8B865B215899F46C), UINT64_C(0xBD79E0D20082EE74), UINT64_C(0xAE67F1E9AEC07187), UINT64_C(0xECD8590680A3AA11),
+            UINT64_C(0xDA01EE641A708DE9), UINT64_C(0xE80E6F4820CC9495), UINT64_C(0x884134FE908658B2), UINT64_C(0x3109058D147FDCDD),
+            UINT64_C(0xAA51823E34A7EEDE), UINT64_C(0xBD4B46F0599FD415), UINT64_C(0xD4E5E2CDC1D1EA96), UINT64_C(0x6C9E18AC7007C91A),
+            UINT64_C(0x850FADC09923329E), UINT64_C(0x03E2CF6BC604DDB0), UINT64_C(0xA6539930BF6BFF45), UINT64_C(0x84DB8346B786151C),
+            UINT64_C(0xCFE87F7CEF46FF16), UINT64_C(0xE612641865679A63), UINT64_C(0x81F14FAE158C5F6E), UINT64_C(0x4FCB7E8F3F60C07E),
+            UINT64_C(0xA26DA3999AEF7749), UINT64_C(0xE3BE5E330F38F09D), UINT64_C(0xCB090C8001AB551C), UINT64_C(0x5CADF5BFD3072CC5),
+            UINT64_C(0xFDCB4FA002162A63), UINT64_C(0x73D9732FC7C8F7F6), UINT64_C(0x9E9F11C4014DDA7E), UINT64_C(0x2867E7FDDCDD9AFA),
+            UINT64_C(0xC646D63501A1511D), UINT64_C(0xB281E1FD541501B8), UINT64_C(0xF7D88BC24209A565), UINT64_C(0x1F225A7CA91A4226),
+            UINT64_C(0x9AE757596946075F), UINT64_C(0x3375788DE9B06958), UINT64_C(0xC1A12D2FC3978937), UINT64_C(0x0052D6B1641C83AE),
+            UINT64_C(0xF209787BB47D6B84), UINT64_C(0xC0678C5DBD23A49A), UINT64_C(0x9745EB4D50CE6332), UINT64_C(0xF840B7BA963646E0),
+            UINT64_C(0xBD176620A501FBFF), UINT64_C(0xB650E5A93BC3D898), UINT64_C(0xEC5D3FA8CE427AFF), UINT64_C(0xA3E51F138AB4CEBE),
+            UINT64_C(0x93BA47C980E98CDF), UINT64_C(0xC66F336C36B10137), UINT64_C(0xB8A8D9BBE123F017), UINT64_C(0xB80B0047445D4184),
+            UINT64_C(0xE6D3102AD96CEC1D), UINT64_C(0xA60DC059157491E5), UINT64_C(0x9043EA1AC7E41392), UINT64_C(0x87C89837AD68DB2F),
+            UINT64_C(0xB454E4A179DD1877), UINT64_C(0x29BABE4598C311FB), UINT64_C(0xE16A1DC9D8545E94), UINT64_C(0xF4296DD6FEF3D67A),
+            UINT64_C(0x8CE2529E2734BB1D), UINT64_C(0x1899E4A65F58660C), UINT64_C(0xB01AE745B101E9E4), UINT64_C(0x5EC05DCFF72E7F8F),
+            UINT64_C(0xDC21A1171D42645D), UINT64_C(0x76707543F4FA1F73), UINT64_C(0x899504AE72497EBA), UINT64_C(0x6A06494A791C53A8),
+            UINT64_C(0xABFA45DA0EDBDE69), UINT64_C(0x0487DB9D17636892), UINT64_C(0xD6F8D7509292D603), UINT64_C(0x45A9D2845D3C42B6),
+            UINT64_C(0x865B86925B9BC5C2), UINT64_C(0x0B8A2392BA45A9B2), UINT64_C(0xA7F26836F282B732), UINT64_C(0x8E6CAC7768D7141E),
+            UINT64_C(0xD1EF0244AF2364FF), UINT64_C(0x3207D795430CD926), UINT64_C(0x8335616AED761F1F), UINT64_C(0x7F44E6BD49E807B8),
+            UINT64_C(0xA402B9C5A8D3A6E7), UINT64_C(0x5F16206C9C6209A6), UINT64_C(0xCD036837130890A1), UINT64_C(0x36DBA887C37A8C0F),
+            UINT64_C(0x802221226BE55A64), UINT64_C(0xC2494954DA2C9789), UINT64_C(0xA02AA96B06DEB0FD), UINT64_C(0xF2DB9BAA10B7BD6C),
+            UINT64_C(0xC83553C5C8965D3D), UINT64_C(0x6F92829494E5ACC7), UINT64_C(0xFA42A8B73ABBF48C), UINT64_C(0xCB772339BA1F17F9),
+            UINT64_C(0x9C69A97284B578D7), UINT64_C(0xFF2A760414536EFB), UINT64_C(0xC38413CF25E2D70D), UINT64_C(0xFEF5138519684ABA),
+            UINT64_C(0xF46518C2EF5B8CD1), UINT64_C(0x7EB258665FC25D69), UINT64_C(0x98BF2F79D5993802), UINT64_C(0xEF2F773FFBD97A61),
+            UINT64_C(0xBEEEFB584AFF8603), UINT64_C(0xAAFB550FFACFD8FA), UINT64_C(0xEEAABA2E5DBF6784), UINT64_C(0x95BA2A53F983CF38),
+            UINT64_C(0x952AB45CFA97A0B2), UINT64_C(0xDD945A747BF26183), UINT64_C(0xBA756174393D88DF), UINT64_C(0x94F971119AEEF9E4),
+            UINT64_C(0xE912B9D1478CEB17), UINT64_C(0x7A37CD5601AAB85D), UINT64_C(0x91ABB422CCB812EE), UINT64_C(0xAC62E055C10AB33A),
+            UINT64_C(0xB616A12B7FE617AA), UINT64_C(0x577B986B314D6009), UINT64_C(0xE39C49765FDF9D94), UINT64_C(0xED5A7E85FDA0B80B),
+            UINT64_C(0x8E41ADE9FBEBC27D), UINT64_C(0x14588F13BE847307), UINT64_C(0xB1D219647AE6B31C), UINT64_C(0x596EB2D8AE258FC8),
+            UINT64_C(0xDE469FBD99A05FE3), UINT64_C(0x6FCA5F8ED9AEF3BB), UINT64_C(0x8AEC23D680043BEE), UINT64_C(0x25DE7BB9480D5854),
+            UINT64_C(0xADA72CCC20054AE9), UINT64_C(0xAF561AA79A10AE6A), UINT64_C(0xD910F7FF28069DA4), UINT64_C(0x1B2BA1518094DA04),
+            UINT64_C(0x87AA9AFF79042286), UINT64_C(0x90FB44D2F05D0842), UINT64_C(0xA99541BF57452B28), UINT64_C(0x353A1607AC744A53),
+            UINT64_C(0xD3FA922F2D1675F2), UINT64_C(0x42889B8997915CE8), UINT64_C(0x847C9B5D7C2E09B7), UINT64_C(0x69956135FEBADA11),
+            UINT64_C(0xA59BC234DB398C25), UINT64_C(0x43FAB9837E699095), UINT64_C(0xCF02B2C21207EF2E), UINT64_C(0x94F967E45E03F4BB),
+            UINT64_C(0x8161AFB94B44F57D), UINT64_C(0x1D1BE0EEBAC278F5), UINT64_C(0xA1BA1BA79E1632DC), UINT64_C(0x6462D92A69731732),
+            UINT64_C(0xCA28A291859BBF93), UINT64_C(0x7D7B8F7503CFDCFE), UINT64_C(0xFCB2CB35E702AF78), UINT64_C(0x5CDA735244C3D43E),
+            UINT64_C(0x9DEFBF01B061ADAB), UINT64_C(0x3A0888136AFA64A7), UINT64_C(0xC56BAEC21C7A1916), UINT64_C(0x088AAA1845B8FDD0),
+            UINT64_C(0xF6C69A72A3989F5B), UINT64_C(0x8AAD549E57273D45), UINT64_C(0x9A3C2087A63F6399), UINT64_C(0x36AC54E2F678864B),
+            UINT64_C(0xC0CB28A98FCF3C7F), UINT64_C(0x84576A1BB416A7DD), UINT64_C(0xF0FDF2D3F3C30B9F), UINT64_C(0x656D44A2A11C51D5),
+            UINT64_C(0x969EB7C47859E743), UINT64_C(0x9F644AE5A4B1B325), UINT64_C(0xBC4665B596706114), UINT64_C(0x873D5D9F0DDE1FEE),
+            UINT64_C(0xEB57FF22FC0C7959), UINT64_C(0xA90CB506D155A7EA), UINT64_C(0x9316FF75DD87CBD8), UINT64_C(0x09A7F12442D588F2),
+            UINT64_C(0xB7DCBF5354E9BECE), UINT64_C(0x0C11ED6D538AEB2F), UINT64_C(0xE5D3EF282A242E81), UINT64_C(0x8F1668C8A86DA5FA),
+            UINT64_C(0x8FA475791A569D10), UINT64_C(0xF96E017D694487BC), UINT64_C(0xB38D92D760EC4455), UINT64_C(0x37C981DCC395A9AC),
+            UINT64_C(0xE070F78D3927556A), UINT64_C(0x85BBE253F47B1417), UINT64_C(0x8C469AB843B89562), UINT64_C(0x93956D7478CCEC8E),
+            UINT64_C(0xAF58416654A6BABB), UINT64_C(0x387AC8D1970027B2), UINT64_C(0xDB2E51BFE9D0696A), UINT64_C(0x06997B05FCC0319E),
+            UINT64_C(0x88FCF317F22241E2), UINT64_C(0x441FECE3BDF81F03), UINT64_C(0xAB3C2FDDEEAAD25A), UINT64_C(0xD527E81CAD7626C3),
+            UINT64_C(0xD60B3BD56A5586F1), UINT64_C(0x8A71E223D8D3B074), UINT64_C(0x85C7056562757456), UINT64_C(0xF6872D5667844E49),
+            UINT64_C(0xA738C6BEBB12D16C), UINT64_C(0xB428F8AC016561DB), UINT64_C(0xD106F86E69D785C7), UINT64_C(0xE13336D701BEBA52),
+            UINT64_C(0x82A45B450226B39C), UINT64_C(0xECC0024661173473), UINT64_C(0xA34D721642B06084), UINT64_C(0x27F002D7F95D0190),
+            UINT64_C(0xCC20CE9BD35C78A5), UINT64_C(0x31EC038DF7B441F4), UINT64_C(0xFF290242C83396CE), UINT64_C(0x7E67047175A15271),
+            UINT64_C(0x9F79A169BD203E41), UINT64_C(0x0F0062C6E984D386), UINT64_C(0xC75809C42C684DD1), UINT64_C(0x52C07B78A3E60868),
+            UINT64_C(0xF92E0C3537826145), UINT64_C(0xA7709A56CCDF8A82), UINT64_C(0x9BBCC7A142B17CCB), UINT64_C(0x88A66076400BB691),
+            UINT64_C(0xC2ABF989935DDBFE), UINT64_C(0x6ACFF893D00EA435), UINT64_C(0xF356F7EBF83552FE), UINT64_C(0x0583F6B8C4124D43),
+            UINT64_C(0x98165AF37B2153DE), UINT64_C(0xC3727A337A8B704A), UINT64_C(0xBE1BF1B059E9A8D6), UINT64_C(0x744F18C0592E4C5C),
+            UINT64_C(0xEDA2EE1C7064130C), UINT64_C(0x1162DEF06F79DF73), UINT64_C(0x9485D4D1C63E8BE7), UINT64_C(0x8ADDCB5645AC2BA8),
+            UINT64_C(0xB9A74A0637CE2EE1), UINT64_C(0x6D953E2BD7173692), UINT64_C(0xE8111C87C5C1BA99), UINT64_C(0xC8FA8DB6CCDD0437),
+            UINT64_C(0x910AB1D4DB9914A0), UINT64_C(0x1D9C9892400A22A2), UINT64_C(0xB54D5E4A127F59C8), UINT64_C(0x2503BEB6D00CAB4B),
+            UINT64_C(0xE2A0B5DC971F303A), UINT64_C(0x2E44AE64840FD61D), UINT64_C(0x8DA471A9DE737E24), UINT64_C(0x5CEAECFED289E5D2),
+            UINT64_C(0xB10D8E1456105DAD), UINT64_C(0x7425A83E872C5F47), UINT64_C(0xDD50F1996B947518), UINT64_C(0xD12F124E28F77719),
+            UINT64_C(0x8A5296FFE33CC92F), UINT64_C(0x82BD6B70D99AAA6F), UINT64_C(0xACE73CBFDC0BFB7B), UINT64_C(0x636CC64D1001550B),
+            UINT64_C(0xD8210BEFD30EFA5A), UINT64_C(0x3C47F7E05401AA4E), UINT64_C(0x8714A775E3E95C78), UINT64_C(0x65ACFAEC34810A71),
+            UINT64_C(0xA8D9D1535CE3B396), UINT64_C(0x7F1839A741A14D0D), UINT64_C(0xD31045A8341CA07C), UINT64_C(0x1EDE48111209A050),
+            UINT64_C(0x83EA2B892091E44D), UINT64_C(0x934AED0AAB460432), UINT64_C(0xA4E4B66B68B65D60), UINT64_C(0xF81DA84D5617853F),
+            UINT64_C(0xCE1DE40642E3F4B9), UINT64_C(0x36251260AB9D668E), UINT64_C(0x80D2AE83E9CE78F3), UINT64_C(0xC1D72B7C6B426019),
+            UINT64_C(0xA1075A24E4421730), UINT64_C(0xB24CF65B8612F81F), UINT64_C(0xC94930AE1D529CFC), UINT64_C(0xDEE033F26797B627),
+            UINT64_C(0xFB9B7CD9A4A7443C), UINT64_C(0x169840EF017DA3B1), UINT64_C(0x9D412E0806E88AA5), UINT64_C(0x8E1F289560EE864E),
+            UINT64_C(0xC491798A08A2AD4E), UINT64_C(0xF1A6F2BAB92A27E2), UINT64_C(0xF5B5D7EC8ACB58A2), UINT64_C(0xAE10AF696774B1DB),
+            UINT64_C(0x9991A6F3D6BF1765), UINT64_C(0xACCA6DA1E0A8EF29), UINT64_C(0xBFF610B0CC6EDD3F), UINT64_C(0x17FD090A58D32AF3),
+            UINT64_C(0xEFF394DCFF8A948E), UINT64_C(0xDDFC4B4CEF07F5B0), UINT64_C(0x95F83D0A1FB69CD9), UINT64_C(0x4ABDAF101564F98E),
+            UINT64_C(0xBB764C4CA7A4440F), UINT64_C(0x9D6D1AD41ABE37F1), UINT64_C(0xEA53DF5FD18D5513), UINT64_C(0x84C86189216DC5ED),
+            UINT64_C(0x92746B9BE2F8552C), UINT64_C(0x32FD3CF5B4E49BB4), UINT64_C(0xB7118682DBB66A77), UINT64_C(0x3FBC8C33221DC2A1),
+            UINT64_C(0xE4D5E82392A40515), UINT64_C(0x0FABAF3FEAA5334A), UINT64_C(0x8F05B1163BA6832D), UINT64_C(0x29CB4D87F2A7400E),
+            UINT64_C(0xB2C71D5BCA9023F8), UINT64_C(0x743E20E9EF511012), UINT64_C(0xDF78E4B2BD342CF6), UINT64_C(0x914DA9246B255416),
+            UINT64_C(0x8BAB8EEFB6409C1A), UINT64_C(0x1AD089B6C2F7548E), UINT64_C(0xAE9672ABA3D0C320), UINT64_C(0xA184AC2473B529B1),
+            UINT64_C(0xDA3C0F568CC4F3E8), UINT64_C(0xC9E5D72D90A2741E), UINT64_C(0x8865899617FB1871), UINT64_C(0x7E2FA67C7A658892),
+            UINT64_C(0xAA7EEBFB9DF9DE8D), UINT64_C(0xDDBB901B98FEEAB7), UINT64_C(0xD51EA6FA85785631), UINT64_C(0x552A74227F3EA565),
+            UINT64_C(0x8533285C936B35DE), UINT64_C(0xD53A88958F87275F), UINT64_C(0xA67FF273B8460356), UINT64_C(0x8A892ABAF368F137),
+            UINT64_C(0xD01FEF10A657842C), UINT64_C(0x2D2B7569B0432D85), UINT64_C(0x8213F56A67F6B29B), UINT64_C(0x9C3B29620E29FC73),
+            UINT64_C(0xA298F2C501F45F42), UINT64_C(0x8349F3BA91B47B8F), UINT64_C(0xCB3F2F7642717713), UINT64_C(0x241C70A936219A73),
+            UINT64_C(0xFE0EFB53D30DD4D7), UINT64_C(0xED238CD383AA0110), UINT64_C(0x9EC95D1463E8A506), UINT64_C(0xF4363804324A40AA),
+            UINT64_C(0xC67BB4597CE2CE48), UINT64_C(0xB143C6053EDCD0D5), UINT64_C(0xF81AA16FDC1B81DA), UINT64_C(0xDD94B7868E94050A),
+            UINT64_C(0x9B10A4E5E9913128), UINT64_C(0xCA7CF2B4191C8326), UINT64_C(0xC1D4CE1F63F57D72), UINT64_C(0xFD1C2F611F63A3F0),
+            UINT64_C(0xF24A01A73CF2DCCF), UINT64_C(0xBC633B39673C8CEC), UINT64_C(0x976E41088617CA01), UINT64_C(0xD5BE0503E085D813),
+            UINT64_C(0xBD49D14AA79DBC82), UINT64_C(0x4B2D8644D8A74E18), UINT64_C(0xEC9C459D51852BA2), UINT64_C(0xDDF8E7D60ED1219E),
+            UINT64_C(0x93E1AB8252F33B45), UINT64_C(0xCABB90E5C942B503), UINT64_C(0xB8DA1662E7B00A17), UINT64_C(0x3D6A751F3B936243),
+            UINT64_C(0xE7109BFBA19C0C9D), UINT64_C(0x0CC512670A783AD4), UINT64_C(0x906A617D450187E2), UINT64_C(0x27FB2B80668B24C5),
+            UINT64_C(0xB484F9DC9641E9DA), UINT64_C(0xB1F9F660802DEDF6), UINT64_C(0xE1A63853BBD26451), UINT64_C(0x5E7873F8A0396973),
+            UINT64_C(0x8D07E33455637EB2), UINT64_C(0xDB0B487B6423E1E8), UINT64_C(0xB049DC016ABC5E5F), UINT64_C(0x91CE1A9A3D2CDA62),
+            UINT64_C(0xDC5C5301C56B75F7), UINT64_C(0x7641A140CC7810FB), UINT64_C(0x89B9B3E11B6329BA), UINT64_C(0xA9E904C87FCB0A9D),
+            UINT64_C(0xAC2820D9623BF429), UINT64_C(0x546345FA9FBDCD44), UINT64_C(0xD732290FBACAF133), UINT64_C(0xA97C177947AD4095),
+            UINT64_C(0x867F59A9D4BED6C0), UINT64_C(0x49ED8EABCCCC485D), UINT64_C(0xA81F301449EE8C70), UINT64_C(0x5C68F256BFFF5A74),
+            UINT64_C(0xD226FC195C6A2F8C), UINT64_C(0x73832EEC6FFF3111), UINT64_C(0x83585D8FD9C25DB7), UINT64_C(0xC831FD53C5FF7EAB),
+            UINT64_C(0xA42E74F3D032F525), UINT64_C(0xBA3E7CA8B77F5E55), UINT64_C(0xCD3A1230C43FB26F), UINT64_C(0x28CE1BD2E55F35EB),
+            UINT64_C(0x80444B5E7AA7CF85), UINT64_C(0x7980D163CF5B81B3), UINT64_C(0xA0555E361951C366), UINT64_C(0xD7E105BCC332621F),
+            UINT64_C(0xC86AB5C39FA63440), UINT64_C(0x8DD9472BF3FEFAA7), UINT64_C(0xFA856334878FC150), UINT64_C(0xB14F98F6F0FEB951),
+            UINT64_C(0x9C935E00D4B9D8D2), UINT64_C(0x6ED1BF9A569F33D3), UINT64_C(0xC3B8358109E84F07), UINT64_C(0x0A862F80EC4700C8),
+            UINT64_C(0xF4A642E14C6262C8), UINT64_C(0xCD27BB612758C0FA), UINT64_C(0x98E7E9CCCFBD7DBD), UINT64_C(0x8038D51CB897789C),
+            UINT64_C(0xBF21E44003ACDD2C), UINT64_C(0xE0470A63E6BD56C3), UINT64_C(0xEEEA5D5004981478), UINT64_C(0x1858CCFCE06CAC74),
+            UINT64_C(0x95527A5202DF0CCB), UINT64_C(0x0F37801E0C43EBC8), UINT64_C(0xBAA718E68396CFFD), UINT64_C(0xD30560258F54E6BA),
+            UINT64_C(0xE950DF20247C83FD), UINT64_C(0x47C6B82EF32A2069), UINT64_C(0x91D28B7416CDD27E), UINT64_C(0x4CDC331D57FA5441),
+            UINT64_C(0xB6472E511C81471D), UINT64_C(0xE0133FE4ADF8E952), UINT64_C(0xE3D8F9E563A198E5), UINT64_C(0x58180FDDD97723A6),
+            UINT64_C(0x8E679C2F5E44FF8F), UINT64_C(0x570F09EAA7EA7648)
+        };
+
+        int mant_bits = single ? FLT_MANT_DIG - 1 : DBL_MANT_DIG - 1;
+        int bias = single ? 127 : 1023;
+        int inf_exp = single ? 0xFF : 0x7FF;
+        uint64_t mant = 0;
+        int exp2 = 0;
+
+        if (w == 0 || q < -342) {
+            return 0;
+        }
+
+        if (q > 308) {
+            return HUGE_VAL;
+        }
+
+        int lz = NPK_clz64_(w);
+        const uint64_t *p = pow5 + 2 * (q + 342);
+        uint64_t hi;
+        uint64_t lo;
+
+        w <<= lz;
+        lo = NPK_mul128_(w, p[0], &hi);
+
+        // The low half of the power only matters when the bits below the mantissa and its rounding bit are all ones
+        if ((hi & (UINT64_MAX >> (mant_bits + 3))) == (UINT64_MAX >> (mant_bits + 3))) {
+            uint64_t hi2;
+
+            NPK_mul128_(w, p[1], &hi2);
+            lo += hi2;
+            hi += lo < hi2;
+        }
+
+        int upper = NPK_cast(int, hi >> 63);
+        int shift = upper + 64 - mant_bits - 3;
+
+        mant = hi >> shift;
+
+        // floor(q * log2(10)) + 63, the division rounds toward negative infinity
+        exp2 = NPK_cast(int, (NPK_cast(int64_t, q) * 217706 - (q < 0 ? 65535 : 0)) / 65536) + 63 + upper - lz + bias;
+
+        if (exp2 <= 0) {
+            if (-exp2 + 1 >= 64) {
+                return 0;
+            }
+
+            // Subnormals can't be ties, the rounding carry decides if the number becomes normal again
+            mant >>= -exp2 + 1;
+            mant += mant & 1;
+            mant >>= 1;
+            exp2 = mant < (UINT64_C(1) << mant_bits) ? 0 : 1;
+        } else {
+            // Only products of powers of five that fit in 64 bits can fall exactly between two numbers
+            if (lo <= 1 && q >= (single ? -17 : -4) && q <= (single ? 10 : 23) && (mant & 3) == 1 && (mant << shift) == hi) {
+                mant &= ~UINT64_C(1);
+            }
+
+            mant += mant & 1;
+            mant >>= 1;
+
+            if (mant >= (UINT64_C(2) << mant_bits)) {
+                mant = UINT64_C(1) << mant_bits;
+                exp2++;
+            }
+
+            mant &= ~(UINT64_C(1) << mant_bits);
+
+            if (exp2 >= inf_exp) {
+                return HUGE_VAL;
+            }
+        }
+
+        if (single) {
+            uint32_t bits = NPK_cast(uint32_t, mant | NPK_cast(uint64_t, exp2) << mant_bits);
+            float f;
+
+            memcpy(&f, &bits, sizeof f);
+
+            return f;
+        }
+
+        uint64_t bits = mant | NPK_cast(uint64_t, exp2) << mant_bits;
+        double d;
+
+        memcpy(&d, &bits, sizeof d);
+
+        return d;
+    }
+
+    NPK_parse_result NPK_parse_real_(const char *s, int len, double *val, bool single) {
+        NPK_parse_result res = {NPK_parse_invalid, 0};
+        bool negative = false;
+        bool digits = false;
+        bool truncated = false;
+        uint64_t m = 0;
+        int nd = 0;
+        int exp10 = 0;
+        int i = 0;
+
+        while (i < len && NPK_char_is_blank(s[i])) {
+            i++;
+        }
+
+        int begin = i;
+
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            negative = s[i] == '-';
+            i++;
+        }
+
+        if (i < len && (s[i] == 'i' || s[i] == 'I' || s[i] == 'n' || s[i] == 'N')) {
+            double special;
+
+            if (len - i >= 8 && NPK_ascii_mismatch_nocase_(s + i, "infinity", 8) == 8) {
+                special = INFINITY;
+                i += 8;
+            } else if (len - i >= 3 && NPK_ascii_mismatch_nocase_(s + i, "inf", 3) == 3) {
+                special = INFINITY;
+                i += 3;
+            } else if (len - i >= 3 && NPK_ascii_mismatch_nocase_(s + i, "nan", 3) == 3) {
+                special = NAN;
+                i += 3;
+            } else {
+                return res;
+            }
+
+            *val = negative ? -special : special;
+            res.error = NPK_parse_ok;
+            res.end = i;
+
+            return res;
+        }
+
+        // The first 19 significant digits always fit in the mantissa "m", the rest only move the exponent
+        #define add_digit(d, frac)                  \
+        if (m == 0 && d == 0) {                     \
+            exp10 -= frac;                          \
+        } else if (nd < 19) {                       \
+            m = m * 10 + d;                         \
+            nd++;                                   \
+            exp10 -= frac;                          \
+        } else {                                    \
+            exp10 += !frac;                         \
+            truncated |= d != 0;                    \
+        }
+
+        #if defined NPK_LITTLE_ENDIAN_
+            #define add_eight_digits(frac)                                      \
+            if (nd > 0 && nd + 8 <= 19 && i + 8 <= len) {                       \
+                uint64_t w;                                                     \
+                                                                                \
+                memcpy(&w, s + i, 8);                                           \
+                                                                                \
+                if (swar_in_range(w, '0', '9') == swar_high) {                  \
+                    m = m * 100000000 + NPK_parse_eight_digits_(w);             \
+                    nd += 8;                                                    \
+                    exp10 -= 8 * frac;                                          \
+                    i += 8;                                                     \
+                    continue;                                                   \
+                }                                                               \
+            }
+        #else
+            #define add_eight_digits(frac)
+        #endif
+
+        while (i < len && NPK_char_is_digit(s[i])) {
+            digits = true;
+            add_eight_digits(0)
+
+            int d = s[i] - '0';
+
+            add_digit(d, 0)
+            i++;
+        }
+
+        if (i < len && s[i] == '.') {
+            i++;
+
+            while (i < len && NPK_char_is_digit(s[i])) {
+                digits = true;
+                add_eight_digits(1)
+
+                int d = s[i] - '0';
+
+                add_digit(d, 1)
+                i++;
+            }
+        }
+
+        #undef add_digit
+        #undef add_eight_digits
+
+        if (digits == false) {
+            return res;
+        }
+
+        if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+            int j = i + 1;
+            bool eneg = false;
+
+            if (j < len && (s[j] == '+' || s[j] == '-')) {
+                eneg = s[j] == '-';
+                j++;
+            }
+
+            if (j < len && NPK_char_is_digit(s[j])) {
+                int e = 0;
+
+                for (; j < len && NPK_char_is_digit(s[j]); j++) {
+                    if (e < 100000) {
+                        e = e * 10 + (s[j] - '0');
+                    }
+                }
+
+                exp10 += eneg ? -e : e;
+                i = j;
+            }
+        }
+
+        res.error = NPK_parse_ok;
+        res.end = i;
+
+        if (m == 0) {
+            *val = negative ? -0.0 : 0.0;
+
+            return res;
+        }
+
+        // Clinger's fast path, both the mantissa and the power of ten are exact, so a single operation rounds correctly
+        if (truncated == false) {
+            #if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+                const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+            #endif
+
+            #if FLT_EVAL_METHOD == 0
+                if (single && m <= (UINT64_C(1) << 24) && exp10 >= -10 && exp10 <= 10) {
+                    float f = m;
+                    float p = pow10[exp10 < 0 ? -exp10 : exp10];
+
+                    f = exp10 < 0 ? f / p : f * p;
+                    *val = negative ? -f : f;
+
+                    return res;
+                }
+            #endif
+
+            #if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+                // Extra powers of ten can move into the mantissa as long as it stays exact
+                while (single == false && exp10 > 22 && m <= (UINT64_C(1) << 53) / 10) {
+                    m *= 10;
+                    exp10--;
+                }
+
+                if (single == false && m <= (UINT64_C(1) << 53) && exp10 >= -22 && exp10 <= 22) {
+                    double d = m;
+
+                    d = exp10 < 0 ? d / pow10[-exp10] : d * pow10[exp10];
+                    *val = negative ? -d : d;
+
+                    return res;
+                }
+            #endif
+        }
+
+        // With all the digits in "m" Eisel-Lemire is exact, otherwise it is only trusted when "m" and the next number
+        // round the same way, the remaining cases are converted digit by digit, which unlike strtod always reads '.' as
+        // the decimal point whatever the locale
+        double x = NPK_eisel_lemire_(m, exp10, single);
+
+        if (truncated == false || x == NPK_eisel_lemire_(m + 1, exp10, single)) {
+            *val = negative ? -x : x;
+        } else if (single) {
+            *val = NPK_parse_decimal_(s + begin, res.end - begin, FLT_MANT_DIG, FLT_MIN_EXP, FLT_MAX_EXP);
+        } else {
+            *val = NPK_parse_decimal_(s + begin, res.end - begin, DBL_MANT_DIG, DBL_MIN_EXP, DBL_MAX_EXP);
+        }
+
+        if (isinf(*val)) {
+            res.error = NPK_parse_overflow;
+        }
+
+        return res;
+    }
+
+    NPK_parse_result NPK_string_parse_int64(const NPK_string *str, int idx, int64_t *val) {
+        NPK_parse_result res = NPK_parse_int64_(NPK_string_data(str) + idx, NPK_string_length(str) - idx, val);
+
+        res.end += idx;
+
+        return res;
+    }
+
+    NPK_parse_result NPK_string_parse_uint64(const NPK_string *str, int idx, uint64_t *val) {
+        NPK_parse_result res = NPK_parse_uint64_(NPK_string_data(str) + idx, NPK_string_length(str) - idx, val);
+
+        res.end += idx;
+
+        return res;
+    }
+
+    NPK_parse_result NPK_string_parse_dbl(const NPK_string *str, int idx, double *val) {
+        NPK_parse_result res = NPK_parse_real_(NPK_string_data(str) + idx, NPK_string_length(str) - idx, val, false);
+
+        res.end += idx;
+
+        return res;
+    }
+
+    #define parse_dbl(s, len, val) NPK_parse_real_(s, len, val, false)
+
+    #define strings_to(type, name, parse)                                           \
+    NPK_array NPK_strings_to_##name##_new(const NPK_array *strs, int *errors) {     \
+        NPK_array vals = NPK_array_sized_new(type, NPK_array_length(strs) + 2);     \
+        int bad = 0;                                                                \
+                                                                                    \
+        NPK_count_up (i, 0, NPK_array_length(strs)) {                               \
+            const NPK_string *str = NPK_array_data(NPK_string, strs) + i;           \
+            const char *s = str->data;                                              \
+            int len = NPK_string_length(str);                                       \
+            type *val = NPK_array_data(type, &vals) + i;                            \
+            NPK_parse_result res = parse(s, len, val);                              \
+                                                                                    \
+            while (res.end < len && NPK_char_is_blank(s[res.end])) {                \
+                res.end++;                                                          \
+            }                                                                       \
+                                                                                    \
+            if (res.error != NPK_parse_ok || res.end != len) {                      \
+                *val = 0;                                                           \
+                bad++;                                                              \
+            }                                                                       \
+        }                                                                           \
+                                                                                    \
+        vals.len = NPK_array_length(strs);                                          \
+                                                                                    \
+        if (errors != NULL) {                                                       \
+            *errors = bad;                                                          \
+        }                                                                           \
+                                                                                    \
+        return vals;                                                                \
+    }
+
+    strings_to(int64_t, int64, NPK_parse_int64_)
+    strings_to(uint64_t, uint64, NPK_parse_uint64_)
+    strings_to(double, dbl, parse_dbl)
+
+    #undef strings_to
+    #undef parse_dbl
+
+    // Out of range values are saturated and invalid strings result in 0
+    #define from_unsigned(type, name, max)                  \
+    type NPK_string_to_##name(const NPK_string *str) {      \
+        uint64_t val = 0;                                   \
+                                                            \
+        NPK_string_parse_uint64(str, 0, &val);              \
+                                                            \
+        return val <= max ? val : max;                      \
+    }
+
+    #define from_signed(type, name, min, max)               \
+    type NPK_string_to_##name(const NPK_string *str) {      \
+        int64_t val = 0;                                    \
+                                                            \
+        NPK_string_parse_int64(str, 0, &val);               \
+                                                            \
+        return val < min ? min : val <= max ? val : max;    \
+    }
+
+    from_unsigned(unsigned char, uchar, UCHAR_MAX)
+    from_unsigned(unsigned short, ushrt, USHRT_MAX)
+    from_unsigned(unsigned int, uint, UINT_MAX)
+    from_unsigned(unsigned long, ulong, ULONG_MAX)
+    from_unsigned(unsigned long long, ullong, ULLONG_MAX)
+
+    from_signed(signed char, schar, SCHAR_MIN, SCHAR_MAX)
+    from_signed(short, shrt, SHRT_MIN, SHRT_MAX)
+    from_signed(int, int, INT_MIN, INT_MAX)
+    from_signed(long, long, LONG_MIN, LONG_MAX)
+    from_signed(long long, llong, LLONG_MIN, LLONG_MAX)
+
+    from_unsigned(uint8_t, uint8, UINT8_MAX)
+    from_unsigned(uint16_t, uint16, UINT16_MAX)
+    from_unsigned(uint32_t, uint32, UINT32_MAX)
+    from_unsigned(uint64_t, uint64, UINT64_MAX)
+
+    from_signed(int8_t, int8, INT8_MIN, INT8_MAX)
+    from_signed(int16_t, int16, INT16_MIN, INT16_MAX)
+    from_signed(int32_t, int32, INT32_MIN, INT32_MAX)
+    from_signed(int64_t, int64, INT64_MIN, INT64_MAX)
+
+    #undef from_unsigned
+    #undef from_signed
+
+    float NPK_string_to_flt(const NPK_string *str) {
+        double val = 0;
+
+        NPK_parse_real_(str->data, NPK_string_length(str), &val, true);
+
+        return val;
+    }
+
+    double NPK_string_to_dbl(const NPK_string *str) {
+        double val = 0;
+
+        NPK_string_parse_dbl(str, 0, &val);
+
+        return val;
+    }
+
+    long double NPK_string_to_ldbl(const NPK_string *str) {
+        double val = 0;
+        NPK_parse_result res = NPK_parse_real_(str->data, NPK_string_length(str), &val, false);
+
+        // Invalid input, infinities and NaNs are the same in every precision, any other number is converted again in full
+        if (res.error == NPK_parse_invalid || isnan(val) || (isinf(val) && res.error == NPK_parse_ok)) {
+            return val;
+        }
+
+        return NPK_parse_decimal_(str->data, res.end, LDBL_MANT_DIG, LDBL_MIN_EXP, LDBL_MAX_EXP);
+    }
 
-    #define from_string(type, name, format)             \
-    type NPK_string_to_##name(const NPK_string *str) {  \
-        type val;                                       \
-                                                        \
-        sscanf(str->data, format, &val);                \
-                                                        \
-        return val;                                     \
-    }
-
-    from_string(unsigned char, uchar, "%hhu")
-    from_string(unsigned short, ushrt, "%hu")
-    from_string(unsigned int, uint, "%u")
-    from_string(unsigned long, ulong, "%lu")
-    from_string(unsigned long long, ullong, "%llu")
-
-    from_string(signed char, schar, "%hhi")
-    from_string(short, shrt, "%hi")
-    from_string(int, int, "%i")
-    from_string(long, long, "%li")
-    from_string(long long, llong, "%lli")
-
-    from_string(float, flt, "%f")
-    from_string(double, dbl, "%lf")
-    from_string(long double, ldbl, "%Lf")
-
-    from_string(uint8_t, uint8, "%"SCNu8)
-    from_string(uint16_t, uint16, "%"SCNu16)
-    from_string(uint32_t, uint32, "%"SCNu32)
-    from_string(uint64_t, uint64, "%"SCNu64)
-
-    from_string(int8_t, int8, "%"SCNi8)
-    from_string(int16_t, int16, "%"SCNi16)
-    from_string(int32_t, int32, "%"SCNi32)
-    from_string(int64_t, int64, "%"SCNi64)
-
-    #undef from_string
+    #undef swar_ones
+    #undef swar_high
+    #undef swar_in_range
+    #undef sse2_in_range
+    #undef avx2_in_range
+    #undef char_fold
 #endif
\ No newline at end of file
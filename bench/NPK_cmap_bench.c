@@ -0,0 +1,139 @@
+// Measures NPK_cmap against an NPK_map behind one global mutex, with several threads and read/write ratios
+// Build: make (from the root of the repository), or cc -std=gnu11 -O2 -I.. NPK_cmap_bench.c -o NPK_cmap_bench -lm -lpthread
+// Usage: ./NPK_cmap_bench [max threads]
+
+#define NPK_DS_IMPL
+#include "NPK_ds.h"
+
+#include <time.h>
+
+#define KEY_COUNT (1 << 16)
+#define OPS_PER_THREAD 1000000
+
+typedef struct {
+    NPK_cmap *cm;
+    NPK_map *m;
+    mtx_t *lock;
+    int *keys;
+    int read_percent;
+    uint64_t seed;
+} bench_args;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static int run_cmap(void *p) {
+    bench_args *args = p;
+    uint64_t state = args->seed;
+    int val = 0;
+
+    NPK_count_up (i, 0, OPS_PER_THREAD) {
+        uint64_t r = next_random(&state);
+        int *key = args->keys + (r >> 16) % KEY_COUNT;
+
+        if (NPK_cast(int, r % 100) < args->read_percent) {
+            NPK_cmap_get(args->cm, key, &val);
+        } else if (r & 0x100) {
+            NPK_cmap_add(int, args->cm, key, i);
+        } else {
+            NPK_cmap_remove(args->cm, key);
+        }
+    }
+
+    return val;
+}
+
+static int run_locked_map(void *p) {
+    bench_args *args = p;
+    uint64_t state = args->seed;
+    int val = 0;
+
+    NPK_count_up (i, 0, OPS_PER_THREAD) {
+        uint64_t r = next_random(&state);
+        int *key = args->keys + (r >> 16) % KEY_COUNT;
+
+        mtx_lock(args->lock);
+
+        if (NPK_cast(int, r % 100) < args->read_percent) {
+            int *cur = NPK_map_get(int, args->m, key);
+
+            val = cur != NULL ? *cur : val;
+        } else if (r & 0x100) {
+            NPK_map_add(int, args->m, key, i);
+        } else {
+            NPK_map_erase_(NPK_sizeof_type(int), args->m, key);
+        }
+
+        mtx_unlock(args->lock);
+    }
+
+    return val;
+}
+
+static double run(int (*fn)(void *), bench_args *base, int threads) {
+    thrd_t ids[64];
+    bench_args args[64];
+    double start = now();
+
+    NPK_count_up (i, 0, threads) {
+        args[i] = *base;
+        args[i].seed = 0x9E3779B97F4A7C15u * (i + 1);
+        thrd_create(&ids[i], fn, &args[i]);
+    }
+
+    NPK_count_up (i, 0, threads) {
+        thrd_join(ids[i], NULL);
+    }
+
+    return threads * NPK_cast(double, OPS_PER_THREAD) / (now() - start);
+}
+
+int main(int argc, char **argv) {
+    static int keys[KEY_COUNT];
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    int read_percents[] = {100, 90, 50};
+
+    max_threads = max_threads < 1 ? 1 : max_threads > 64 ? 64 : max_threads;
+    printf("%-8s %-6s %16s %16s\n", "threads", "read%", "cmap ops/s", "mutex map ops/s");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        NPK_count_up (r, 0, NPK_cast(int, sizeof read_percents / sizeof *read_percents)) {
+            NPK_cmap cm = NPK_cmap_new(int);
+            NPK_map m = NPK_map_new(int);
+            mtx_t lock;
+
+            mtx_init(&lock, mtx_plain);
+
+            // Half of the keys exist up front, so reads both hit and miss
+            NPK_count_up (i, 0, KEY_COUNT / 2) {
+                NPK_cmap_add(int, &cm, keys + 2 * i, i);
+                NPK_map_add(int, &m, keys + 2 * i, i);
+            }
+
+            bench_args args = {&cm, &m, &lock, keys, read_percents[r], 0};
+            double cmap_rate = run(run_cmap, &args, threads);
+            double map_rate = run(run_locked_map, &args, threads);
+
+            printf("%-8d %-6d %16.0f %16.0f\n", threads, read_percents[r], cmap_rate, map_rate);
+
+            mtx_destroy(&lock);
+            NPK_map_del(&m);
+            NPK_cmap_del(&cm);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,700 @@
+// Times the core NPK_array, NPK_string, NPK_map and file operations for sizes from 1e2 up to 1e8 elements
+// Build: make (from the root of the repository), or cc -std=gnu11 -O2 -I.. NPK_ds_bench.c -o NPK_ds_bench -lm -lpthread
+// Usage: ./NPK_ds_bench [--max exponent] [--json path] [filter]
+// Every line reports elements per second and the percentiles of nanoseconds per element over several samples
+// An element is one call for add, get and parsing and one element visited for scans like contains, sort and replace
+
+#define NPK_DS_IMPL
+#include "NPK_ds.h"
+
+#include <time.h>
+
+#define TEMP_PATH "NPK_ds_bench.tmp"
+#define SHARD_COUNT 64
+#define SAMPLE_SECONDS 0.25
+#define MIN_SAMPLES 3
+#define MAX_SAMPLES 51
+
+typedef struct {
+    NPK_array arr;
+    NPK_array out;
+    NPK_string str;
+    NPK_map map;
+    NPK_btree tree;
+    NPK_radix radix;
+    NPK_csv csv;
+    NPK_bitset bits;
+    NPK_bitset mask;
+    int *keys;
+    int64_t sink;
+} bench_state;
+
+typedef struct {
+    const char *name;
+    int max_exponent;
+    void (*setup)(bench_state *s, int n);
+    void (*run)(bench_state *s, int n);
+    void (*teardown)(bench_state *s);
+} bench_case;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static int compare_dbl(const void *p1, const void *p2) {
+    double d1 = *NPK_cast(const double *, p1);
+    double d2 = *NPK_cast(const double *, p2);
+
+    return (d1 > d2) - (d1 < d2);
+}
+
+// Setups and teardowns, which are never timed
+
+static void setup_empty(bench_state *s, int n) {
+    (void) n;
+    memset(s, 0, sizeof *s);
+}
+
+static void setup_ints(bench_state *s, int n) {
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(int, n);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(int, &s->arr, NPK_cast(int, next_random(&state) % 100));
+    }
+}
+
+static void setup_string(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->str = NPK_string_sized_new(n + 1);
+
+    // Words of 7 characters and a comma, with "ab" once in every word
+    NPK_count_up (i, 0, n) {
+        NPK_string_add(&s->str, i % 8 == 7 ? ',' : "xxabxxx"[i % 8]);
+    }
+}
+
+// Mostly ASCII words with two, three and four byte UTF-8 sequences in between, 64 bytes per repetition
+static void setup_utf8_string(bench_state *s, int n) {
+    const char *text = "\xE6\x97\xA5\xE6\x9C\xAC na\xC3\xAFve caf\xC3\xA9 \xF0\x9F\x98\x80 with more words in plain ascii text...\n";
+
+    setup_empty(s, n);
+    s->str = NPK_string_sized_new(n + 1);
+
+    NPK_count_up (i, 0, n) {
+        NPK_string_add(&s->str, text[i % 64]);
+    }
+}
+
+static void setup_number_strings(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(NPK_string, n);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(NPK_string, &s->arr, NPK_int_to_string_new(i * 7919));
+    }
+}
+
+// Records of an integer, a word and a real number
+static void setup_csv(bench_state *s, int n) {
+    char line[64];
+
+    setup_empty(s, n);
+    s->str = NPK_string_sized_new(24 * n + 1);
+
+    NPK_count_up (i, 0, n) {
+        snprintf(line, sizeof line, "%d,w%d,%d.25\n", i, i, i);
+        NPK_string_append_n_(&s->str, line, strlen(line));
+    }
+}
+
+// A mask that is shorter than the bitset and ends in the middle of a word, so the bits past it must stay untouched
+static void setup_bitsets(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->bits = NPK_bitset_new(n);
+    s->mask = NPK_bitset_new(n - n / 4 - 3);
+    NPK_bitset_fill(&s->bits, true);
+
+    NPK_count_up (i, 0, NPK_bitset_length(&s->mask)) {
+        if (i % 3 != 0) {
+            NPK_bitset_set(&s->mask, i);
+        }
+    }
+}
+
+static void setup_radix(bench_state *s, int n) {
+    setup_number_strings(s, n);
+    s->radix = NPK_radix_new(int);
+
+    NPK_count_up (i, 0, n) {
+        NPK_radix_add(int, &s->radix, NPK_array_data(NPK_string, &s->arr) + i, i);
+    }
+}
+
+static void setup_empty_radix(bench_state *s, int n) {
+    setup_number_strings(s, n);
+    s->radix = NPK_radix_new(int);
+}
+
+static void setup_map(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->keys = malloc(2 * NPK_cast(size_t, n) * sizeof *s->keys);
+    s->map = NPK_map_new(int);
+
+    // Only the even keys are added, so the odd ones are misses
+    NPK_count_up (i, 0, n) {
+        NPK_map_add(int, &s->map, s->keys + 2 * i, i);
+    }
+}
+
+static void setup_keys(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->keys = malloc(2 * NPK_cast(size_t, n) * sizeof *s->keys);
+    s->map = NPK_map_new(int);
+}
+
+static void setup_map_batch(bench_state *s, int n) {
+    setup_map(s, n);
+    s->arr = NPK_array_sized_new(void *, n);
+    s->out = NPK_array_new(int *);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(void *, &s->arr, s->keys + 2 * i);
+    }
+}
+
+static void setup_keys_batch(bench_state *s, int n) {
+    setup_keys(s, n);
+    s->arr = NPK_array_sized_new(void *, n);
+    s->out = NPK_array_sized_new(int, n);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(void *, &s->arr, s->keys + 2 * i);
+        NPK_array_add(int, &s->out, i);
+    }
+}
+
+static void setup_tree(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(int64_t, n);
+
+    // Only the even keys are added, so that ranges skip over the odd ones
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(int64_t, &s->arr, 2 * NPK_cast(int64_t, i));
+    }
+
+    s->tree = NPK_btree_from_arrays_new(int64_t, int64_t, &s->arr, &s->arr, NPK_int64_asc);
+}
+
+static void setup_empty_tree(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->tree = NPK_btree_new(int64_t, int64_t, NPK_int64_asc);
+}
+
+static void setup_bytes_file(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(uint8_t, n);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(uint8_t, &s->arr, NPK_cast(uint8_t, i));
+    }
+
+    NPK_file_write_bytes(TEMP_PATH, &s->arr);
+}
+
+// The bytes are spread over SHARD_COUNT files, whose paths are kept in "arr"
+static void setup_shard_files(bench_state *s, int n) {
+    char path[64];
+
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(NPK_string, SHARD_COUNT);
+    s->out = NPK_array_sized_new(uint8_t, n / SHARD_COUNT + 1);
+
+    NPK_count_up (i, 0, n / SHARD_COUNT + 1) {
+        NPK_array_add(uint8_t, &s->out, NPK_cast(uint8_t, i));
+    }
+
+    NPK_count_up (i, 0, SHARD_COUNT) {
+        snprintf(path, sizeof path, "%s.%d", TEMP_PATH, i);
+        NPK_file_write_bytes(path, &s->out);
+        NPK_array_add(NPK_string, &s->arr, NPK_string_new(path));
+    }
+
+    NPK_array_del(&s->out);
+    s->out.data = NULL;
+}
+
+static void setup_lines_file(bench_state *s, int n) {
+    setup_empty(s, n);
+    s->arr = NPK_array_sized_new(NPK_string, n / 16 + 1);
+
+    // Lines of 15 characters and a newline
+    NPK_count_up (i, 0, n / 16 + 1) {
+        NPK_array_add(NPK_string, &s->arr, NPK_string_new("line of a file"));
+    }
+
+    NPK_file_write(TEMP_PATH, &s->arr);
+}
+
+static void teardown(bench_state *s) {
+    if (s->arr.data != NULL) {
+        NPK_array_del(&s->arr);
+    }
+
+    if (s->out.data != NULL) {
+        NPK_array_del(&s->out);
+    }
+
+    if (s->str.data != NULL) {
+        NPK_string_del(&s->str);
+    }
+
+    if (s->map.keys.data != NULL) {
+        NPK_map_del(&s->map);
+    }
+
+    if (s->tree.leaves.data != NULL) {
+        NPK_btree_del(&s->tree);
+    }
+
+    free(s->keys);
+}
+
+static void teardown_split(bench_state *s) {
+    NPK_array_dim_del(&s->out, 2);
+    s->out.data = NULL;
+    teardown(s);
+}
+
+static void teardown_strings(bench_state *s) {
+    if (s->arr.data != NULL) {
+        NPK_array_dim_del(&s->arr, 2);
+    }
+
+    if (s->out.data != NULL) {
+        NPK_array_dim_del(&s->out, 2);
+    }
+
+    if (s->str.data != NULL) {
+        NPK_string_del(&s->str);
+    }
+}
+
+static void teardown_radix(bench_state *s) {
+    NPK_radix_del(&s->radix);
+    teardown_strings(s);
+}
+
+static void teardown_csv(bench_state *s) {
+    NPK_csv_del(&s->csv);
+    teardown(s);
+}
+
+static void teardown_bitsets(bench_state *s) {
+    NPK_bitset_del(&s->bits);
+    NPK_bitset_del(&s->mask);
+    teardown(s);
+}
+
+static void teardown_file(bench_state *s) {
+    remove(TEMP_PATH);
+    teardown(s);
+}
+
+static void teardown_shard_files(bench_state *s) {
+    NPK_for_each (NPK_string, path, &s->arr) {
+        remove(NPK_string_data(path));
+    }
+
+    teardown_strings(s);
+}
+
+static void teardown_lines_file(bench_state *s) {
+    remove(TEMP_PATH);
+    teardown_strings(s);
+}
+
+// Timed operations
+
+static void run_array_add(bench_state *s, int n) {
+    s->arr = NPK_array_new(int);
+
+    NPK_count_up (i, 0, n) {
+        NPK_array_add(int, &s->arr, i);
+    }
+}
+
+static void run_array_contains(bench_state *s, int n) {
+    (void) n;
+    s->sink += NPK_array_contains(int, &s->arr, -1, NPK_int_equals);
+}
+
+static void run_array_remove(bench_state *s, int n) {
+    (void) n;
+    NPK_array_remove(int, &s->arr, 42, NPK_int_equals);
+}
+
+static void run_array_replace(bench_state *s, int n) {
+    (void) n;
+    NPK_array_replace(int, &s->arr, 42, 43, NPK_int_equals);
+}
+
+static void run_array_sort(bench_state *s, int n) {
+    (void) n;
+    NPK_array_sort(int, &s->arr, NPK_int_asc);
+}
+
+static void run_array_split(bench_state *s, int n) {
+    (void) n;
+    s->out = NPK_array_split_new(int, &s->arr, 42, NPK_int_equals);
+}
+
+static void run_string_add(bench_state *s, int n) {
+    s->str = NPK_string_new("");
+
+    NPK_count_up (i, 0, n) {
+        NPK_string_add(&s->str, 'a' + i % 26);
+    }
+}
+
+static void run_string_split(bench_state *s, int n) {
+    (void) n;
+    s->out = NPK_string_split_new(&s->str, ",");
+}
+
+static void run_string_is_utf8(bench_state *s, int n) {
+    (void) n;
+    s->sink += NPK_string_is_utf8(&s->str);
+}
+
+static void run_string_utf8_length(bench_state *s, int n) {
+    (void) n;
+    s->sink += NPK_string_utf8_length(&s->str);
+}
+
+static void run_string_replace(bench_state *s, int n) {
+    (void) n;
+    NPK_string_replace(&s->str, "ab", "xyz");
+}
+
+static void run_int_to_string(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        NPK_string str = NPK_int_to_string_new(i * 7919);
+
+        s->sink += NPK_string_length(&str);
+        NPK_string_del(&str);
+    }
+}
+
+static void run_dbl_to_string(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        NPK_string str = NPK_dbl_to_string_new(i * 0.1);
+
+        s->sink += NPK_string_length(&str);
+        NPK_string_del(&str);
+    }
+}
+
+static void run_string_to_int(bench_state *s, int n) {
+    (void) n;
+
+    NPK_for_each (NPK_string, str, &s->arr) {
+        s->sink += NPK_string_to_int(str);
+    }
+}
+
+static void run_string_to_dbl(bench_state *s, int n) {
+    (void) n;
+
+    NPK_for_each (NPK_string, str, &s->arr) {
+        s->sink += NPK_cast(int64_t, NPK_string_to_dbl(str));
+    }
+}
+
+static void run_map_add(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        NPK_map_add(int, &s->map, s->keys + 2 * i, i);
+    }
+}
+
+static void run_map_get_hit(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        s->sink += *NPK_map_get(int, &s->map, s->keys + 2 * i);
+    }
+}
+
+static void run_map_get_miss(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        s->sink += NPK_map_get(int, &s->map, s->keys + 2 * i + 1) != NULL;
+    }
+}
+
+static void run_map_remove(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        NPK_map_remove(&s->map, s->keys + 2 * i);
+    }
+}
+
+static void run_map_get_many(bench_state *s, int n) {
+    (void) n;
+    s->sink += NPK_map_get_many(int, &s->map, &s->arr, &s->out);
+}
+
+static void run_map_from_arrays(bench_state *s, int n) {
+    (void) n;
+    NPK_map_del(&s->map);
+    s->map = NPK_map_from_arrays_new(int, &s->arr, &s->out);
+}
+
+static void run_btree_add(bench_state *s, int n) {
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    NPK_count_up (i, 0, n) {
+        NPK_btree_add(int64_t, int64_t, &s->tree, NPK_cast(int64_t, next_random(&state) % (4 * NPK_cast(uint64_t, n))), i);
+    }
+}
+
+static void run_btree_get(bench_state *s, int n) {
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    NPK_count_up (i, 0, n) {
+        s->sink += *NPK_btree_get(int64_t, int64_t, &s->tree, 2 * NPK_cast(int64_t, next_random(&state) % n));
+    }
+}
+
+static void run_btree_range(bench_state *s, int n) {
+    NPK_btree_for_range (int64_t, cur, &s->tree, 0, 2 * NPK_cast(int64_t, n)) {
+        s->sink += *NPK_btree_cursor_value(int64_t, &cur);
+    }
+}
+
+static void run_btree_bulk_load(bench_state *s, int n) {
+    (void) n;
+    NPK_btree_del(&s->tree);
+    s->tree = NPK_btree_from_arrays_new(int64_t, int64_t, &s->arr, &s->arr, NPK_int64_asc);
+}
+
+static void run_radix_add(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        NPK_radix_add(int, &s->radix, NPK_array_data(NPK_string, &s->arr) + i, i);
+    }
+}
+
+static void run_radix_get(bench_state *s, int n) {
+    NPK_count_up (i, 0, n) {
+        s->sink += *NPK_radix_get(int, &s->radix, NPK_array_data(NPK_string, &s->arr) + i);
+    }
+}
+
+// Every key is visited in order, through a prefix that all of them share
+static void run_radix_prefix(bench_state *s, int n) {
+    NPK_string prefix = NPK_string_new("");
+    NPK_iter keys = NPK_radix_iter_prefix_new(&s->radix, &prefix);
+
+    (void) n;
+    s->sink += NPK_iter_count(&keys);
+    NPK_iter_del(&keys);
+    NPK_string_del(&prefix);
+}
+
+static void run_csv_parse(bench_state *s, int n) {
+    (void) n;
+    s->csv = NPK_csv_parse_new(NPK_string_data(&s->str), NPK_string_length(&s->str), "isd", ',', false, NULL);
+    s->sink += s->csv.errors;
+}
+
+static void run_bitset_and(bench_state *s, int n) {
+    (void) n;
+    NPK_bitset_and(&s->bits, &s->mask);
+    s->sink += NPK_bitset_words(&s->bits)[0];
+}
+
+static void run_file_write_bytes(bench_state *s, int n) {
+    (void) n;
+    NPK_file_write_bytes(TEMP_PATH, &s->arr);
+}
+
+static void run_file_read_bytes(bench_state *s, int n) {
+    (void) n;
+    s->out = NPK_file_read_bytes_new(TEMP_PATH);
+}
+
+static void run_file_write_lines(bench_state *s, int n) {
+    (void) n;
+    NPK_file_write(TEMP_PATH, &s->arr);
+}
+
+static void run_file_read_lines(bench_state *s, int n) {
+    (void) n;
+    s->out = NPK_file_read_new(TEMP_PATH);
+}
+
+static void run_iter_read_lines(bench_state *s, int n) {
+    NPK_iter lines = NPK_iter_lines_new(TEMP_PATH);
+
+    (void) n;
+    s->sink += NPK_iter_count(&lines);
+    NPK_iter_del(&lines);
+}
+
+static void run_aio_read_shards(bench_state *s, int n) {
+    NPK_aio aio = NPK_aio_new(0);
+
+    (void) n;
+    s->out = NPK_aio_read_all_new(&aio, &s->arr);
+    NPK_aio_del(&aio);
+}
+
+// Cases whose cost grows faster than linearly stop at a lower size
+static const bench_case cases[] = {
+    {"array_add", 8, setup_empty, run_array_add, teardown},
+    {"array_contains", 8, setup_ints, run_array_contains, teardown},
+    {"array_remove", 5, setup_ints, run_array_remove, teardown},
+    {"array_replace", 8, setup_ints, run_array_replace, teardown},
+    {"array_sort", 8, setup_ints, run_array_sort, teardown},
+    {"array_split", 7, setup_ints, run_array_split, teardown_split},
+    {"string_add", 8, setup_empty, run_string_add, teardown},
+    {"string_split", 7, setup_string, run_string_split, teardown_strings},
+    {"string_replace", 8, setup_string, run_string_replace, teardown},
+    {"string_is_utf8", 8, setup_utf8_string, run_string_is_utf8, teardown},
+    {"string_utf8_length", 8, setup_utf8_string, run_string_utf8_length, teardown},
+    {"int_to_string", 7, setup_empty, run_int_to_string, teardown},
+    {"dbl_to_string", 7, setup_empty, run_dbl_to_string, teardown},
+    {"string_to_int", 7, setup_number_strings, run_string_to_int, teardown_strings},
+    {"string_to_dbl", 7, setup_number_strings, run_string_to_dbl, teardown_strings},
+    {"map_add", 7, setup_keys, run_map_add, teardown},
+    {"map_get_hit", 7, setup_map, run_map_get_hit, teardown},
+    {"map_get_miss", 7, setup_map, run_map_get_miss, teardown},
+    {"map_remove", 7, setup_map, run_map_remove, teardown},
+    {"map_get_many", 7, setup_map_batch, run_map_get_many, teardown},
+    {"map_from_arrays", 7, setup_keys_batch, run_map_from_arrays, teardown},
+    {"btree_add", 7, setup_empty_tree, run_btree_add, teardown},
+    {"btree_get", 7, setup_tree, run_btree_get, teardown},
+    {"btree_range", 8, setup_tree, run_btree_range, teardown},
+    {"btree_bulk_load", 7, setup_tree, run_btree_bulk_load, teardown},
+    {"radix_add", 7, setup_empty_radix, run_radix_add, teardown_radix},
+    {"radix_get", 7, setup_radix, run_radix_get, teardown_radix},
+    {"radix_prefix", 7, setup_radix, run_radix_prefix, teardown_radix},
+    {"csv_parse", 7, setup_csv, run_csv_parse, teardown_csv},
+    {"bitset_and", 8, setup_bitsets, run_bitset_and, teardown_bitsets},
+    {"file_write_bytes", 8, setup_bytes_file, run_file_write_bytes, teardown_file},
+    {"file_read_bytes", 8, setup_bytes_file, run_file_read_bytes, teardown_file},
+    {"file_write_lines", 8, setup_lines_file, run_file_write_lines, teardown_lines_file},
+    {"file_read_lines", 8, setup_lines_file, run_file_read_lines, teardown_lines_file},
+    {"iter_read_lines", 8, setup_lines_file, run_iter_read_lines, teardown_lines_file},
+    {"aio_read_shards", 8, setup_shard_files, run_aio_read_shards, teardown_shard_files},
+};
+
+// Times one sample of a case, the setup and teardown are excluded
+static double sample(const bench_case *c, int n, int64_t *sink) {
+    bench_state s;
+    double start;
+    double elapsed;
+
+    c->setup(&s, n);
+    start = now();
+    c->run(&s, n);
+    elapsed = now() - start;
+    *sink += s.sink;
+    c->teardown(&s);
+
+    return elapsed;
+}
+
+static double percentile(const double *sorted, int len, double p) {
+    return sorted[NPK_cast(int, p * (len - 1) + 0.5)];
+}
+
+int main(int argc, char **argv) {
+    int max_exponent = 6;
+    const char *json_path = NULL;
+    const char *filter = NULL;
+    FILE *json = NULL;
+    bool first = true;
+    int64_t sink = 0;
+
+    NPK_count_up (i, 1, argc) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_exponent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    max_exponent = max_exponent < 2 ? 2 : max_exponent > 8 ? 8 : max_exponent;
+
+    if (json_path != NULL) {
+        json = fopen(json_path, "w");
+
+        if (json == NULL) {
+            fprintf(stderr, "cannot open %s\n", json_path);
+
+            return 1;
+        }
+
+        fprintf(json, "{\"benchmarks\": [");
+    }
+
+    printf("%-18s %10s %8s %14s %10s %10s %10s\n", "case", "n", "samples", "elements/s", "p50 ns", "p90 ns", "p99 ns");
+
+    NPK_count_up (c, 0, NPK_cast(int, sizeof cases / sizeof *cases)) {
+        if (filter != NULL && strstr(cases[c].name, filter) == NULL) {
+            continue;
+        }
+
+        int n = 100;
+
+        for (int e = 2; e <= max_exponent && e <= cases[c].max_exponent; e++, n *= 10) {
+            double ns[MAX_SAMPLES];
+
+            // The first sample warms up the allocator and the caches and sets the number of samples, but it is not reported
+            double first_time = sample(&cases[c], n, &sink);
+            int samples = first_time > 0 ? NPK_cast(int, SAMPLE_SECONDS / first_time) : MAX_SAMPLES;
+
+            samples = samples < MIN_SAMPLES ? MIN_SAMPLES : samples > MAX_SAMPLES ? MAX_SAMPLES : samples;
+
+            NPK_count_up (i, 0, samples) {
+                ns[i] = sample(&cases[c], n, &sink) * 1e9 / n;
+            }
+
+            qsort(ns, samples, sizeof *ns, compare_dbl);
+
+            double p50 = percentile(ns, samples, 0.5);
+            double p90 = percentile(ns, samples, 0.9);
+            double p99 = percentile(ns, samples, 0.99);
+
+            printf("%-18s %10d %8d %14.0f %10.2f %10.2f %10.2f\n", cases[c].name, n, samples, 1e9 / p50, p50, p90, p99);
+            fflush(stdout);
+
+            if (json != NULL) {
+                fprintf(json, "%s\n  {\"name\": \"%s\", \"n\": %d, \"samples\": %d, \"elements_per_sec\": %.1f, \"ns_p50\": %.3f, \"ns_p90\": %.3f, \"ns_p99\": %.3f}",
+                        first ? "" : ",", cases[c].name, n, samples, 1e9 / p50, p50, p90, p99);
+                first = false;
+            }
+        }
+    }
+
+    if (json != NULL) {
+        fprintf(json, "\n]}\n");
+        fclose(json);
+    }
+
+    // Keeps the results of the timed operations alive
+    return sink == 42 ? 2 : 0;
+}